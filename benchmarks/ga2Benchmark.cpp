@@ -0,0 +1,343 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Benchmark.cpp: benchmarks for the ga2 library.
+//
+// Build from this directory with something like
+//   g++ -O2 -std=c++11 -pthread -I.. ga2Benchmark.cpp ../*.cpp -o ga2Benchmark
+// and run as
+//   ga2Benchmark [--quick] [--seed n] > results.csv
+//
+// Two kinds of benchmark are run, and every result is written to standard
+// output as one CSV line, under a single header line:
+//
+//   landscape  A whole GA run on a standard test function (OneMax, Sphere,
+//              Rastrigin, Rosenbrock and a deceptive trap), reporting
+//              evaluations per second, the best fitness found and the time
+//              taken to reach a target fitness (-1 if it never did).
+//   operator   One phase of a generation (select, crossover, mutate, replace
+//              or evaluate) timed on its own, for every selection and
+//              replacement type over a range of population sizes and
+//              chromosome lengths, reporting chromosomes handled per second.
+//
+// Every fitness function is maximised, so the minimisation problems return
+// the negated cost and their targets are negative. Runs are seeded, so two
+// builds can be compared on identical work.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "ga2.h"
+
+static std::atomic<long> ga2BenchEvals(0);
+
+static double ga2BenchNow(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Test functions
+//////////////////////////////////////////////////////////////////////
+
+//number of genes that are (rounded to) one
+static double ga2OneMax(std::vector<ga2Gene> genes)
+{
+	++ga2BenchEvals;
+	double sum = 0.0;
+	int i;
+	for(i = 0; i < genes.size(); ++i)
+		sum += genes[i] >= 0.5f;
+	return sum;
+}
+
+static double ga2Sphere(std::vector<ga2Gene> genes)
+{
+	++ga2BenchEvals;
+	double sum = 0.0;
+	int i;
+	for(i = 0; i < genes.size(); ++i)
+		sum += (double)genes[i] * genes[i];
+	return -sum;
+}
+
+static double ga2Rastrigin(std::vector<ga2Gene> genes)
+{
+	++ga2BenchEvals;
+	double sum = 10.0 * genes.size();
+	int i;
+	for(i = 0; i < genes.size(); ++i)
+		sum += (double)genes[i] * genes[i] - 10.0 * cos(2.0 * M_PI * genes[i]);
+	return -sum;
+}
+
+static double ga2Rosenbrock(std::vector<ga2Gene> genes)
+{
+	++ga2BenchEvals;
+	double sum = 0.0;
+	int i;
+	for(i = 0; i + 1 < genes.size(); ++i)
+	{
+		double a = genes[i+1] - (double)genes[i] * genes[i];
+		double b = 1.0 - genes[i];
+		sum += 100.0 * a * a + b * b;
+	}
+	return -sum;
+}
+
+//order-5 deceptive trap: each block of five bits scores 5 when all ones,
+//and otherwise 4 less the number of ones, which leads a hill climber
+//towards all zeros
+static double ga2Trap(std::vector<ga2Gene> genes)
+{
+	++ga2BenchEvals;
+	double sum = 0.0;
+	int i, j;
+	for(i = 0; i + 5 <= genes.size(); i += 5)
+	{
+		int ones = 0;
+		for(j = i; j < i + 5; ++j)
+			ones += genes[j] >= 0.5f;
+		sum += (ones == 5) ? 5 : 4 - ones;
+	}
+	return sum;
+}
+
+struct ga2BenchProblem
+{
+	const char *name;
+	double (*func)(std::vector<ga2Gene>);
+	float min, max;
+	bool integer;
+	double target; //per gene; scaled by the chromosome length
+};
+
+static const ga2BenchProblem ga2BenchProblems[] =
+{
+	{"onemax",     ga2OneMax,     0.0f,    1.0f,    true,  1.0},
+	{"sphere",     ga2Sphere,     -5.12f,  5.12f,   false, -0.05},
+	{"rastrigin",  ga2Rastrigin,  -5.12f,  5.12f,   false, -1.0},
+	{"rosenbrock", ga2Rosenbrock, -2.048f, 2.048f,  false, -1.0},
+	{"trap5",      ga2Trap,       0.0f,    1.0f,    true,  1.0},
+};
+
+//////////////////////////////////////////////////////////////////////
+// Configurations
+//////////////////////////////////////////////////////////////////////
+
+struct ga2BenchType
+{
+	const char *name;
+	int type;
+};
+
+static const ga2BenchType ga2BenchSelections[] =
+{
+	{"roulette", GA2_SELECT_ROULETTE},
+	{"ranked",   GA2_SELECT_RANKED},
+};
+
+static const ga2BenchType ga2BenchReplacements[] =
+{
+	{"generational",           GA2_REPLACE_GENERATIONAL},
+	{"steadystate",            GA2_REPLACE_STEADYSTATE},
+	{"steadystatenoduplicates", GA2_REPLACE_STEADYSTATENODUPLICATES},
+};
+
+static const ga2BenchType ga2BenchCrossovers[] =
+{
+	{"uniform", GA2_CROSSOVER_UNIFORM},
+	{"onepoint", GA2_CROSSOVER_ONEPOINT},
+	{"sbx", GA2_CROSSOVER_SBX},
+	{"blx", GA2_CROSSOVER_BLX},
+};
+
+#define GA2_BENCH_COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+//sets up a population the same way for every benchmark. Generational
+//replacement needs a whole population of offspring; the steady-state types
+//replace half.
+static void ga2BenchSetup(ga2Population &pop, const ga2BenchProblem &prob, int length,
+						  const ga2BenchType &sel, const ga2BenchType &rep, const ga2BenchType &cross,
+						  int size)
+{
+	pop.setMinRanges(std::vector<float>(length, prob.min));
+	pop.setMaxRanges(std::vector<float>(length, prob.max));
+	pop.setEvalFunc(prob.func);
+	pop.setInteger(prob.integer);
+	pop.setSelectType(sel.type);
+	pop.setReplaceType(rep.type);
+	pop.setCrossoverType(cross.type);
+	pop.setSort(true);
+	pop.setCrossoverRate(0.9);
+	pop.setMutationRate(1.0 / length);
+	pop.setReplacementSize(rep.type == GA2_REPLACE_GENERATIONAL ? size : size / 2);
+}
+
+static void ga2BenchHeader(void)
+{
+	printf("kind,name,selection,replacement,crossover,size,length,run,iterations,seconds,"
+		   "items,items_per_sec,best,target,time_to_target\n");
+}
+
+//////////////////////////////////////////////////////////////////////
+// Landscapes
+//////////////////////////////////////////////////////////////////////
+
+//runs a steady-state GA on each test function until it reaches the target
+//or runs out of generations
+static void ga2BenchLandscapes(int runs, int generations, unsigned int seed)
+{
+	const int size = 100, length = 40;
+	const ga2BenchType &sel = ga2BenchSelections[1], &rep = ga2BenchReplacements[1];
+	const ga2BenchType &cross = ga2BenchCrossovers[0];
+	int p, r, g;
+	for(p = 0; p < GA2_BENCH_COUNT(ga2BenchProblems); ++p)
+	{
+		const ga2BenchProblem &prob = ga2BenchProblems[p];
+		double target = prob.target * length;
+		for(r = 0; r < runs; ++r)
+		{
+			ga2Population pop(size, length);
+			ga2BenchSetup(pop, prob, length, sel, rep, cross, size);
+			srand(seed + r); //the constructor seeds from the clock
+			ga2BenchEvals = 0;
+			double start = ga2BenchNow(), reached = -1.0;
+			pop.init();
+			pop.evaluate();
+			for(g = 0; g < generations; ++g)
+			{
+				if(pop.getMaxFitness() >= target)
+				{
+					reached = ga2BenchNow() - start;
+					break;
+				}
+				pop.step();
+			}
+			if( (reached < 0.0) && (pop.getMaxFitness() >= target) )
+				reached = ga2BenchNow() - start;
+			double seconds = ga2BenchNow() - start;
+			long evals = ga2BenchEvals;
+			printf("landscape,%s,%s,%s,%s,%d,%d,%d,%d,%.6f,%ld,%.1f,%.6g,%.6g,%.6f\n",
+				   prob.name, sel.name, rep.name, cross.name, size, length, r, g, seconds,
+				   evals, evals / seconds, pop.getMaxFitness(), target, reached);
+			fflush(stdout);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Operators
+//////////////////////////////////////////////////////////////////////
+
+#define GA2_BENCH_SELECT    0
+#define GA2_BENCH_CROSSOVER 1
+#define GA2_BENCH_MUTATE    2
+#define GA2_BENCH_REPLACE   3
+#define GA2_BENCH_EVALUATE  4
+#define GA2_BENCH_PHASES    5
+
+static const char *ga2BenchPhaseNames[GA2_BENCH_PHASES] =
+{
+	"select", "crossover", "mutate", "replace", "evaluate"
+};
+
+//times each phase of a generation separately, running whole generations
+//until the configuration has had its share of time. Uses OneMax, whose
+//evaluations are cheap enough not to hide the operators.
+static void ga2BenchOperators(double minSeconds, unsigned int seed)
+{
+	static const int sizes[] = {100, 1000};
+	static const int lengths[] = {16, 256};
+	const ga2BenchProblem &prob = ga2BenchProblems[0];
+	int s, r, c, n, l, k;
+	for(s = 0; s < GA2_BENCH_COUNT(ga2BenchSelections); ++s)
+	for(r = 0; r < GA2_BENCH_COUNT(ga2BenchReplacements); ++r)
+	for(c = 0; c < GA2_BENCH_COUNT(ga2BenchCrossovers); ++c)
+	for(n = 0; n < GA2_BENCH_COUNT(sizes); ++n)
+	for(l = 0; l < GA2_BENCH_COUNT(lengths); ++l)
+	{
+		const ga2BenchType &sel = ga2BenchSelections[s], &rep = ga2BenchReplacements[r];
+		const ga2BenchType &cross = ga2BenchCrossovers[c];
+		int size = sizes[n], length = lengths[l];
+		ga2Population pop(size, length);
+		ga2BenchSetup(pop, prob, length, sel, rep, cross, size);
+		srand(seed);
+		pop.init();
+		pop.evaluate();
+
+		int offspring = rep.type == GA2_REPLACE_GENERATIONAL ? size : size / 2;
+		double seconds[GA2_BENCH_PHASES] = {0.0};
+		double t[GA2_BENCH_PHASES + 1], total = 0.0;
+		int iterations = 0;
+		while(total < minSeconds)
+		{
+			t[0] = ga2BenchNow();
+			pop.select();
+			t[1] = ga2BenchNow();
+			pop.crossover();
+			t[2] = ga2BenchNow();
+			pop.mutate();
+			t[3] = ga2BenchNow();
+			pop.replace();
+			t[4] = ga2BenchNow();
+			pop.evaluate();
+			t[5] = ga2BenchNow();
+			for(k = 0; k < GA2_BENCH_PHASES; ++k)
+				seconds[k] += t[k+1] - t[k];
+			total += t[GA2_BENCH_PHASES] - t[0];
+			++iterations;
+		}
+		for(k = 0; k < GA2_BENCH_PHASES; ++k)
+		{
+			long items = (long)iterations * (k == GA2_BENCH_EVALUATE ? size : offspring);
+			printf("operator,%s,%s,%s,%s,%d,%d,0,%d,%.6f,%ld,%.1f,%.6g,,\n",
+				   ga2BenchPhaseNames[k], sel.name, rep.name, cross.name, size, length,
+				   iterations, seconds[k], items, items / seconds[k], pop.getMaxFitness());
+		}
+		fflush(stdout);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bool quick = false;
+	unsigned int seed = 1;
+	int i;
+	for(i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--quick") == 0)
+			quick = true;
+		else if( (strcmp(argv[i], "--seed") == 0) && (i + 1 < argc) )
+			seed = strtoul(argv[++i], NULL, 10);
+		else
+		{
+			fprintf(stderr, "usage: %s [--quick] [--seed n]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	ga2BenchHeader();
+	ga2BenchLandscapes(quick ? 1 : 5, quick ? 200 : 2000, seed);
+	ga2BenchOperators(quick ? 0.02 : 0.25, seed);
+	return 0;
+}
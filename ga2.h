@@ -23,16 +23,79 @@
 
 #define GA2_CROSSOVER_ONEPOINT 1
 #define GA2_CROSSOVER_UNIFORM 2
+#define GA2_CROSSOVER_SBX 3
+#define GA2_CROSSOVER_BLX 4
+//picks among the four above by their recent success
+#define GA2_CROSSOVER_ADAPTIVE 5
+//for permutations; see ga2Population::setPermutation()
+#define GA2_CROSSOVER_ORDER 6
+#define GA2_CROSSOVER_PMX 7
+#define GA2_CROSSOVER_CYCLE 8
+
+#define GA2_MUTATE_RESET 1
+#define GA2_MUTATE_GAUSSIAN 2
+#define GA2_MUTATE_POLYNOMIAL 3
+//for permutations
+#define GA2_MUTATE_SWAP 4
+#define GA2_MUTATE_INSERT 5
+#define GA2_MUTATE_INVERSION 6
+
+#define GA2_LOCALSEARCH_NONE 0
+#define GA2_LOCALSEARCH_LAMARCKIAN 1
+#define GA2_LOCALSEARCH_BALDWINIAN 2
 
 #define GA2_REPLACE_GENERATIONAL 1
 #define GA2_REPLACE_STEADYSTATE 2
 #define GA2_REPLACE_STEADYSTATENODUPLICATES 3
+//each child against the nearer of its parents; keeps niches apart
+#define GA2_REPLACE_CROWDING 4
 
 #define GA2_SELECT_ROULETTE 1
 #define GA2_SELECT_RANKED 2
 
+#define GA2_NICHE_NONE 0
+#define GA2_NICHE_SHARING 1
+#define GA2_NICHE_CLEARING 2
+
+#define GA2_DE_RAND1BIN 1
+#define GA2_DE_CURRENTTOBEST1BIN 2
+
+#define GA2_NEIGHBORHOOD_VONNEUMANN 1
+#define GA2_NEIGHBORHOOD_MOORE 2
+
+//cells per side of the square tiles ga2CellularPopulation stores genes in
+#define GA2_CELLULAR_TILESIZE 8
+
+//why ga2Population::run() stopped
+#define GA2_STOP_NONE 0
+#define GA2_STOP_GENERATIONS 1
+#define GA2_STOP_EVALUATIONS 2
+#define GA2_STOP_TIME 3
+#define GA2_STOP_TARGET 4
+#define GA2_STOP_STAGNATION 5
+#define GA2_STOP_CALLBACK 6
+#define GA2_STOP_FAILED 7
+
 #include "ga2Gene.h"
+#include "ga2Random.h"
+#include "ga2Scheduler.h"
+#include "ga2Checkpoint.h"
+#include "ga2FitnessCache.h"
+#include "ga2Tracer.h"
+#include "ga2Profiler.h"
+#include "ga2SpatialIndex.h"
 #include "ga2Chromosome.h"
 #include "ga2Population.h"
+#include "ga2DeltaCheckpoint.h"
+#include "ga2Logger.h"
+#include "ga2Genealogy.h"
+#include "ga2TextLoader.h"
+#include "ga2CellularPopulation.h"
+#include "ga2MultiRun.h"
+#include "ga2MultiObjective.h"
+#include "ga2DifferentialEvolution.h"
+#include "ga2CMAES.h"
+#include "ga2ConcurrentPopulation.h"
+#include "ga2MappedPopulation.h"
 
 #endif //__GA2_H__
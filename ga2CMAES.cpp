@@ -0,0 +1,362 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2CMAES.cpp: implementation of the ga2CMAES class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include "ga2.h"
+
+//orders sample indices by fitness, best first
+class ga2SampleFitterThan
+{
+	const double *_fitness;
+public:
+	ga2SampleFitterThan(const double *fitness) : _fitness(fitness) {};
+	bool operator()(int a, int b) const {return _fitness[a] > _fitness[b];};
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param pop The population to evolve. Must outlive this.
+ */
+ga2CMAES::ga2CMAES( ga2Population &pop ) : _pop(pop)
+{
+	_started = false;
+	_generations = 0;
+	_eigenAge = 0;
+	_initialSigma = 0.0;
+	_sigma = 0.0;
+	_bestFitness = -DBL_MAX;
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2CMAES::~ga2CMAES()
+{
+}
+
+//sorts chromosomes best first, for sorted populations
+bool ga2CMAES::_fitter(const ga2Chromosome &a, const ga2Chromosome &b)
+{
+	return a._fitness > b._fitness;
+}
+
+//sets the strategy parameters for the population's size and length, and
+//starts the distribution off from the population's mean and spread.
+bool ga2CMAES::_start(void)
+{
+	ga2Population &pop = _pop;
+	if(pop._chromosomes.empty() && !pop.init())
+		return false;
+	int n = pop._chromoSize, lambda = pop._chromosomes.size();
+	if( (lambda < 2) || (n < 1) || (pop._chromoMinRanges.size() != n) || (pop._chromoMaxRanges.size() != n) )
+		return false;
+	int i, j;
+	_n = n;
+	_lambda = lambda;
+	_mu = lambda / 2;
+	_weights.resize(_mu);
+	double sum = 0.0, sumSq = 0.0;
+	for(i = 0; i < _mu; ++i)
+		sum += _weights[i] = log(_mu + 0.5) - log(i + 1.0);
+	for(i = 0; i < _mu; ++i)
+	{
+		_weights[i] /= sum;
+		sumSq += _weights[i] * _weights[i];
+	}
+	_muEff = 1.0 / sumSq;
+	_cSigma = (_muEff + 2.0) / (n + _muEff + 5.0);
+	_dSigma = 1.0 + 2.0 * std::max(0.0, sqrt((_muEff - 1.0) / (n + 1.0)) - 1.0) + _cSigma;
+	_cC = (4.0 + _muEff / n) / (n + 4.0 + 2.0 * _muEff / n);
+	_c1 = 2.0 / ((n + 1.3) * (n + 1.3) + _muEff);
+	_cMu = std::min(1.0 - _c1, 2.0 * (_muEff - 2.0 + 1.0 / _muEff) / ((n + 2.0) * (n + 2.0) + _muEff));
+	_chiN = sqrt((double)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+	//the population's own statistics give the starting point and shape
+	if(!pop._statsValid)
+		pop._recomputeStats();
+	_mean.resize(n);
+	std::vector<double> var(n);
+	double avgVar = 0.0, avgRange = 0.0;
+	for(j = 0; j < n; ++j)
+	{
+		_mean[j] = pop._geneShift[j] + pop._geneSum[j] / lambda;
+		var[j] = pop.getGeneVariance(j);
+		avgVar += var[j] / n;
+		avgRange += (pop._chromoMaxRanges[j] - pop._chromoMinRanges[j]) / n;
+	}
+	_sigma = _initialSigma > 0.0 ? _initialSigma : sqrt(avgVar);
+	if(_sigma <= 0.0)
+		_sigma = 0.3 * avgRange;
+	if(_sigma <= 0.0)
+		_sigma = 1.0;
+	_C.assign((size_t)n * n, 0.0);
+	_B.assign((size_t)n * n, 0.0);
+	_D.resize(n);
+	for(j = 0; j < n; ++j)
+	{
+		double c = var[j] / (_sigma * _sigma);
+		if(c < 1e-6)
+			c = 1e-6;
+		_C[(size_t)j * n + j] = c;
+		_B[(size_t)j * n + j] = 1.0;
+		_D[j] = sqrt(c);
+	}
+	_pathC.assign(n, 0.0);
+	_pathSigma.assign(n, 0.0);
+	_z.resize(n);
+	_y.resize(n);
+	_ys.resize((size_t)lambda * n);
+	_order.resize(lambda);
+	_generations = 0;
+	_eigenAge = 0;
+	_started = true;
+	return true;
+}
+
+//brings B and D up to date with C, by cyclic Jacobi rotations
+void ga2CMAES::_decompose(void)
+{
+	int n = _n, sweep, p, q, k;
+	std::vector<double> A(_C);
+	std::vector<double> &V = _B;
+	V.assign((size_t)n * n, 0.0);
+	for(k = 0; k < n; ++k)
+		V[(size_t)k * n + k] = 1.0;
+	for(sweep = 0; sweep < 50; ++sweep)
+	{
+		double off = 0.0, diag = 0.0;
+		for(p = 0; p < n; ++p)
+		{
+			diag += A[(size_t)p * n + p] * A[(size_t)p * n + p];
+			for(q = p + 1; q < n; ++q)
+				off += A[(size_t)p * n + q] * A[(size_t)p * n + q];
+		}
+		if(off <= 1e-30 * diag)
+			break;
+		for(p = 0; p < n; ++p)
+			for(q = p + 1; q < n; ++q)
+			{
+				double apq = A[(size_t)p * n + q];
+				if(apq == 0.0)
+					continue;
+				double theta = (A[(size_t)q * n + q] - A[(size_t)p * n + p]) / (2.0 * apq);
+				double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+				for(k = 0; k < n; ++k) //columns p and q
+				{
+					double *row = &A[(size_t)k * n];
+					double akp = row[p], akq = row[q];
+					row[p] = c * akp - s * akq;
+					row[q] = s * akp + c * akq;
+					double *vrow = &V[(size_t)k * n];
+					double vkp = vrow[p], vkq = vrow[q];
+					vrow[p] = c * vkp - s * vkq;
+					vrow[q] = s * vkp + c * vkq;
+				}
+				double *rp = &A[(size_t)p * n], *rq = &A[(size_t)q * n];
+				for(k = 0; k < n; ++k) //rows p and q
+				{
+					double apk = rp[k], aqk = rq[k];
+					rp[k] = c * apk - s * aqk;
+					rq[k] = s * apk + c * aqk;
+				}
+			}
+	}
+	for(k = 0; k < n; ++k)
+	{
+		double e = A[(size_t)k * n + k];
+		_D[k] = sqrt(e > 1e-20 ? e : 1e-20);
+	}
+}
+
+/**
+ * Starts the distribution from the population if this is the first step,
+ * or the population's size has changed, initialising the population if
+ * that has not been done. Returns false if it cannot be started.
+ */
+bool ga2CMAES::step(void)
+{
+	ga2Population &pop = _pop;
+	pop.flush(); //a pipelined batch would otherwise land on the new generation
+	if( (!_started || (pop._chromosomes.size() != _lambda)) && !_start() )
+		return false;
+	ga2TraceScope traced(pop._tracer, "generation", "ga2", "generation", ++pop._generation);
+	int n = _n, lambda = _lambda, mu = _mu;
+	const float *lo = &pop._chromoMinRanges[0], *hi = &pop._chromoMaxRanges[0];
+	const double *B = &_B[0], *D = &_D[0];
+	double *z = &_z[0], *y = &_y[0], *mean = &_mean[0];
+	int i, j, k;
+
+	//sample every member afresh: x = mean + sigma B D z
+	ga2ProfileScope sampling(pop._profiler, GA2_PHASE_MUTATE, pop._tracer);
+	for(k = 0; k < lambda; ++k)
+	{
+		for(j = 0; j < n; ++j)
+			z[j] = D[j] * _random.gaussian();
+		double *yk = &_ys[(size_t)k * n];
+		for(i = 0; i < n; ++i)
+		{
+			const double *row = B + (size_t)i * n;
+			double sum = 0.0;
+			for(j = 0; j < n; ++j)
+				sum += row[j] * z[j];
+			y[i] = sum;
+		}
+		ga2Chromosome &c = pop._chromosomes[k];
+		ga2Gene *x = &c._genes[0];
+		//the step is the one actually taken after clamping, but is worked
+		//out before the genes round it to float
+		for(j = 0; j < n; ++j)
+		{
+			double g = mean[j] + _sigma * y[j];
+			g = g < lo[j] ? lo[j] : g;
+			g = g > hi[j] ? hi[j] : g;
+			yk[j] = (g - mean[j]) / _sigma;
+			x[j] = g;
+		}
+		if(pop._integer)
+			for(j = 0; j < n; ++j)
+				x[j] = floorf(x[j] + 0.5f);
+		c._isEvaluated = false;
+		c._id = ga2Chromosome::_newId();
+		c._parent[0] = c._parent[1] = -1;
+		c._crossSite = -1;
+	}
+	pop._statsValid = false;
+	if(pop._profiler)
+		pop._profiler->count(GA2_COUNTER_MUTATIONS, lambda);
+	sampling.end();
+
+	ga2ProfileScope evaluating(pop._profiler, GA2_PHASE_EVALUATE, pop._tracer);
+	pop._evaluateBatch(pop._chromosomes);
+	evaluating.end();
+
+	//adapt the distribution to the better half
+	ga2ProfileScope adapting(pop._profiler, GA2_PHASE_REPLACE, pop._tracer);
+	std::vector<double> fitness(lambda);
+	for(k = 0; k < lambda; ++k)
+	{
+		_order[k] = k;
+		fitness[k] = pop._chromosomes[k]._fitness;
+	}
+	std::stable_sort(_order.begin(), _order.end(), ga2SampleFitterThan(&fitness[0]));
+	if(pop._chromosomes[_order[0]]._fitness > _bestFitness)
+	{
+		_bestFitness = pop._chromosomes[_order[0]]._fitness;
+		_bestGenes = pop._chromosomes[_order[0]]._genes;
+	}
+
+	//move the mean: yw is the weighted step of the best mu
+	std::vector<double> yw(n, 0.0);
+	for(i = 0; i < mu; ++i)
+	{
+		const double *yi = &_ys[(size_t)_order[i] * n];
+		double w = _weights[i];
+		for(j = 0; j < n; ++j)
+			yw[j] += w * yi[j];
+	}
+	for(j = 0; j < n; ++j)
+		mean[j] += _sigma * yw[j];
+
+	//step size path, through C^-1/2 = B D^-1 B'
+	std::vector<double> t(n, 0.0);
+	for(i = 0; i < n; ++i)
+	{
+		const double *row = B + (size_t)i * n;
+		for(j = 0; j < n; ++j)
+			t[j] += row[j] * yw[i];
+	}
+	for(j = 0; j < n; ++j)
+		t[j] /= D[j];
+	double cs = sqrt(_cSigma * (2.0 - _cSigma) * _muEff), norm = 0.0;
+	for(i = 0; i < n; ++i)
+	{
+		const double *row = B + (size_t)i * n;
+		double sum = 0.0;
+		for(j = 0; j < n; ++j)
+			sum += row[j] * t[j];
+		_pathSigma[i] = (1.0 - _cSigma) * _pathSigma[i] + cs * sum;
+		norm += _pathSigma[i] * _pathSigma[i];
+	}
+	norm = sqrt(norm);
+	++_generations;
+	bool hSigma = norm / sqrt(1.0 - pow(1.0 - _cSigma, 2.0 * _generations)) / _chiN < 1.4 + 2.0 / (n + 1.0);
+
+	//covariance path and covariance: rank one and rank mu updates
+	double cc = sqrt(_cC * (2.0 - _cC) * _muEff);
+	for(j = 0; j < n; ++j)
+		_pathC[j] = (1.0 - _cC) * _pathC[j] + (hSigma ? cc * yw[j] : 0.0);
+	double keep = 1.0 - _c1 - _cMu + (hSigma ? 0.0 : _c1 * _cC * (2.0 - _cC));
+	const double *pc = &_pathC[0];
+	for(i = 0; i < n; ++i)
+	{
+		double *row = &_C[(size_t)i * n];
+		double a = _c1 * pc[i];
+		for(j = 0; j < n; ++j)
+			row[j] = keep * row[j] + a * pc[j];
+	}
+	for(k = 0; k < mu; ++k)
+	{
+		const double *yk = &_ys[(size_t)_order[k] * n];
+		for(i = 0; i < n; ++i)
+		{
+			double *row = &_C[(size_t)i * n];
+			double a = _cMu * _weights[k] * yk[i];
+			for(j = 0; j < n; ++j)
+				row[j] += a * yk[j];
+		}
+	}
+	_sigma *= exp((_cSigma / _dSigma) * (norm / _chiN - 1.0));
+
+	//the decomposition is O(n^3), so only redo it as often as C changes much
+	if(++_eigenAge >= lambda / (_c1 + _cMu) / n / 10.0)
+	{
+		_decompose();
+		_eigenAge = 0;
+	}
+
+	if(pop._isSorted)
+		std::stable_sort(pop._chromosomes.begin(), pop._chromosomes.end(), _fitter);
+	pop._updateStats();
+	adapting.end();
+
+	pop._parentLag = 1;
+	if(pop._genealogy)
+		pop._genealogy->record(pop);
+	pop._profileGeneration();
+	return true;
+}
+
+/**
+ * \param generations Number of generations to step.
+ */
+bool ga2CMAES::run(int generations)
+{
+	int g;
+	for(g = 0; g < generations; ++g)
+		if(!step())
+			return false;
+	return true;
+}
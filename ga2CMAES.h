@@ -0,0 +1,120 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2CMAES.h: interface for the ga2CMAES class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2CMAES_H__
+#define __GA2CMAES_H__
+
+#include <vector>
+#include "ga2Gene.h"
+#include "ga2Random.h"
+
+class ga2Population;
+class ga2Chromosome;
+
+///Evolves a ga2Population by the covariance matrix adaptation evolution strategy.
+/**
+ * The ga2CMAES class is for continuous problems that are badly scaled or
+ * whose variables interact, where it typically needs far fewer
+ * evaluations than a GA. Like ga2DifferentialEvolution it works on an
+ * ordinary ga2Population in place of ga2Population::step(), using the
+ * population's ranges, scheduler, fitness cache, statistics, profiler and
+ * so on; the population's size is the number of samples per generation.
+ *
+ * Each generation samples the whole population afresh from a multivariate
+ * normal distribution, evaluates it as one batch, and moves the mean of
+ * the distribution towards the better half, weighted by rank. The
+ * covariance matrix and step size adapt to the path the mean has taken,
+ * which in effect learns the shape of the landscape. This is the standard
+ * (mu/mu_w, lambda) CMA-ES with Hansen's default settings.
+ *
+ * The distribution starts from the population as it stands: its mean at
+ * the population's mean, and its step size the population's spread (see
+ * ga2Population::getGeneVariance()), so ga2Population::init(), with or
+ * without seeds, is the way to choose the starting point. Samples are
+ * clamped into range.
+ *
+ * The strategy is not elitist, so the population can lose its best
+ * chromosome; the best ever found is kept by
+ * ga2CMAES::getBestFitChromosome().
+ */
+class ga2CMAES
+{
+	ga2Population &_pop;
+	int _n;
+	int _lambda;
+	int _mu;
+	std::vector<double> _weights;
+	double _muEff;
+	double _cSigma, _dSigma, _cC, _c1, _cMu, _chiN;
+
+	bool _started;
+	long _generations;
+	long _eigenAge;
+	double _initialSigma;
+	double _sigma;
+	std::vector<double> _mean;
+	std::vector<double> _pathC;
+	std::vector<double> _pathSigma;
+	std::vector<double> _C; //covariance, row major
+	std::vector<double> _B; //eigenvectors of C, in columns
+	std::vector<double> _D; //square roots of the eigenvalues of C
+	std::vector<double> _z; //scratch
+	std::vector<double> _y;
+	std::vector<double> _ys; //every sample's step, row major
+	std::vector<int> _order;
+	ga2Random _random;
+	double _bestFitness;
+	std::vector<ga2Gene> _bestGenes;
+
+	bool _start(void);
+	void _decompose(void);
+	static bool _fitter(const ga2Chromosome &a, const ga2Chromosome &b);
+
+public:
+	///The constructor.
+	ga2CMAES( ga2Population &pop );
+	///The destructor.
+	virtual ~ga2CMAES();
+	///Restart the random number generator from a seed.
+	void setSeed(uint64_t seed) {_random.setSeed(seed);};
+	///Set the starting step size, in the units of the genes.
+	/**
+	 * \param sigma The step size, or 0 (the default) to take it from the
+	 * spread of the population. Takes effect at the next start, that is
+	 * the first ga2CMAES::step() or the first after ga2CMAES::restart().
+	 */
+	void setSigma(double sigma) {_initialSigma = sigma;};
+	///Return the current step size.
+	double getSigma(void) {return _sigma;};
+	///Return the mean of the distribution.
+	std::vector<double> getMean(void) {return _mean;};
+	///Run one generation.
+	bool step(void);
+	///Run a number of generations.
+	bool run(int generations);
+	///Forget the adapted distribution, and start again from the population.
+	void restart(void) {_started = false;};
+	///Return the highest fitness ever sampled.
+	double getBestFitness(void) {return _bestFitness;};
+	///Return the fittest chromosome ever sampled.
+	std::vector<ga2Gene> getBestFitChromosome(void) {return _bestGenes;};
+};
+
+#endif
@@ -0,0 +1,366 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2CellularPopulation.cpp: implementation of the ga2CellularPopulation
+//                            class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <time.h>
+#include <float.h>
+#include "ga2.h"
+
+#define TILE GA2_CELLULAR_TILESIZE
+
+static const int ga2VonNeumann[5][2] = { {0,0}, {1,0}, {-1,0}, {0,1}, {0,-1} };
+static const int ga2Moore[9][2] = { {0,0}, {1,0}, {-1,0}, {0,1}, {0,-1},
+									{1,1}, {1,-1}, {-1,1}, {-1,-1} };
+
+//updates whole stripes of the grid; handed to the scheduler.
+class ga2CellularTask : public ga2Task
+{
+	ga2CellularPopulation &_pop;
+	bool _init;
+public:
+	ga2CellularTask(ga2CellularPopulation &pop, bool init) : _pop(pop), _init(init) {};
+	void run(int begin, int end)
+	{
+		int i;
+		for(i = begin; i < end; ++i)
+		{
+			if(_init)
+				_pop._initStripe(i);
+			else
+				_pop._breedStripe(i);
+		}
+	};
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param width Number of cells across the grid
+ * \param height Number of cells down the grid
+ * \param chromoSize Number of genes per chromosome
+ *
+ * Constructs a grid of width*height chromosomes. Storage is allocated in
+ * whole tiles, so grids whose sides are a multiple of
+ * GA2_CELLULAR_TILESIZE waste no memory.
+ */
+ga2CellularPopulation::ga2CellularPopulation( int width, int height, int chromoSize )
+	: _width(width), _height(height), _chromoSize(chromoSize)
+{
+	_tilesX = (_width + TILE - 1) / TILE;
+	_tilesY = (_height + TILE - 1) / TILE;
+	_evalFunc = NULL;
+	_scheduler = NULL;
+	_current = 0;
+	_mutationRate = 0.0;
+	_crossoverRate = 1.0;
+	_integer = false;
+	_crossoverType = GA2_CROSSOVER_ONEPOINT;
+	_replacementType = GA2_REPLACE_STEADYSTATE;
+	_neighborhood = GA2_NEIGHBORHOOD_VONNEUMANN;
+	_seed = time(NULL);
+	_sumFitness = _avgFitness = _minFitness = _maxFitness = 0.0;
+	_bestCell = 0;
+	_generation = 0;
+	_evaluations = 0;
+
+	int cells = _tilesX * _tilesY * TILE * TILE;
+	int i;
+	for(i = 0; i < 2; ++i)
+	{
+		_genes[i].resize((size_t)cells * _chromoSize);
+		_fitness[i].resize(cells);
+	}
+	_stripeRandom.resize(_tilesY);
+	_stripeSum.resize(_tilesY);
+	_stripeMin.resize(_tilesY);
+	_stripeMax.resize(_tilesY);
+	_stripeBest.resize(_tilesY);
+	_stripeCount.resize(_tilesY);
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2CellularPopulation::~ga2CellularPopulation()
+{
+}
+
+//position of cell (x, y) in storage: tile by tile, row by row within a tile
+int ga2CellularPopulation::_cell(int x, int y)
+{
+	return (((y / TILE) * _tilesX + (x / TILE)) * TILE + (y % TILE)) * TILE + (x % TILE);
+}
+
+ga2Gene ga2CellularPopulation::_randomGene(ga2Random &rng, int i)
+{
+	float range = _chromoMaxRanges[i] - _chromoMinRanges[i];
+	float f;
+	if(_integer)
+	{
+		f = (rng.uniform() * (range+1)) + _chromoMinRanges[i];
+		f = (int)f; //trunc it down to size
+	}
+	else //no rounding
+		f = (rng.uniform() * range) + _chromoMinRanges[i];
+	return f;
+}
+
+/**
+ * Randomly initialises every cell within the ranges set with
+ * ga2CellularPopulation::setMinRanges() and
+ * ga2CellularPopulation::setMaxRanges(), and evaluates them all. Call after
+ * setting the ranges, the fitness function and (optionally) the seed.
+ */
+bool ga2CellularPopulation::init(void)
+{
+	if( (_chromoMaxRanges.size() != _chromoSize)
+	  ||(_chromoMinRanges.size() != _chromoSize) )
+		return false;
+
+	int i;
+	for(i = 0; i < _tilesY; ++i)
+		_stripeRandom[i].setSeed(_seed + i * 0x9E3779B97F4A7C15ULL);
+	_current = 0;
+	_generation = 0;
+	_evaluations = 0;
+	return _run(true);
+}
+
+/**
+ * Every cell picks two parents from its neighbourhood by binary
+ * tournament, crosses them over into one child, mutates it and evaluates
+ * it. Whether the child replaces the cell is decided by
+ * ga2CellularPopulation::setReplaceType(). All cells read the previous
+ * generation and write the next one, so the order of updates does not
+ * matter.
+ */
+bool ga2CellularPopulation::step(void)
+{
+	if(_fitness[_current].empty())
+		return false;
+	if(!_run(false))
+		return false;
+	_current = 1 - _current;
+	++_generation;
+	return true;
+}
+
+bool ga2CellularPopulation::_run(bool init)
+{
+	ga2CellularTask task(*this, init);
+	if(_scheduler)
+		_scheduler->parallelFor(task, _tilesY);
+	else
+		task.run(0, _tilesY);
+
+	//each stripe kept its own statistics; just combine them
+	_sumFitness = 0.0;
+	_minFitness = DBL_MAX;
+	_maxFitness = -DBL_MAX;
+	int i;
+	for(i = 0; i < _tilesY; ++i)
+	{
+		_sumFitness += _stripeSum[i];
+		_evaluations += _stripeCount[i];
+		if(_stripeMin[i] < _minFitness)
+			_minFitness = _stripeMin[i];
+		if(_stripeMax[i] > _maxFitness)
+		{
+			_maxFitness = _stripeMax[i];
+			_bestCell = _stripeBest[i];
+		}
+	}
+	_avgFitness = _sumFitness / (double)getSize();
+	return true;
+}
+
+void ga2CellularPopulation::_initStripe(int stripe)
+{
+	ga2Random &rng = _stripeRandom[stripe];
+	std::vector<ga2Gene> chromo(_chromoSize);
+	double sum = 0.0, min = DBL_MAX, max = -DBL_MAX;
+	int best = -1;
+	long count = 0;
+	int yEnd = (stripe+1) * TILE < _height ? (stripe+1) * TILE : _height;
+	int tx, x, y, i;
+	for(tx = 0; tx < _tilesX; ++tx)
+	{
+		int xEnd = (tx+1) * TILE < _width ? (tx+1) * TILE : _width;
+		for(y = stripe * TILE; y < yEnd; ++y)
+			for(x = tx * TILE; x < xEnd; ++x)
+			{
+				int c = _cell(x, y);
+				ga2Gene *g = &_genes[_current][(size_t)c * _chromoSize];
+				for(i = 0; i < _chromoSize; ++i)
+					g[i] = chromo[i] = _randomGene(rng, i);
+				double f = _evalFunc ? _evalFunc(chromo) : 0.0;
+				++count;
+				_fitness[_current][c] = f;
+				sum += f;
+				if(f < min) min = f;
+				if(f > max) {max = f; best = c;}
+			}
+	}
+	_stripeSum[stripe] = sum;
+	_stripeMin[stripe] = min;
+	_stripeMax[stripe] = max;
+	_stripeBest[stripe] = best;
+	_stripeCount[stripe] = count;
+}
+
+//binary tournament between two random members of the neighbourhood
+int ga2CellularPopulation::_selectNeighbor(ga2Random &rng, int x, int y)
+{
+	const int (*offsets)[2] = ga2VonNeumann;
+	int n = 5;
+	if(_neighborhood == GA2_NEIGHBORHOOD_MOORE)
+	{
+		offsets = ga2Moore;
+		n = 9;
+	}
+
+	int best = -1, k;
+	for(k = 0; k < 2; ++k)
+	{
+		int o = rng.below(n);
+		int nx = x + offsets[o][0], ny = y + offsets[o][1];
+		if(nx < 0) nx += _width; else if(nx >= _width) nx -= _width;
+		if(ny < 0) ny += _height; else if(ny >= _height) ny -= _height;
+		int c = _cell(nx, ny);
+		if(best < 0 || _fitness[_current][c] > _fitness[_current][best])
+			best = c;
+	}
+	return best;
+}
+
+void ga2CellularPopulation::_breedStripe(int stripe)
+{
+	ga2Random &rng = _stripeRandom[stripe];
+	const ga2Gene *src = &_genes[_current][0];
+	ga2Gene *dst = &_genes[1-_current][0];
+	const double *fit = &_fitness[_current][0];
+	double *nextFit = &_fitness[1-_current][0];
+	std::vector<ga2Gene> child(_chromoSize);
+	double sum = 0.0, min = DBL_MAX, max = -DBL_MAX;
+	int best = -1;
+	long count = 0;
+	int yEnd = (stripe+1) * TILE < _height ? (stripe+1) * TILE : _height;
+	int tx, x, y, i;
+	for(tx = 0; tx < _tilesX; ++tx)
+	{
+		int xEnd = (tx+1) * TILE < _width ? (tx+1) * TILE : _width;
+		for(y = stripe * TILE; y < yEnd; ++y)
+			for(x = tx * TILE; x < xEnd; ++x)
+			{
+				int c = _cell(x, y);
+				const ga2Gene *a = src + (size_t)_selectNeighbor(rng, x, y) * _chromoSize;
+				const ga2Gene *b = src + (size_t)_selectNeighbor(rng, x, y) * _chromoSize;
+
+				if(rng.uniform() > _crossoverRate)
+					for(i = 0; i < _chromoSize; ++i)
+						child[i] = a[i];
+				else if(_crossoverType == GA2_CROSSOVER_UNIFORM)
+					for(i = 0; i < _chromoSize; ++i)
+						child[i] = (rng.next() >> 63) ? a[i] : b[i];
+				else
+				{
+					int coPoint = rng.below(_chromoSize);
+					for(i = 0; i < coPoint; ++i)
+						child[i] = a[i];
+					for(; i < _chromoSize; ++i)
+						child[i] = b[i];
+				}
+				for(i = 0; i < _chromoSize; ++i)
+					if(rng.uniform() < _mutationRate)
+						child[i] = _randomGene(rng, i);
+
+				double f = _evalFunc ? _evalFunc(child) : 0.0;
+				++count;
+				ga2Gene *out = dst + (size_t)c * _chromoSize;
+				if( (_replacementType == GA2_REPLACE_GENERATIONAL) || (f >= fit[c]) )
+				{
+					for(i = 0; i < _chromoSize; ++i)
+						out[i] = child[i];
+				}
+				else
+				{
+					const ga2Gene *in = src + (size_t)c * _chromoSize;
+					for(i = 0; i < _chromoSize; ++i)
+						out[i] = in[i];
+					f = fit[c];
+				}
+				nextFit[c] = f;
+				sum += f;
+				if(f < min) min = f;
+				if(f > max) {max = f; best = c;}
+			}
+	}
+	_stripeSum[stripe] = sum;
+	_stripeMin[stripe] = min;
+	_stripeMax[stripe] = max;
+	_stripeBest[stripe] = best;
+	_stripeCount[stripe] = count;
+}
+
+/**
+ * \param x Column of the cell, from 0 to getWidth()-1
+ * \param y Row of the cell, from 0 to getHeight()-1
+ *
+ * Returns a copy of the genes of the chromosome in a cell.
+ */
+std::vector<ga2Gene> ga2CellularPopulation::getGenes(int x, int y)
+{
+	const ga2Gene *g = &_genes[_current][(size_t)_cell(x, y) * _chromoSize];
+	return std::vector<ga2Gene>(g, g + _chromoSize);
+}
+
+/**
+ * Returns a vector of genes representing the best fit chromosome in
+ * the grid, as of the last call to init() or step().
+ */
+std::vector<ga2Gene> ga2CellularPopulation::getBestFitChromosome(void)
+{
+	const ga2Gene *g = &_genes[_current][(size_t)_bestCell * _chromoSize];
+	return std::vector<ga2Gene>(g, g + _chromoSize);
+}
+
+/**
+ * \param ranges A vector containing the upper bound for the values of each
+ * gene.
+ */
+void ga2CellularPopulation::setMaxRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMaxRanges = ranges;
+}
+
+/**
+ * \param ranges A vector containing the lower bound for the values of each
+ * gene.
+ */
+void ga2CellularPopulation::setMinRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMinRanges = ranges;
+}
@@ -0,0 +1,174 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2CellularPopulation.h: interface for the ga2CellularPopulation class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2CELLULARPOPULATION_H__
+#define __GA2CELLULARPOPULATION_H__
+
+#include <vector>
+#include "ga2Gene.h"
+#include "ga2Random.h"
+#include "ga2Scheduler.h"
+
+///A population living on a two dimensional toroidal grid.
+/**
+ * The ga2CellularPopulation class is an alternative to ga2Population in
+ * which every chromosome occupies one cell of a grid that wraps around at
+ * the edges. Each generation, every cell breeds a single child from two
+ * parents picked out of its own neighbourhood and decides whether the child
+ * takes its place. Good genes spread across the grid slowly, one
+ * neighbourhood at a time, which keeps the population diverse for much
+ * longer than a panmictic population does.
+ *
+ * Since there is no global selection, there is nothing to sort and no
+ * population-wide sum to compute. The grid is updated synchronously from
+ * one buffer into another, in horizontal stripes that are independent of
+ * each other, so a ga2Scheduler can update them all at once. Each stripe
+ * has its own random number generator, so the result for a given seed does
+ * not depend on the number of threads.
+ *
+ * Chromosomes are stored as flat arrays of genes, grouped into square
+ * tiles of GA2_CELLULAR_TILESIZE cells on a side, so that a cell's
+ * neighbours are nearly always in the same few cache lines as the cell.
+ */
+class ga2CellularPopulation
+{
+	int _width;
+	int _height;
+	int _chromoSize;
+	int _tilesX;
+	int _tilesY;
+
+	double(* _evalFunc)(std::vector<ga2Gene>);
+	ga2Scheduler *_scheduler;
+	std::vector<float> _chromoMaxRanges;
+	std::vector<float> _chromoMinRanges;
+
+	//two copies of everything; one is read while the other is written
+	std::vector<ga2Gene> _genes[2];
+	std::vector<double> _fitness[2];
+	int _current;
+	std::vector<ga2Random> _stripeRandom;
+	std::vector<double> _stripeSum;
+	std::vector<double> _stripeMin;
+	std::vector<double> _stripeMax;
+	std::vector<int> _stripeBest;
+	std::vector<long> _stripeCount;
+
+	double _mutationRate;
+	double _crossoverRate;
+	bool _integer;
+	int _crossoverType;
+	int _replacementType;
+	int _neighborhood;
+	uint64_t _seed;
+
+	double _sumFitness;
+	double _avgFitness;
+	double _minFitness;
+	double _maxFitness;
+	int _bestCell;
+	long _generation;
+	long _evaluations;
+
+	friend class ga2CellularTask;
+	int _cell(int x, int y);
+	ga2Gene _randomGene(ga2Random &rng, int i);
+	void _initStripe(int stripe);
+	void _breedStripe(int stripe);
+	int _selectNeighbor(ga2Random &rng, int x, int y);
+	bool _run(bool init);
+
+public:
+	///The constructor.
+	ga2CellularPopulation( int width, int height, int chromoSize );
+	///The destructor.
+	virtual ~ga2CellularPopulation();
+	///Set the evaluation function to use.
+	/**
+	 * \param func the function to call. Must be of form
+	 * double my_func(std::vector<ga2Gene> chromo_to_evaluate), and must be
+	 * safe to call from several threads if a scheduler is set.
+	 */
+	void setEvalFunc(double (* func)(std::vector<ga2Gene>)) {_evalFunc = func;};
+	///Set the scheduler used to update the grid stripes in parallel.
+	void setScheduler(ga2Scheduler *sched) {_scheduler = sched;};
+	///Set the minimum values for each gene.
+	void setMinRanges(std::vector<float> ranges);
+	///Set the maximum values for each gene.
+	void setMaxRanges(std::vector<float> ranges);
+	///Set the neighbourhood that mates are chosen from.
+	/**
+	 * \param type valid values are GA2_NEIGHBORHOOD_VONNEUMANN (the cell and
+	 * its four orthogonal neighbours) or GA2_NEIGHBORHOOD_MOORE (the cell
+	 * and all eight surrounding cells).
+	 */
+	void setNeighborhood(int type) {_neighborhood = type;};
+	///Set the crossover function to use.
+	/**
+	 * \param type valid values are GA2_CROSSOVER_ONEPOINT or
+	 * GA2_CROSSOVER_UNIFORM
+	 */
+	void setCrossoverType(int type) {_crossoverType = type;};
+	///Set the replacement policy for each cell.
+	/**
+	 * \param type GA2_REPLACE_STEADYSTATE keeps the child only if it is at
+	 * least as fit as the cell it would replace (the default);
+	 * GA2_REPLACE_GENERATIONAL always keeps the child.
+	 */
+	void setReplaceType(int type) {_replacementType = type;};
+	///Set the probability of a gene mutating.
+	void setMutationRate(float mRate) {_mutationRate = mRate;};
+	///Set the probability of a pair of parents crossing-over.
+	void setCrossoverRate(float cRate) {_crossoverRate = cRate;};
+	///Are we using integer genes or floating point genes?
+	void setInteger(bool val) {_integer = val;};
+	///Seed the per-stripe random number generators.
+	void setSeed(uint64_t seed) {_seed = seed;};
+	///Randomly initialise and evaluate every cell.
+	bool init(void);
+	///Breed and evaluate one generation over the whole grid.
+	bool step(void);
+	///Return the width of the grid.
+	int getWidth(void) {return _width;};
+	///Return the height of the grid.
+	int getHeight(void) {return _height;};
+	///Return the number of cells in the grid.
+	int getSize(void) {return _width * _height;};
+	///Return the fitness of the chromosome at (x, y).
+	double getFitness(int x, int y) {return _fitness[_current][_cell(x, y)];};
+	///Return the genes of the chromosome at (x, y).
+	std::vector<ga2Gene> getGenes(int x, int y);
+	///Return the most fit chromosome.
+	std::vector<ga2Gene> getBestFitChromosome(void);
+	///Return the highest fitness value in the grid.
+	double getMaxFitness(void) {return _maxFitness;};
+	///Return the smallest fitness value in the grid.
+	double getMinFitness(void) {return _minFitness;};
+	///Return the average fitness of the grid.
+	double getAvgFitness(void) {return _avgFitness;};
+	///Return the sum of all fitness values in the grid.
+	double getSumFitness(void) {return _sumFitness;};
+	///Return the number of generations run since init().
+	long getGeneration(void) {return _generation;};
+	///Return the number of times the fitness function has been called.
+	long getEvaluationCount(void) {return _evaluations;};
+};
+
+#endif
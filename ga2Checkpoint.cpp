@@ -0,0 +1,245 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Checkpoint.cpp: implementation of the ga2Checkpoint class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ga2Checkpoint.h"
+
+#define GA2_PAGE 4096
+
+static uint64_t ga2Align(uint64_t offset)
+{
+	return (offset + GA2_PAGE - 1) & ~(uint64_t)(GA2_PAGE - 1);
+}
+
+static inline uint64_t ga2Rotl(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+/**
+ * \param data Start of the block
+ * \param bytes Length of the block
+ *
+ * A fast, non-cryptographic checksum in the style of xxHash: four
+ * independent lanes eat eight bytes each per round, so it runs at close to
+ * memory speed, and any flipped bit or truncated block changes the result.
+ */
+uint64_t ga2Checksum(const void *data, size_t bytes)
+{
+	const uint64_t P1 = 0x9E3779B185EBCA87ULL, P2 = 0xC2B2AE3D27D4EB4FULL;
+	const unsigned char *p = (const unsigned char *)data;
+	uint64_t lane[4] = { P1 + P2, P2, 0, 0 - P1 };
+	size_t i, blocks = bytes / 32;
+	for(i = 0; i < blocks; ++i, p += 32)
+	{
+		int k;
+		for(k = 0; k < 4; ++k)
+		{
+			uint64_t w;
+			memcpy(&w, p + 8*k, 8);
+			lane[k] = ga2Rotl(lane[k] + w * P2, 31) * P1;
+		}
+	}
+	uint64_t h = ga2Rotl(lane[0], 1) + ga2Rotl(lane[1], 7)
+			   + ga2Rotl(lane[2], 12) + ga2Rotl(lane[3], 18) + bytes;
+	for(i = blocks * 32; i < bytes; ++i, ++p)
+		h = ga2Rotl(h ^ (*p * P1), 11) * P2;
+	h ^= h >> 33;
+	h *= P2;
+	h ^= h >> 29;
+	return h;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+ga2Checkpoint::ga2Checkpoint()
+{
+	_fd = -1;
+	_map = NULL;
+	_mapSize = 0;
+	_writable = false;
+	_header = NULL;
+}
+
+/**
+ * Unmaps the file. Changes made to a writable file are kept by the
+ * operating system, but the checksums are only brought up to date by
+ * ga2Checkpoint::sync().
+ */
+ga2Checkpoint::~ga2Checkpoint()
+{
+	close();
+}
+
+void ga2Checkpoint::close(void)
+{
+	if(_map)
+		munmap(_map, _mapSize);
+	if(_fd >= 0)
+		::close(_fd);
+	_fd = -1;
+	_map = NULL;
+	_mapSize = 0;
+	_header = NULL;
+}
+
+bool ga2Checkpoint::_mapFile(const char *path, bool writable)
+{
+	close();
+	_fd = ::open(path, writable ? O_RDWR : O_RDONLY);
+	if(_fd < 0)
+		return false;
+	struct stat st;
+	if( (fstat(_fd, &st) != 0) || (st.st_size < (off_t)sizeof(ga2CheckpointHeader)) )
+	{
+		close();
+		return false;
+	}
+	_mapSize = st.st_size;
+	void *m = mmap(NULL, _mapSize, writable ? PROT_READ|PROT_WRITE : PROT_READ,
+				   MAP_SHARED, _fd, 0);
+	if(m == MAP_FAILED)
+	{
+		_map = NULL;
+		close();
+		return false;
+	}
+	_map = (unsigned char *)m;
+	_header = (ga2CheckpointHeader *)_map;
+	_writable = writable;
+	return true;
+}
+
+//sanity checks everything the accessors rely on, so a corrupt header can
+//never send them outside the mapping.
+bool ga2Checkpoint::_check(bool verifySections)
+{
+	const ga2CheckpointHeader *h = _header;
+	if(memcmp(h->magic, GA2_CHECKPOINT_MAGIC, 8) != 0)
+		return false;
+	if( (h->version != GA2_CHECKPOINT_VERSION) || (h->geneBytes != sizeof(ga2Gene)) )
+		return false;
+	if(ga2Checksum(h, offsetof(ga2CheckpointHeader, headerChecksum)) != h->headerChecksum)
+		return false;
+	if(h->fileSize != _mapSize)
+		return false;
+	uint64_t n = h->size, L = h->chromoSize;
+	if( (h->rangesOffset + 2*L*sizeof(float) > _mapSize)
+	  ||(h->fitnessOffset + n*sizeof(double) > _mapSize)
+	  ||(h->evaluatedOffset + n > _mapSize)
+	  ||(h->genesOffset + n*L*sizeof(ga2Gene) > _mapSize) )
+		return false;
+	if(verifySections)
+		return verify();
+	return true;
+}
+
+/**
+ * \param path File to open
+ * \param writable Map the file read-write, for updating in place
+ * \param verify Check the checksum of every section. Turning this off
+ * makes opening instant but only the header is checked.
+ *
+ * Returns false, leaving nothing open, if the file cannot be mapped, is
+ * not a population file, was written with a different version or ga2Gene
+ * type, or is corrupt.
+ */
+bool ga2Checkpoint::open(const char *path, bool writable, bool verify)
+{
+	if(!_mapFile(path, writable))
+		return false;
+	if(!_check(verify))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * \param path File to create; an existing file is truncated.
+ * \param size Number of chromosomes
+ * \param chromoSize Number of genes per chromosome
+ *
+ * Lays out an empty population file and maps it read-write. Fill in the
+ * sections through the accessors, then call ga2Checkpoint::sync().
+ */
+bool ga2Checkpoint::create(const char *path, int size, int chromoSize)
+{
+	close();
+	ga2CheckpointHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, GA2_CHECKPOINT_MAGIC, 8);
+	h.version = GA2_CHECKPOINT_VERSION;
+	h.geneBytes = sizeof(ga2Gene);
+	h.size = size;
+	h.chromoSize = chromoSize;
+	h.rangesOffset = ga2Align(sizeof(h));
+	h.fitnessOffset = ga2Align(h.rangesOffset + 2 * h.chromoSize * sizeof(float));
+	h.evaluatedOffset = ga2Align(h.fitnessOffset + h.size * sizeof(double));
+	h.genesOffset = ga2Align(h.evaluatedOffset + h.size);
+	h.fileSize = h.genesOffset + h.size * h.chromoSize * sizeof(ga2Gene);
+
+	int fd = ::open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+	if(fd < 0)
+		return false;
+	bool ok = (ftruncate(fd, h.fileSize) == 0)
+		   && (pwrite(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h));
+	::close(fd);
+	return ok && _mapFile(path, true);
+}
+
+/**
+ * Recomputes every checksum of a writable file, then flushes the mapping
+ * to disk and waits for it to get there.
+ */
+bool ga2Checkpoint::sync(void)
+{
+	if(!_map || !_writable)
+		return false;
+	ga2CheckpointHeader *h = _header;
+	h->rangesChecksum = ga2Checksum(getMinRanges(), 2 * h->chromoSize * sizeof(float));
+	h->fitnessChecksum = ga2Checksum(getFitness(), h->size * sizeof(double));
+	h->evaluatedChecksum = ga2Checksum(getEvaluated(), h->size);
+	h->genesChecksum = ga2Checksum(getGeneMatrix(), h->size * h->chromoSize * sizeof(ga2Gene));
+	h->headerChecksum = ga2Checksum(h, offsetof(ga2CheckpointHeader, headerChecksum));
+	return msync(_map, _mapSize, MS_SYNC) == 0;
+}
+
+/**
+ * Reads every section once and compares it with the checksum stored in
+ * the header.
+ */
+bool ga2Checkpoint::verify(void)
+{
+	if(!_map)
+		return false;
+	const ga2CheckpointHeader *h = _header;
+	return (ga2Checksum(getMinRanges(), 2 * h->chromoSize * sizeof(float)) == h->rangesChecksum)
+		&& (ga2Checksum(getFitness(), h->size * sizeof(double)) == h->fitnessChecksum)
+		&& (ga2Checksum(getEvaluated(), h->size) == h->evaluatedChecksum)
+		&& (ga2Checksum(getGeneMatrix(), h->size * h->chromoSize * sizeof(ga2Gene)) == h->genesChecksum);
+}
@@ -0,0 +1,133 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Checkpoint.h: interface for the ga2Checkpoint class, and the binary
+//                  population file format it reads and writes.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2CHECKPOINT_H__
+#define __GA2CHECKPOINT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ga2Gene.h"
+
+#define GA2_CHECKPOINT_MAGIC "GA2CKPT"
+#define GA2_CHECKPOINT_VERSION 1
+
+///The first bytes of a binary population file.
+/**
+ * All offsets are in bytes from the start of the file, and every section
+ * starts on a page boundary so it can be mapped and advised on its own.
+ * The sections are: the minimum ranges then the maximum ranges (one float
+ * per gene each), the fitness values (one double per chromosome), the
+ * evaluated flags (one byte per chromosome) and the genes (chromoSize
+ * ga2Genes per chromosome, chromosome after chromosome). Numbers are in
+ * the byte order of the machine that wrote the file; a file from a machine
+ * of the other order fails the checksum and is rejected.
+ */
+struct ga2CheckpointHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t geneBytes;
+	uint64_t size;
+	uint64_t chromoSize;
+	uint64_t generation;
+	uint64_t rangesOffset;
+	uint64_t fitnessOffset;
+	uint64_t evaluatedOffset;
+	uint64_t genesOffset;
+	uint64_t fileSize;
+	uint64_t rangesChecksum;
+	uint64_t fitnessChecksum;
+	uint64_t evaluatedChecksum;
+	uint64_t genesChecksum;
+	uint64_t headerChecksum; //of all the fields above
+};
+
+///Return a 64 bit checksum of a block of memory.
+uint64_t ga2Checksum(const void *data, size_t bytes);
+
+///A population file, mapped into memory.
+/**
+ * The ga2Checkpoint class gives direct access to a binary population
+ * file through mmap(): there is nothing to parse, and opening even a very
+ * large file costs little more than checking its checksums. Use
+ * ga2Population::writeCheckpoint() and ga2Population::readCheckpoint() to
+ * save and restore a population; use this class directly to inspect a file
+ * or to build one from something other than a ga2Population.
+ *
+ * A file can be opened read-only, or created (or opened) read-write, in
+ * which case the sections may be modified in place and
+ * ga2Checkpoint::sync() recomputes the checksums and flushes everything to
+ * disk.
+ */
+class ga2Checkpoint
+{
+	int _fd;
+	unsigned char *_map;
+	size_t _mapSize;
+	bool _writable;
+	ga2CheckpointHeader *_header;
+
+	bool _mapFile(const char *path, bool writable);
+	bool _check(bool verify);
+
+public:
+	///The constructor.
+	ga2Checkpoint();
+	///The destructor. Unmaps the file without syncing it.
+	virtual ~ga2Checkpoint();
+	///Map an existing file, checking its header and, optionally, its checksums.
+	bool open(const char *path, bool writable = false, bool verify = true);
+	///Create (or truncate) a file laid out for a population, and map it read-write.
+	bool create(const char *path, int size, int chromoSize);
+	///Recompute the checksums and flush a writable file to disk.
+	bool sync(void);
+	///Unmap the file.
+	void close(void);
+	///Is a file mapped?
+	bool isOpen(void) {return _map != NULL;};
+	///Check every section against its checksum.
+	bool verify(void);
+	///Return the number of chromosomes in the file.
+	int getSize(void) {return _header->size;};
+	///Return the number of genes per chromosome.
+	int getChromoSize(void) {return _header->chromoSize;};
+	///Return the generation number stored with the population.
+	uint64_t getGeneration(void) {return _header->generation;};
+	///Set the generation number stored with the population.
+	void setGeneration(uint64_t g) {_header->generation = g;};
+	///Return the minimum value of each gene.
+	float *getMinRanges(void) {return (float *)(_map + _header->rangesOffset);};
+	///Return the maximum value of each gene.
+	float *getMaxRanges(void) {return getMinRanges() + _header->chromoSize;};
+	///Return the fitness of every chromosome.
+	double *getFitness(void) {return (double *)(_map + _header->fitnessOffset);};
+	///Return whether each chromosome has been evaluated (non-zero) or not.
+	unsigned char *getEvaluated(void) {return _map + _header->evaluatedOffset;};
+	///Return the genes of one chromosome.
+	ga2Gene *getGenes(int index)
+		{return (ga2Gene *)(_map + _header->genesOffset) + (size_t)index * _header->chromoSize;};
+	///Return the start of the gene matrix.
+	ga2Gene *getGeneMatrix(void) {return (ga2Gene *)(_map + _header->genesOffset);};
+	///Return the file header.
+	const ga2CheckpointHeader *getHeader(void) {return _header;};
+};
+
+#endif
@@ -19,11 +19,44 @@
 //////////////////////////////////////////////////////////////////////
 
 #include <iostream>
+#include <algorithm>
 #include "ga2Chromosome.h"
+#include "ga2FitnessCache.h"
 #include <stdlib.h>
 #include <time.h>
 #include <vector>
 #include <math.h>
+#include <atomic>
+
+static std::atomic<uint64_t> ga2NextChromosomeId(1);
+static std::atomic<int> ga2AllocationCounters(0);
+static std::atomic<long> ga2Allocations(0);
+
+//a relaxed load, and nothing more, unless someone is counting
+static inline void ga2CountAllocation(void)
+{
+	if(ga2AllocationCounters.load(std::memory_order_relaxed))
+		ga2Allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+//identifiers are handed out from all threads, hence the atomic
+uint64_t ga2Chromosome::_newId(void)
+{
+	return ga2NextChromosomeId++;
+}
+
+void ga2Chromosome::countAllocations(bool val)
+{
+	if(val)
+		++ga2AllocationCounters;
+	else
+		--ga2AllocationCounters;
+}
+
+long ga2Chromosome::getAllocationCount(void)
+{
+	return ga2Allocations.load(std::memory_order_relaxed);
+}
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -39,6 +72,12 @@ ga2Chromosome::ga2Chromosome( int initialSize ) : _size(initialSize)
 	_genes.reserve(_size);
 	_isEvaluated = false;
 	_crossSite = -1;
+	_operator = -1;
+	_parentFitness = 0.0;
+	_parent[0] = _parent[1] = -1;
+	_id = _newId();
+	_cache = NULL;
+	ga2CountAllocation();
 }
 
 /**
@@ -49,6 +88,33 @@ ga2Chromosome::ga2Chromosome()
 {
 	_isEvaluated = false;
 	_crossSite = -1;
+	_operator = -1;
+	_parentFitness = 0.0;
+	_parent[0] = _parent[1] = -1;
+	_id = _newId();
+	_cache = NULL;
+	ga2CountAllocation();
+}
+
+/**
+ * Copies everything, including the identifier (see ga2Chromosome::getId()).
+ */
+ga2Chromosome::ga2Chromosome( const ga2Chromosome &a ) : _size(a._size),
+														 _genes(a._genes),
+														 _geneMinRanges(a._geneMinRanges),
+														 _geneMaxRanges(a._geneMaxRanges),
+														 _fitness(a._fitness),
+														 _isEvaluated(a._isEvaluated),
+														 _evalFunc(a._evalFunc),
+														 _crossSite(a._crossSite),
+														 _operator(a._operator),
+														 _parentFitness(a._parentFitness),
+														 _id(a._id),
+														 _cache(a._cache)
+{
+	_parent[0] = a._parent[0];
+	_parent[1] = a._parent[1];
+	ga2CountAllocation();
 }
 
 /**
@@ -100,6 +166,29 @@ bool ga2Chromosome::randomInit( bool doTrunc )
 
 	//lastly, trip the not evaluated flag
 	_isEvaluated = false;
+	_id = _newId();
+	return true;
+}
+
+/**
+ * Sets the genes to a random ordering of 0, 1, ... size - 1, by a
+ * Fisher-Yates shuffle, for problems whose solutions are orderings (see
+ * ga2Population::setPermutation()). The ranges are not used.
+ * \bug Uses rand(), like ga2Chromosome::randomInit().
+ */
+bool ga2Chromosome::randomPermutation(void)
+{
+	int i;
+	_genes.resize(_size);
+	for(i = 0; i < _size; ++i)
+		_genes[i] = i;
+	for(i = _size - 1; i > 0; --i)
+	{
+		int j = ((double)rand() / ((double)RAND_MAX + 1.0)) * (i + 1);
+		std::swap(_genes[i], _genes[j]);
+	}
+	_isEvaluated = false;
+	_id = _newId();
 	return true;
 }
 
@@ -121,6 +210,7 @@ ga2Chromosome *ga2Chromosome::grabSlice( int start, int end )
 {
 	ga2Chromosome *retval = new ga2Chromosome(end-start);
 	retval->_evalFunc = this->_evalFunc;
+	retval->_cache = this->_cache;
 	int i;
 	for( i = start; i < end; ++i)
 	{
@@ -164,8 +254,17 @@ double ga2Chromosome::evaluate( void )
 		return 0; //there has to be a better way to deal with this case.
 	else
 	{
+		double f;
 		_isEvaluated = true;
-		_fitness = _evalFunc(_genes);
+		if(_cache && _cache->lookup(_genes, f))
+			_fitness = f;
+		else
+		{
+			_fitness = _evalFunc(_genes);
+			if(_cache)
+				_cache->store(_genes, _fitness);
+		}
+		_id = _newId();
 		return _fitness;
 	}
 }
@@ -251,6 +350,7 @@ void ga2Chromosome::setGenes(std::vector<ga2Gene> genes)
 		_genes.push_back(genes[i]);
 	}
 	_isEvaluated = false;
+	_id = _newId();
 }
 
 /**
@@ -262,6 +362,7 @@ ga2Chromosome& ga2Chromosome::operator+( ga2Chromosome &a )
 {
 	ga2Chromosome *retval = new ga2Chromosome(a.getSize() + this->getSize());
 	retval->_evalFunc = a._evalFunc;
+	retval->_cache = a._cache;
 	int i;
 	for(i = 0; i < a._genes.size(); ++i)
 	{
@@ -284,9 +385,13 @@ ga2Chromosome& ga2Chromosome::operator+( ga2Chromosome &a )
 ga2Chromosome& ga2Chromosome::operator=(const ga2Chromosome &a)
 {
 	_crossSite = a._crossSite;
+	_operator = a._operator;
+	_parentFitness = a._parentFitness;
 	_evalFunc = a._evalFunc;
+	_cache = a._cache;
 	_fitness = a._fitness;
 	_isEvaluated = a._isEvaluated;
+	_id = a._id;
 	_parent[0] = a._parent[0];
 	_parent[1] = a._parent[1];
 	_size = a._size;
@@ -356,6 +461,7 @@ std::istream& operator>> ( std::istream &in, ga2Chromosome &chromo )
 		chromo._isEvaluated = true;
 	else
 		chromo._isEvaluated = false;
+	chromo._id = ga2Chromosome::_newId();
 	chromo._genes.clear();
 	for(i = 0; i < chromo._size; ++i)
 	{
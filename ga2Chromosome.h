@@ -23,8 +23,11 @@
 
 #include <iostream>
 #include <vector>
+#include <stdint.h>
 #include "ga2Gene.h"
 
+class ga2FitnessCache;
+
 ///A class representing a chromosome i.e., a member of the population.
 /**
  * The ga2Chromosome class represents a single chromosome in a population.
@@ -33,6 +36,10 @@
  */
 class ga2Chromosome
 {
+	friend class ga2Population;
+	friend class ga2DifferentialEvolution;
+	friend class ga2CMAES;
+
 	int _size;
 	std::vector< ga2Gene > _genes;
 	//I'd like not to have to set these ranges for every friggen chromosome...
@@ -43,21 +50,38 @@ class ga2Chromosome
 	double(* _evalFunc)(std::vector<ga2Gene>);
 	int _parent[2];
 	int _crossSite;
+	int _operator; //crossover type that made it, 0 if only mutated, -1 if neither
+	double _parentFitness; //the fitter parent's, for crediting the operators
+	uint64_t _id;
+	ga2FitnessCache *_cache;
+	static uint64_t _newId(void);
 public:
 	///The constructor
 	ga2Chromosome();
 	///Constructor that initializes the size of the chromosome. Probably more useful.
 	ga2Chromosome( int initialSize );
+	///Copy constructor.
+	ga2Chromosome( const ga2Chromosome &a );
 	///The destructor
 	virtual ~ga2Chromosome();
 	///Randomly initialises the chromosome.
 	bool randomInit(bool doTrunc);
+	///Randomly initialises the chromosome as a permutation.
+	bool randomPermutation(void);
 	///Grabs an arbitrary slice of a chromosome.
 	ga2Chromosome *grabSlice(int start, int end);
 	///Sets the evaluation function that gets called.
 	void setEvalFunc(double(* func)(std::vector<ga2Gene>));
 	///Evaluate this chromosome.
 	double evaluate(void);
+	///Looks fitness values up in a cache before calling the fitness function.
+	/**
+	 * \param cache The cache to use, or NULL for none.
+	 *
+	 * Values the fitness function returns are added to the cache. See
+	 * ga2FitnessCache.
+	 */
+	void setFitnessCache(ga2FitnessCache *cache) {_cache = cache;};
 	///Returns the size of the chromosome.
 	/**
 	 * Returns the size of the chromosome as set by the constructor
@@ -68,6 +92,36 @@ public:
 	void setSize(int newSize) {_size = newSize; _genes.reserve(_size);};
 	///Returns the fitness of a chromosome.
 	double getFitness(void);
+	///Has the chromosome been evaluated since it last changed?
+	bool isEvaluated(void) {return _isEvaluated;};
+	///Sets the fitness of a chromosome without calling the fitness function.
+	/**
+	 * \param fitness The fitness to record.
+	 *
+	 * Marks the chromosome as evaluated. Used when restoring a population
+	 * whose fitness values were saved along with it.
+	 */
+	void setFitness(double fitness) {_fitness = fitness; _isEvaluated = true; _id = _newId();};
+	///Start or stop counting chromosome constructions.
+	/**
+	 * \param val true to count, false to stop. Calls nest: counting goes on
+	 * until there has been a false for every true.
+	 *
+	 * Every chromosome constructed or copied, in any thread, is counted while
+	 * anyone is counting; otherwise nothing is done. Used by ga2Profiler.
+	 */
+	static void countAllocations(bool val);
+	///Returns the number of chromosomes constructed while counting.
+	static long getAllocationCount(void);
+	///Returns an identifier for the chromosome's current contents.
+	/**
+	 * A chromosome gets a new, never before used identifier whenever its
+	 * genes or its fitness change; copies share the identifier of the
+	 * original. Two chromosomes with the same identifier are therefore
+	 * guaranteed to have the same genes and fitness, which lets a
+	 * population's changes be tracked without comparing genes.
+	 */
+	uint64_t getId(void) {return _id;};
 	///Sets the minimum values for each gene.
 	void setMinRanges(std::vector<float> ranges);
 	///Sets the maximum values for each gene.
@@ -96,7 +150,14 @@ public:
 	 * Sets the value of a particular gene.
 	 * \bug Does not check against upper and lower bounds for that gene.
 	 */
-	void setGene(int index, ga2Gene value) {_genes[index] = value; _isEvaluated = false;};
+	void setGene(int index, ga2Gene value) {_genes[index] = value; _isEvaluated = false; _id = _newId();};
+	///Returns the gene located at index.
+	/**
+	 * \param index Index of the gene to return
+	 *
+	 * Unlike ga2Chromosome::getGenes(), copies nothing but the one gene.
+	 */
+	ga2Gene getGene(int index) {return _genes[index];};
 	///Returns a vector of the chromosome's genes.
 	/**
 	 * Returns a vector containing the chromosome's genes.
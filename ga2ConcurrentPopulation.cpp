@@ -0,0 +1,338 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2ConcurrentPopulation.cpp: implementation of the
+//                              ga2ConcurrentPopulation class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <float.h>
+#include <string.h>
+#include <thread>
+#include "ga2.h"
+
+//evaluates the initial population; handed to the scheduler.
+class ga2ConcurrentInitTask : public ga2Task
+{
+	ga2ConcurrentPopulation &_pop;
+public:
+	ga2ConcurrentInitTask(ga2ConcurrentPopulation &pop) : _pop(pop) {};
+	void run(int begin, int end)
+	{
+		int L = _pop._chromoSize, i;
+		std::vector<ga2Gene> genes(L);
+		for(i = begin; i < end; ++i)
+		{
+			genes.assign(&_pop._genes[(size_t)i * L], &_pop._genes[(size_t)i * L] + L);
+			_pop._fitness[i].store(_pop._evalFunc ? _pop._evalFunc(genes) : 0.0);
+		}
+	};
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param size Number of chromosomes in the population
+ * \param chromoSize Number of genes per chromosome
+ * \param shardSize Number of chromosomes per shard. Smaller shards mean
+ * less contention between inserting threads, but each shard keeps only
+ * its own best, so very small shards weaken selection pressure.
+ */
+ga2ConcurrentPopulation::ga2ConcurrentPopulation( int size, int chromoSize, int shardSize )
+	: _size(size), _chromoSize(chromoSize), _shardSize(shardSize),
+	  _fitness(size), _slotLock(size)
+{
+	if(_shardSize < 1)
+		_shardSize = 1;
+	if(_shardSize > _size)
+		_shardSize = _size;
+	_numShards = (_size + _shardSize - 1) / _shardSize;
+	_evalFunc = NULL;
+	_scheduler = NULL;
+	_mutationRate = 0.0;
+	_crossoverRate = 1.0;
+	_crossoverType = GA2_CROSSOVER_ONEPOINT;
+	_tournamentSize = 2;
+	_integer = false;
+	_maxFitness = -DBL_MAX;
+	_inserts = 0;
+	_rejects = 0;
+	_genes.resize((size_t)_size * _chromoSize);
+
+	int i;
+	for(i = 0; i < _size; ++i)
+	{
+		_fitness[i].store(0.0);
+		_slotLock[i].store(0);
+	}
+	for(i = 0; i < _numShards; ++i)
+	{
+		_shards.push_back(new _Shard);
+		_shards[i]->worst = i * _shardSize;
+	}
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2ConcurrentPopulation::~ga2ConcurrentPopulation()
+{
+	int i;
+	for(i = 0; i < _numShards; ++i)
+		delete _shards[i];
+	_shards.clear();
+}
+
+void ga2ConcurrentPopulation::_lockSlot(int slot)
+{
+	char expected = 0;
+	while(!_slotLock[slot].compare_exchange_weak(expected, 1, std::memory_order_acquire))
+	{
+		expected = 0;
+		std::this_thread::yield();
+	}
+}
+
+ga2Gene ga2ConcurrentPopulation::_randomGene(ga2Random &rng, int i)
+{
+	float range = _chromoMaxRanges[i] - _chromoMinRanges[i];
+	float f;
+	if(_integer)
+	{
+		f = (rng.uniform() * (range+1)) + _chromoMinRanges[i];
+		f = (int)f; //trunc it down to size
+	}
+	else //no rounding
+		f = (rng.uniform() * range) + _chromoMinRanges[i];
+	return f;
+}
+
+/**
+ * \param seed Seed for the random initialisation.
+ *
+ * Fills every slot with random genes within the ranges and evaluates
+ * them, on the scheduler if one has been set. Must not run at the same
+ * time as anything else on this population.
+ */
+bool ga2ConcurrentPopulation::init(uint64_t seed)
+{
+	if( (_chromoMaxRanges.size() != _chromoSize)
+	  ||(_chromoMinRanges.size() != _chromoSize) )
+		return false;
+
+	ga2Random rng(seed);
+	int i, j;
+	for(i = 0; i < _size; ++i)
+		for(j = 0; j < _chromoSize; ++j)
+			_genes[(size_t)i * _chromoSize + j] = _randomGene(rng, j);
+
+	ga2ConcurrentInitTask task(*this);
+	if(_scheduler)
+		_scheduler->parallelFor(task, _size);
+	else
+		task.run(0, _size);
+
+	_maxFitness = -DBL_MAX;
+	for(i = 0; i < _numShards; ++i)
+		_findWorst(i);
+	for(i = 0; i < _size; ++i)
+		_noteBest(&_genes[(size_t)i * _chromoSize], _fitness[i].load());
+	_inserts = 0;
+	_rejects = 0;
+	return true;
+}
+
+//only called with the shard's lock held (or before anyone else can see
+//the population), so nothing can change the fitnesses being scanned.
+void ga2ConcurrentPopulation::_findWorst(int shard)
+{
+	int begin = shard * _shardSize;
+	int end = begin + _shardSize < _size ? begin + _shardSize : _size;
+	int worst = begin, i;
+	double f = _fitness[begin].load(std::memory_order_relaxed);
+	for(i = begin+1; i < end; ++i)
+	{
+		double g = _fitness[i].load(std::memory_order_relaxed);
+		if(g < f)
+		{
+			f = g;
+			worst = i;
+		}
+	}
+	_shards[shard]->worst = worst;
+}
+
+void ga2ConcurrentPopulation::_noteBest(const ga2Gene *genes, double fitness)
+{
+	if(fitness <= _maxFitness.load(std::memory_order_relaxed))
+		return;
+	std::lock_guard<std::mutex> l(_bestLock);
+	if(fitness <= _maxFitness.load())
+		return;
+	_bestGenes.assign(genes, genes + _chromoSize);
+	_maxFitness.store(fitness);
+}
+
+/**
+ * \param rng The calling thread's random number generator.
+ * \param genes Receives a copy of the chosen chromosome's genes.
+ * \param fitness Receives the chosen chromosome's fitness.
+ *
+ * Looks at ga2ConcurrentPopulation::setTournamentSize() random slots
+ * anywhere in the population and copies out the fittest. The genes and
+ * fitness returned always belong together, even if the slot is replaced
+ * a moment later. Returns the slot chosen.
+ */
+int ga2ConcurrentPopulation::sample(ga2Random &rng, std::vector<ga2Gene> &genes, double &fitness)
+{
+	int best = rng.below(_size), k;
+	double f = _fitness[best].load(std::memory_order_relaxed);
+	for(k = 1; k < _tournamentSize; ++k)
+	{
+		int c = rng.below(_size);
+		double g = _fitness[c].load(std::memory_order_relaxed);
+		if(g > f)
+		{
+			f = g;
+			best = c;
+		}
+	}
+
+	genes.resize(_chromoSize);
+	_lockSlot(best);
+	memcpy(&genes[0], &_genes[(size_t)best * _chromoSize], _chromoSize * sizeof(ga2Gene));
+	fitness = _fitness[best].load(std::memory_order_relaxed);
+	_unlockSlot(best);
+	return best;
+}
+
+/**
+ * \param rng The calling thread's random number generator; picks the
+ * shard.
+ * \param genes The chromosome to offer.
+ * \param fitness Its fitness.
+ *
+ * Offers a chromosome to a random shard. It replaces the least fit member
+ * of that shard if it is fitter, and is dropped otherwise. Returns true if
+ * it was kept.
+ */
+bool ga2ConcurrentPopulation::insert(ga2Random &rng, const std::vector<ga2Gene> &genes, double fitness)
+{
+	if(genes.size() != _chromoSize)
+		return false;
+	int s = rng.below(_numShards);
+	_Shard *shard = _shards[s];
+	std::lock_guard<std::mutex> l(shard->lock);
+	int slot = shard->worst;
+	if(fitness <= _fitness[slot].load(std::memory_order_relaxed))
+	{
+		++_rejects;
+		return false;
+	}
+	_lockSlot(slot);
+	memcpy(&_genes[(size_t)slot * _chromoSize], &genes[0], _chromoSize * sizeof(ga2Gene));
+	_fitness[slot].store(fitness, std::memory_order_relaxed);
+	_unlockSlot(slot);
+	_findWorst(s);
+	++_inserts;
+	_noteBest(&genes[0], fitness);
+	return true;
+}
+
+/**
+ * \param rng The calling thread's random number generator.
+ *
+ * One complete asynchronous breeding step: two parents from
+ * ga2ConcurrentPopulation::sample(), crossover, mutation, evaluation and
+ * ga2ConcurrentPopulation::insert(). Meant to be called in a loop by each
+ * thread. Returns true if the child was kept.
+ */
+bool ga2ConcurrentPopulation::breed(ga2Random &rng)
+{
+	std::vector<ga2Gene> a, b;
+	double fa, fb;
+	sample(rng, a, fa);
+	sample(rng, b, fb);
+
+	int i;
+	if(rng.uniform() <= _crossoverRate)
+	{
+		if(_crossoverType == GA2_CROSSOVER_UNIFORM)
+		{
+			for(i = 0; i < _chromoSize; ++i)
+				if(rng.next() >> 63)
+					a[i] = b[i];
+		}
+		else
+		{
+			for(i = rng.below(_chromoSize); i < _chromoSize; ++i)
+				a[i] = b[i];
+		}
+	}
+	for(i = 0; i < _chromoSize; ++i)
+		if(rng.uniform() <= _mutationRate)
+			a[i] = _randomGene(rng, i);
+
+	double f = _evalFunc ? _evalFunc(a) : 0.0;
+	return insert(rng, a, f);
+}
+
+/**
+ * Scans the population for its average fitness. With threads inserting
+ * concurrently, the result mixes slightly different moments.
+ */
+double ga2ConcurrentPopulation::getAvgFitness(void)
+{
+	double sum = 0.0;
+	int i;
+	for(i = 0; i < _size; ++i)
+		sum += _fitness[i].load(std::memory_order_relaxed);
+	return sum / _size;
+}
+
+/**
+ * Returns a copy of the genes of the fittest chromosome ever accepted,
+ * even if it has since been pushed out of its shard.
+ */
+std::vector<ga2Gene> ga2ConcurrentPopulation::getBestFitChromosome(void)
+{
+	std::lock_guard<std::mutex> l(_bestLock);
+	return _bestGenes;
+}
+
+/**
+ * \param ranges A vector containing the upper bound for the values of each
+ * gene.
+ */
+void ga2ConcurrentPopulation::setMaxRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMaxRanges = ranges;
+}
+
+/**
+ * \param ranges A vector containing the lower bound for the values of each
+ * gene.
+ */
+void ga2ConcurrentPopulation::setMinRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMinRanges = ranges;
+}
@@ -0,0 +1,148 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2ConcurrentPopulation.h: interface for the ga2ConcurrentPopulation
+//                            class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2CONCURRENTPOPULATION_H__
+#define __GA2CONCURRENTPOPULATION_H__
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "ga2Gene.h"
+#include "ga2Random.h"
+#include "ga2Scheduler.h"
+
+///A steady-state population that many threads can breed from at once.
+/**
+ * The ga2ConcurrentPopulation class is for asynchronous GAs, where every
+ * thread loops on its own: pick parents, breed, evaluate, put the child
+ * back. There is no generation and no barrier, so a slow evaluation only
+ * ever holds up the thread doing it.
+ *
+ * The population is split into shards of equal size. Each shard is a
+ * small steady-state population in its own right, with the semantics of
+ * GA2_REPLACE_STEADYSTATE: a child offered to a shard replaces the shard's
+ * least fit member if, and only if, it is fitter. Offers to a shard are
+ * serialised by the shard's lock, and offers to different shards do not
+ * interact at all. Reading is finer still: every slot has its own spin
+ * lock, held only while its genes are copied in or out, so readers never
+ * wait on a shard and never wait on each other except for the same slot.
+ *
+ * The consistency model is as follows.
+ * - A slot always holds a complete (genes, fitness) pair from a single
+ *   insertion; ga2ConcurrentPopulation::sample() returns such a pair.
+ * - Each shard is linearizable: its contents are always exactly what a
+ *   sequential steady-state population would hold after the same offers
+ *   in some order consistent with real time. In particular a shard always
+ *   holds the best members of everything ever offered to it.
+ * - There is no snapshot of the whole population. Scans such as
+ *   ga2ConcurrentPopulation::getAvgFitness() see each slot at a slightly
+ *   different moment.
+ * - The best fitness seen never decreases.
+ */
+class ga2ConcurrentPopulation
+{
+	struct _Shard
+	{
+		std::mutex lock;
+		int worst;
+	};
+
+	int _size;
+	int _chromoSize;
+	int _shardSize;
+	int _numShards;
+
+	double(* _evalFunc)(std::vector<ga2Gene>);
+	ga2Scheduler *_scheduler;
+	std::vector<float> _chromoMaxRanges;
+	std::vector<float> _chromoMinRanges;
+	double _mutationRate;
+	double _crossoverRate;
+	int _crossoverType;
+	int _tournamentSize;
+	bool _integer;
+
+	std::vector<ga2Gene> _genes;
+	std::vector< std::atomic<double> > _fitness;
+	std::vector< std::atomic<char> > _slotLock;
+	std::vector<_Shard *> _shards;
+
+	std::mutex _bestLock;
+	std::atomic<double> _maxFitness;
+	std::vector<ga2Gene> _bestGenes;
+	std::atomic<long> _inserts;
+	std::atomic<long> _rejects;
+
+	friend class ga2ConcurrentInitTask;
+	void _lockSlot(int slot);
+	void _unlockSlot(int slot) {_slotLock[slot].store(0, std::memory_order_release);};
+	void _findWorst(int shard);
+	void _noteBest(const ga2Gene *genes, double fitness);
+	ga2Gene _randomGene(ga2Random &rng, int i);
+
+public:
+	///The constructor.
+	ga2ConcurrentPopulation( int size, int chromoSize, int shardSize = 64 );
+	///The destructor.
+	virtual ~ga2ConcurrentPopulation();
+	///Set the evaluation function to use. Must be thread safe.
+	void setEvalFunc(double (* func)(std::vector<ga2Gene>)) {_evalFunc = func;};
+	///Set the scheduler used to evaluate the initial population.
+	void setScheduler(ga2Scheduler *sched) {_scheduler = sched;};
+	///Set the minimum values for each gene.
+	void setMinRanges(std::vector<float> ranges);
+	///Set the maximum values for each gene.
+	void setMaxRanges(std::vector<float> ranges);
+	///Set the probability of a gene mutating in breed().
+	void setMutationRate(float mRate) {_mutationRate = mRate;};
+	///Set the probability of crossing-over in breed().
+	void setCrossoverRate(float cRate) {_crossoverRate = cRate;};
+	///Set the crossover used by breed(): GA2_CROSSOVER_ONEPOINT or GA2_CROSSOVER_UNIFORM.
+	void setCrossoverType(int type) {_crossoverType = type;};
+	///Set how many slots a parent is picked from in sample().
+	void setTournamentSize(int k) {_tournamentSize = k < 1 ? 1 : k;};
+	///Are we using integer genes or floating point genes?
+	void setInteger(bool val) {_integer = val;};
+	///Randomly initialise and evaluate every slot. Not thread safe.
+	bool init(uint64_t seed);
+	///Copy out a parent chosen by tournament. Thread safe.
+	int sample(ga2Random &rng, std::vector<ga2Gene> &genes, double &fitness);
+	///Offer a chromosome to a shard, replacing its worst if fitter. Thread safe.
+	bool insert(ga2Random &rng, const std::vector<ga2Gene> &genes, double fitness);
+	///Sample two parents, breed, evaluate and insert one child. Thread safe.
+	bool breed(ga2Random &rng);
+	///Return the size of the population.
+	int getSize(void) {return _size;};
+	///Return the number of shards.
+	int getNumShards(void) {return _numShards;};
+	///Return the highest fitness ever accepted.
+	double getMaxFitness(void) {return _maxFitness.load();};
+	///Return the average fitness of the population.
+	double getAvgFitness(void);
+	///Return the most fit chromosome.
+	std::vector<ga2Gene> getBestFitChromosome(void);
+	///Return the number of offers accepted.
+	long getInsertCount(void) {return _inserts.load();};
+	///Return the number of offers turned down.
+	long getRejectCount(void) {return _rejects.load();};
+};
+
+#endif
@@ -0,0 +1,317 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2DeltaCheckpoint.cpp: implementation of the ga2DeltaCheckpoint class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "ga2.h"
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param path Where the full checkpoint lives. The delta log is kept
+ * alongside, with ".delta" appended.
+ *
+ * Nothing is read or written until ga2DeltaCheckpoint::write() or
+ * ga2DeltaCheckpoint::read() is called. The first write() is always a
+ * full checkpoint; call read() first to carry on from an existing one.
+ */
+ga2DeltaCheckpoint::ga2DeltaCheckpoint( const char *path ) : _path(path)
+{
+	_deltaPath = _path + ".delta";
+	_fd = -1;
+	_haveBase = false;
+	_baseChecksum = 0;
+	_baseBytes = 0;
+	_deltaBytes = 0;
+	_deltaCount = 0;
+	_maxDeltas = 100;
+	_maxRatio = 1.0;
+	_sync = false;
+	_lastWriteBytes = 0;
+	_lastWriteFull = false;
+}
+
+/**
+ * Destructor. Closes the delta log.
+ */
+ga2DeltaCheckpoint::~ga2DeltaCheckpoint()
+{
+	if(_fd >= 0)
+		close(_fd);
+}
+
+bool ga2DeltaCheckpoint::_openLog(bool truncate)
+{
+	if(_fd >= 0)
+		close(_fd);
+	_fd = open(_deltaPath.c_str(), O_WRONLY|O_CREAT|O_APPEND|(truncate ? O_TRUNC : 0), 0644);
+	return _fd >= 0;
+}
+
+//records which chromosome sits in which slot, as of what is on disk
+void ga2DeltaCheckpoint::_remember(ga2Population &pop)
+{
+	_slotOf.clear();
+	int i, n = pop._chromosomes.size() < pop._size ? pop._chromosomes.size() : pop._size;
+	for(i = 0; i < n; ++i)
+		_slotOf[pop._chromosomes[i].getId()] = i;
+}
+
+/**
+ * \param pop The population to save
+ * \param generation A generation number to save with it
+ *
+ * Writes a full checkpoint with ga2Population::writeCheckpoint(), then
+ * empties the delta log. Should the process die in between, the old
+ * records no longer match the new checkpoint and are ignored.
+ */
+bool ga2DeltaCheckpoint::writeFull(ga2Population &pop, unsigned long generation)
+{
+	pop.flush();
+	if(!pop.writeCheckpoint(_path.c_str(), generation))
+		return false;
+	ga2Checkpoint ckpt;
+	if(!ckpt.open(_path.c_str(), false, false))
+		return false;
+	_baseChecksum = ckpt.getHeader()->headerChecksum;
+	_baseBytes = ckpt.getHeader()->fileSize;
+	ckpt.close();
+	if(!_openLog(true))
+		return false;
+
+	_haveBase = true;
+	_deltaBytes = 0;
+	_deltaCount = 0;
+	_lastWriteBytes = _baseBytes;
+	_lastWriteFull = true;
+	_remember(pop);
+	return true;
+}
+
+/**
+ * \param pop The population to save
+ * \param generation A generation number to save with it
+ *
+ * Appends a record of what has changed since the last write(), or writes
+ * a full checkpoint if there is none yet or the log is due for
+ * compaction (see ga2DeltaCheckpoint::setCompaction()). Chromosomes still
+ * being evaluated by a pipelined ga2Population::step() are waited for
+ * first.
+ */
+bool ga2DeltaCheckpoint::write(ga2Population &pop, unsigned long generation)
+{
+	if( !_haveBase
+	  ||((_maxDeltas > 0) && (_deltaCount >= _maxDeltas))
+	  ||((_maxRatio > 0.0) && (_deltaBytes > _maxRatio * _baseBytes)) )
+		return writeFull(pop, generation);
+
+	pop.flush();
+	int L = pop._chromoSize;
+	int i, n = pop._chromosomes.size() < pop._size ? pop._chromosomes.size() : pop._size;
+
+	//match every slot against what was saved; stretches that moved
+	//together become runs, and anything unmatched is new
+	std::vector<uint32_t> runs;
+	std::vector<uint32_t> fresh;
+	for(i = 0; i < n; ++i)
+	{
+		std::unordered_map<uint64_t, int>::iterator it = _slotOf.find(pop._chromosomes[i].getId());
+		if(it == _slotOf.end())
+		{
+			fresh.push_back(i);
+			continue;
+		}
+		uint32_t src = it->second;
+		size_t r = runs.size();
+		if( r && (runs[r-3] + runs[r-1] == (uint32_t)i) && (runs[r-2] + runs[r-1] == src) )
+			++runs[r-1];
+		else
+		{
+			runs.push_back(i);
+			runs.push_back(src);
+			runs.push_back(1);
+		}
+	}
+
+	size_t k = fresh.size();
+	std::vector<unsigned char> payload(runs.size() * sizeof(uint32_t)
+									 + k * (sizeof(uint32_t) + sizeof(double) + 1 + L * sizeof(ga2Gene)));
+	unsigned char *p = payload.empty() ? NULL : &payload[0];
+	if(!runs.empty())
+		memcpy(p, &runs[0], runs.size() * sizeof(uint32_t));
+	p += runs.size() * sizeof(uint32_t);
+	if(k)
+		memcpy(p, &fresh[0], k * sizeof(uint32_t));
+	unsigned char *fit = p + k * sizeof(uint32_t);
+	unsigned char *evaluated = fit + k * sizeof(double);
+	unsigned char *genes = evaluated + k;
+	for(i = 0; i < k; ++i)
+	{
+		ga2Chromosome &c = pop._chromosomes[fresh[i]];
+		double f = c.isEvaluated() ? c.getFitness() : 0.0;
+		memcpy(fit + i * sizeof(double), &f, sizeof(double));
+		evaluated[i] = c.isEvaluated();
+		std::vector<ga2Gene> g = c.getGenes();
+		if(!g.empty())
+			memcpy(genes + (size_t)i * L * sizeof(ga2Gene), &g[0], L * sizeof(ga2Gene));
+	}
+
+	ga2DeltaHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, GA2_DELTA_MAGIC, 8);
+	h.version = GA2_DELTA_VERSION;
+	h.geneBytes = sizeof(ga2Gene);
+	h.baseChecksum = _baseChecksum;
+	h.generation = generation;
+	h.size = n;
+	h.chromoSize = L;
+	h.numRuns = runs.size() / 3;
+	h.numNew = k;
+	h.payloadBytes = payload.size();
+	h.payloadChecksum = ga2Checksum(payload.empty() ? NULL : &payload[0], payload.size());
+	h.headerChecksum = ga2Checksum(&h, offsetof(ga2DeltaHeader, headerChecksum));
+
+	//one buffer, one write(), so a record is never interleaved or split
+	//by anything short of a crash
+	std::vector<unsigned char> record(sizeof(h) + payload.size());
+	memcpy(&record[0], &h, sizeof(h));
+	if(!payload.empty())
+		memcpy(&record[sizeof(h)], &payload[0], payload.size());
+	if( (_fd < 0) && !_openLog(false) )
+		return false;
+	if(::write(_fd, &record[0], record.size()) != (ssize_t)record.size())
+		return false;
+	if(_sync)
+		fdatasync(_fd);
+
+	++_deltaCount;
+	_deltaBytes += record.size();
+	_lastWriteBytes = record.size();
+	_lastWriteFull = false;
+	_remember(pop);
+	return true;
+}
+
+/**
+ * \param pop The population to restore into
+ *
+ * Loads the full checkpoint with ga2Population::readCheckpoint(), then
+ * replays the delta log on top of it, stopping at the first record that
+ * is incomplete, damaged or belongs to a different checkpoint. Returns
+ * false only if the full checkpoint itself cannot be read. Afterwards,
+ * write() appends to the same log.
+ */
+bool ga2DeltaCheckpoint::read(ga2Population &pop)
+{
+	if(!pop.readCheckpoint(_path.c_str()))
+		return false;
+	ga2Checkpoint ckpt;
+	if(!ckpt.open(_path.c_str(), false, false))
+		return false;
+	_baseChecksum = ckpt.getHeader()->headerChecksum;
+	_baseBytes = ckpt.getHeader()->fileSize;
+	ckpt.close();
+	_haveBase = true;
+	_deltaCount = 0;
+	_deltaBytes = 0;
+
+	int L = pop._chromoSize;
+	int fd = open(_deltaPath.c_str(), O_RDONLY);
+	std::vector<unsigned char> payload;
+	while(fd >= 0)
+	{
+		ga2DeltaHeader h;
+		if(::read(fd, &h, sizeof(h)) != (ssize_t)sizeof(h))
+			break;
+		if( (memcmp(h.magic, GA2_DELTA_MAGIC, 8) != 0)
+		  ||(h.headerChecksum != ga2Checksum(&h, offsetof(ga2DeltaHeader, headerChecksum)))
+		  ||(h.version != GA2_DELTA_VERSION) || (h.geneBytes != sizeof(ga2Gene))
+		  ||(h.baseChecksum != _baseChecksum) || (h.chromoSize != L) )
+			break;
+		payload.resize(h.payloadBytes);
+		if( h.payloadBytes
+		  &&(::read(fd, &payload[0], h.payloadBytes) != (ssize_t)h.payloadBytes) )
+			break;
+		if(h.payloadChecksum != ga2Checksum(payload.empty() ? NULL : &payload[0], payload.size()))
+			break;
+		if(h.payloadBytes != h.numRuns * 3 * sizeof(uint32_t)
+						   + h.numNew * (sizeof(uint32_t) + sizeof(double) + 1 + L * sizeof(ga2Gene)))
+			break;
+
+		//rebuild the population from the previous one and the record
+		std::vector<ga2Chromosome> &cur = pop._chromosomes;
+		std::vector<ga2Chromosome> next(h.size, ga2Chromosome(L));
+		const unsigned char *p = payload.empty() ? NULL : &payload[0];
+		uint64_t i, j;
+		bool ok = true;
+		for(i = 0; i < h.numRuns && ok; ++i)
+		{
+			uint32_t run[3];
+			memcpy(run, p + i * sizeof(run), sizeof(run));
+			ok = ((uint64_t)run[0] + run[2] <= h.size) && ((uint64_t)run[1] + run[2] <= cur.size());
+			for(j = 0; ok && j < run[2]; ++j)
+				next[run[0] + j] = cur[run[1] + j];
+		}
+		p += h.numRuns * 3 * sizeof(uint32_t);
+		const unsigned char *fit = p + h.numNew * sizeof(uint32_t);
+		const unsigned char *evaluated = fit + h.numNew * sizeof(double);
+		const ga2Gene *genes = (const ga2Gene *)(evaluated + h.numNew);
+		std::vector<ga2Gene> g(L);
+		for(i = 0; i < h.numNew && ok; ++i)
+		{
+			uint32_t slot;
+			double f;
+			memcpy(&slot, p + i * sizeof(uint32_t), sizeof(uint32_t));
+			memcpy(&f, fit + i * sizeof(double), sizeof(double));
+			memcpy(&g[0], (const unsigned char *)genes + i * L * sizeof(ga2Gene), L * sizeof(ga2Gene));
+			ok = slot < h.size;
+			if(!ok)
+				break;
+			ga2Chromosome &c = next[slot];
+			c.setMaxRanges(pop._chromoMaxRanges);
+			c.setMinRanges(pop._chromoMinRanges);
+			c.setGenes(g);
+			c.setEvalFunc(pop._evalFunc);
+			if(evaluated[i])
+				c.setFitness(f);
+		}
+		if(!ok)
+			break;
+		cur.swap(next);
+		pop._statsValid = false;
+		pop._size = h.size;
+		++_deltaCount;
+		_deltaBytes += sizeof(h) + h.payloadBytes;
+	}
+	if(fd >= 0)
+		close(fd);
+
+	//cut off whatever could not be replayed, so new records follow on
+	//from the last good one
+	if( (truncate(_deltaPath.c_str(), _deltaBytes) != 0) && (_deltaBytes > 0) )
+		return false;
+	_openLog(false);
+	_remember(pop);
+	return true;
+}
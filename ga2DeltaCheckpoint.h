@@ -0,0 +1,135 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2DeltaCheckpoint.h: interface for the ga2DeltaCheckpoint class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2DELTACHECKPOINT_H__
+#define __GA2DELTACHECKPOINT_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+class ga2Population;
+
+#define GA2_DELTA_MAGIC "GA2DELT"
+#define GA2_DELTA_VERSION 1
+
+///The header of one record in a delta log.
+/**
+ * A record turns the population as it stood after the previous record (or
+ * the full checkpoint, for the first) into the population as it stands
+ * now. It is followed by its payload: numRuns copy runs, each three
+ * uint32_t (destination slot, source slot, length) saying that a stretch
+ * of slots holds what a stretch of the previous population held; then
+ * for the numNew slots that hold something new, their slot numbers
+ * (uint32_t), fitness values (double), evaluated flags (one byte) and
+ * genes. Between them the runs and the new slots cover every slot once.
+ */
+struct ga2DeltaHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t geneBytes;
+	uint64_t baseChecksum; //header checksum of the full checkpoint
+	uint64_t generation;
+	uint64_t size;
+	uint64_t chromoSize;
+	uint64_t numRuns;
+	uint64_t numNew;
+	uint64_t payloadBytes;
+	uint64_t payloadChecksum;
+	uint64_t headerChecksum; //of all the fields above
+};
+
+///Checkpoints a population every generation at the cost of what changed.
+/**
+ * The ga2DeltaCheckpoint class keeps a full binary checkpoint (see
+ * ga2Population::writeCheckpoint()) at a given path, and a log of deltas
+ * next to it, at the same path with ".delta" appended. Each call to
+ * ga2DeltaCheckpoint::write() appends one record holding only the
+ * chromosomes that are new since the last call, plus a handful of copy
+ * runs describing where everything else moved; a steady-state generation
+ * that inserts k children into a sorted population is k new chromosomes
+ * and k+1 runs, however large the population.
+ *
+ * Unchanged chromosomes are recognised by ga2Chromosome::getId(), so
+ * finding them is a pass over the population without touching any genes.
+ *
+ * Once the log has grown past a number of records, or past a fraction of
+ * the size of the full checkpoint, the next write() compacts: it writes a
+ * fresh full checkpoint and empties the log. Each record is checksummed,
+ * and each names the full checkpoint it belongs to, so a record torn by a
+ * crash, or a log left over from an older checkpoint, is simply ignored
+ * by ga2DeltaCheckpoint::read().
+ */
+class ga2DeltaCheckpoint
+{
+	std::string _path;
+	std::string _deltaPath;
+	int _fd;
+	bool _haveBase;
+	uint64_t _baseChecksum;
+	uint64_t _baseBytes;
+	uint64_t _deltaBytes;
+	int _deltaCount;
+	int _maxDeltas;
+	double _maxRatio;
+	bool _sync;
+	uint64_t _lastWriteBytes;
+	bool _lastWriteFull;
+	std::unordered_map<uint64_t, int> _slotOf; //chromosome id -> slot, as saved
+
+	void _remember(ga2Population &pop);
+	bool _openLog(bool truncate);
+
+public:
+	///The constructor.
+	ga2DeltaCheckpoint( const char *path );
+	///The destructor.
+	virtual ~ga2DeltaCheckpoint();
+	///Set when the log is folded into a new full checkpoint.
+	/**
+	 * \param maxDeltas Compact after this many records. Zero or less for no
+	 * limit.
+	 * \param maxRatio Compact once the log is this many times the size of
+	 * the full checkpoint. Zero or less for no limit.
+	 *
+	 * The defaults are 100 records and a ratio of 1.
+	 */
+	void setCompaction(int maxDeltas, double maxRatio) {_maxDeltas = maxDeltas; _maxRatio = maxRatio;};
+	///Wait for each record to reach the disk before returning from write().
+	void setSync(bool val) {_sync = val;};
+	///Save the population: a delta if possible, a full checkpoint if needed.
+	bool write(ga2Population &pop, unsigned long generation = 0);
+	///Save a full checkpoint and empty the delta log.
+	bool writeFull(ga2Population &pop, unsigned long generation = 0);
+	///Restore the population from the full checkpoint and every valid delta.
+	bool read(ga2Population &pop);
+	///Return the number of records in the delta log.
+	int getDeltaCount(void) {return _deltaCount;};
+	///Return the size of the delta log in bytes.
+	uint64_t getDeltaBytes(void) {return _deltaBytes;};
+	///Return the number of bytes written by the last write().
+	uint64_t getLastWriteBytes(void) {return _lastWriteBytes;};
+	///Did the last write() produce a full checkpoint?
+	bool getLastWriteFull(void) {return _lastWriteFull;};
+};
+
+#endif
@@ -0,0 +1,172 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2DifferentialEvolution.cpp: implementation of the ga2DifferentialEvolution class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <math.h>
+#include "ga2.h"
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param pop The population to evolve. Must outlive this.
+ */
+ga2DifferentialEvolution::ga2DifferentialEvolution( ga2Population &pop ) : _pop(pop)
+{
+	_strategy = GA2_DE_RAND1BIN;
+	_F = 0.5;
+	_CR = 0.9;
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2DifferentialEvolution::~ga2DifferentialEvolution()
+{
+}
+
+//sorts chromosomes best first, for sorted populations
+bool ga2DifferentialEvolution::_fitter(const ga2Chromosome &a, const ga2Chromosome &b)
+{
+	return a._fitness > b._fitness;
+}
+
+//a member other than a, b and c (any of which may be -1)
+int ga2DifferentialEvolution::_pick(int n, int a, int b, int c)
+{
+	int r;
+	do
+		r = _random.below(n);
+	while( (r == a) || (r == b) || (r == c) );
+	return r;
+}
+
+/**
+ * Returns false if the population has fewer than four members, or has not
+ * been initialised.
+ */
+bool ga2DifferentialEvolution::step(void)
+{
+	ga2Population &pop = _pop;
+	pop.flush(); //a pipelined batch would otherwise land on the new generation
+	int n = pop._chromosomes.size(), L = pop._chromoSize;
+	if( (n < 4) || (pop._chromoMinRanges.size() != L) || (pop._chromoMaxRanges.size() != L) )
+		return false;
+	ga2TraceScope traced(pop._tracer, "generation", "ga2", "generation", ++pop._generation);
+	const float *lo = &pop._chromoMinRanges[0], *hi = &pop._chromoMaxRanges[0];
+	_mutant.resize(L);
+	_draws.resize(L);
+	ga2Gene *v = &_mutant[0];
+	double *u = &_draws[0];
+	int i, j;
+
+	//build every trial. The gene loops are plain array arithmetic so the
+	//compiler can vectorise them; the random draws are made beforehand.
+	ga2ProfileScope breeding(pop._profiler, GA2_PHASE_CROSSOVER, pop._tracer);
+	pop._nextGen.resize(n);
+	int best = pop._bestIndex < n ? pop._bestIndex : 0;
+	const ga2Gene *xb = &pop._chromosomes[best]._genes[0];
+	float F = _F;
+	for(i = 0; i < n; ++i)
+	{
+		ga2Chromosome &trial = pop._nextGen[i];
+		trial = pop._chromosomes[i];
+		const ga2Gene *x = &pop._chromosomes[i]._genes[0];
+		int r1 = _pick(n, i, -1, -1), r2 = _pick(n, i, r1, -1);
+		const ga2Gene *a = &pop._chromosomes[r1]._genes[0], *b = &pop._chromosomes[r2]._genes[0];
+		if(_strategy == GA2_DE_CURRENTTOBEST1BIN)
+		{
+			for(j = 0; j < L; ++j)
+				v[j] = x[j] + F * (xb[j] - x[j]) + F * (a[j] - b[j]);
+		}
+		else
+		{
+			int r3 = _pick(n, i, r1, r2);
+			const ga2Gene *c = &pop._chromosomes[r3]._genes[0];
+			for(j = 0; j < L; ++j)
+				v[j] = a[j] + F * (b[j] - c[j]);
+		}
+		for(j = 0; j < L; ++j)
+			u[j] = _random.uniform();
+		u[_random.below(L)] = -1.0; //at least one gene from the mutant
+
+		ga2Gene *t = &trial._genes[0];
+		for(j = 0; j < L; ++j)
+		{
+			ga2Gene g = u[j] < _CR ? v[j] : x[j];
+			g = g < lo[j] ? (lo[j] + x[j]) * 0.5f : g;
+			g = g > hi[j] ? (hi[j] + x[j]) * 0.5f : g;
+			t[j] = g;
+		}
+		if(pop._integer)
+			for(j = 0; j < L; ++j)
+				t[j] = floorf(t[j] + 0.5f);
+		trial._isEvaluated = false;
+		trial._id = ga2Chromosome::_newId();
+		trial._parent[0] = i;
+		trial._parent[1] = r1;
+		trial._crossSite = -1;
+	}
+	if(pop._profiler)
+		pop._profiler->count(GA2_COUNTER_CROSSOVERS, n);
+	breeding.end();
+
+	ga2ProfileScope evaluating(pop._profiler, GA2_PHASE_EVALUATE, pop._tracer);
+	pop._evaluateBatch(pop._nextGen);
+	evaluating.end();
+
+	//one to one survival: each trial against its own target
+	ga2ProfileScope replacing(pop._profiler, GA2_PHASE_REPLACE, pop._tracer);
+	bool moved = false;
+	for(i = 0; i < n; ++i)
+	{
+		ga2Chromosome &target = pop._chromosomes[i], &trial = pop._nextGen[i];
+		if(trial._fitness < target._fitness)
+			continue;
+		pop._removeStats(target);
+		target = trial;
+		pop._addStats(target);
+		moved = true;
+	}
+	pop._nextGen.clear();
+	if(pop._isSorted && moved)
+		std::stable_sort(pop._chromosomes.begin(), pop._chromosomes.end(), _fitter);
+	pop._updateStats();
+	replacing.end();
+
+	pop._parentLag = 1;
+	if(pop._genealogy)
+		pop._genealogy->record(pop);
+	pop._profileGeneration();
+	return true;
+}
+
+/**
+ * \param generations Number of generations to step.
+ */
+bool ga2DifferentialEvolution::run(int generations)
+{
+	int g;
+	for(g = 0; g < generations; ++g)
+		if(!step())
+			return false;
+	return true;
+}
@@ -0,0 +1,87 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2DifferentialEvolution.h: interface for the ga2DifferentialEvolution class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2DIFFERENTIALEVOLUTION_H__
+#define __GA2DIFFERENTIALEVOLUTION_H__
+
+#include <vector>
+#include "ga2Gene.h"
+#include "ga2Random.h"
+
+class ga2Population;
+class ga2Chromosome;
+
+///Evolves a ga2Population by differential evolution.
+/**
+ * The ga2DifferentialEvolution class is for continuous problems, where
+ * differential evolution usually needs far fewer evaluations than
+ * crossover and reset mutation. It works on an ordinary ga2Population, in
+ * place of ga2Population::step(): set the population up as usual (ranges,
+ * evaluation function, and if wanted a scheduler, fitness cache, profiler
+ * and so on), call ga2Population::init(), then step this instead. The
+ * population's crossover, mutation, selection and replacement settings are
+ * not used.
+ *
+ * Each generation every member, the target, is challenged by a trial
+ * chromosome. The trial is the target with some of its genes, chosen with
+ * probability CR and always at least one, taken from a mutant vector:
+ * - GA2_DE_RAND1BIN: a + F (b - c), for three other members chosen at random.
+ * - GA2_DE_CURRENTTOBEST1BIN: target + F (best - target) + F (a - b), which
+ *   converges faster but is greedier.
+ *
+ * Genes pushed out of range are put halfway between the bound and the
+ * target's value. All the trials are evaluated as one batch, through the
+ * population's scheduler and fitness cache, and each replaces its target
+ * if it is at least as fit. The population's statistics, genealogy,
+ * profiler and tracer are kept up to date as by ga2Population::step().
+ */
+class ga2DifferentialEvolution
+{
+	ga2Population &_pop;
+	int _strategy;
+	double _F;
+	double _CR;
+	ga2Random _random;
+	std::vector<ga2Gene> _mutant;
+	std::vector<double> _draws;
+
+	int _pick(int n, int a, int b, int c);
+	static bool _fitter(const ga2Chromosome &a, const ga2Chromosome &b);
+
+public:
+	///The constructor.
+	ga2DifferentialEvolution( ga2Population &pop );
+	///The destructor.
+	virtual ~ga2DifferentialEvolution();
+	///Set the strategy: GA2_DE_RAND1BIN (the default) or GA2_DE_CURRENTTOBEST1BIN.
+	void setStrategy(int strategy) {_strategy = strategy;};
+	///Set the scale factor F applied to difference vectors. Defaults to 0.5.
+	void setScaleFactor(double F) {_F = F;};
+	///Set the probability CR of a gene coming from the mutant. Defaults to 0.9.
+	void setCrossoverRate(double CR) {_CR = CR;};
+	///Restart the random number generator from a seed.
+	void setSeed(uint64_t seed) {_random.setSeed(seed);};
+	///Run one generation.
+	bool step(void);
+	///Run a number of generations.
+	bool run(int generations);
+};
+
+#endif
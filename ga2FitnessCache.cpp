@@ -0,0 +1,419 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2FitnessCache.cpp: implementation of the ga2FitnessCache class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ga2.h"
+
+//the log starts with the magic string and the version, padded to 16 bytes
+#define GA2_FITNESSCACHE_HEADER 16
+//smallest index ever made
+#define GA2_FITNESSCACHE_MINSLOTS 1024
+
+static inline ga2FitnessIndexHeader *ga2IndexHeader(unsigned char *index)
+{
+	return (ga2FitnessIndexHeader *)index;
+}
+
+static inline uint64_t *ga2IndexSlots(unsigned char *index)
+{
+	return (uint64_t *)(index + sizeof(ga2FitnessIndexHeader));
+}
+
+//holds flock() on the log for as long as it is in scope
+class ga2FileLock
+{
+	int _fd;
+public:
+	ga2FileLock(int fd) : _fd(fd) {flock(_fd, LOCK_EX);};
+	~ga2FileLock() {flock(_fd, LOCK_UN);};
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+ga2FitnessCache::ga2FitnessCache() : _index(NULL), _hits(0), _misses(0)
+{
+	_problem = 0;
+	_sync = false;
+	_fd = -1;
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2FitnessCache::~ga2FitnessCache()
+{
+	close();
+}
+
+void ga2FitnessCache::close(void)
+{
+	size_t i;
+	for(i = 0; i < _maps.size(); ++i)
+		munmap(_maps[i].first, _maps[i].second);
+	_maps.clear();
+	_index = NULL;
+	if(_fd >= 0)
+		::close(_fd);
+	_fd = -1;
+}
+
+/**
+ * \param path The log file. The index is kept alongside it, with ".idx"
+ * appended. Both are created if they do not exist.
+ * \param problem Identifies the fitness function. Fitness values stored
+ * under one problem are never returned for another, so use a different
+ * number for every fitness function (and every version of one) that
+ * shares the file. ga2Checksum() of a descriptive string will do.
+ */
+bool ga2FitnessCache::open(const char *path, uint64_t problem)
+{
+	close();
+	_path = path;
+	_indexPath = _path + ".idx";
+	_problem = problem;
+	_fd = ::open(path, O_RDWR|O_CREAT, 0644);
+	if(_fd < 0)
+		return false;
+
+	ga2FileLock l(_fd);
+	struct stat st;
+	if(fstat(_fd, &st) != 0)
+	{
+		close();
+		return false;
+	}
+	unsigned char header[GA2_FITNESSCACHE_HEADER];
+	if(st.st_size == 0)
+	{
+		uint32_t version = GA2_FITNESSCACHE_VERSION;
+		memset(header, 0, sizeof(header));
+		memcpy(header, GA2_FITNESSCACHE_MAGIC, sizeof(GA2_FITNESSCACHE_MAGIC));
+		memcpy(header + 8, &version, sizeof(version));
+		if(pwrite(_fd, header, sizeof(header), 0) != sizeof(header))
+		{
+			close();
+			return false;
+		}
+		st.st_size = sizeof(header);
+	}
+	else
+	{
+		uint32_t version;
+		if( (pread(_fd, header, sizeof(header), 0) != sizeof(header))
+		  ||(memcmp(header, GA2_FITNESSCACHE_MAGIC, sizeof(GA2_FITNESSCACHE_MAGIC)) != 0) )
+		{
+			close();
+			return false;
+		}
+		memcpy(&version, header + 8, sizeof(version));
+		if(version != GA2_FITNESSCACHE_VERSION)
+		{
+			close();
+			return false;
+		}
+	}
+
+	//an index that is missing, damaged or claims more log than there is
+	//belongs to some other log; start again from this one
+	if( !_mapIndex() || (ga2IndexHeader(_index)->logBytes > (uint64_t)st.st_size) )
+		if(!_buildIndex(true))
+		{
+			close();
+			return false;
+		}
+	return true;
+}
+
+//maps the index file as it currently is, making it the one in use.
+bool ga2FitnessCache::_mapIndex(void)
+{
+	int fd = ::open(_indexPath.c_str(), O_RDWR);
+	if(fd < 0)
+		return false;
+	struct stat st;
+	void *m = MAP_FAILED;
+	if( (fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(ga2FitnessIndexHeader)) )
+		m = mmap(NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(m == MAP_FAILED)
+		return false;
+	ga2FitnessIndexHeader *h = (ga2FitnessIndexHeader *)m;
+	if( (memcmp(h->magic, GA2_FITNESSCACHE_MAGIC, sizeof(GA2_FITNESSCACHE_MAGIC)) != 0)
+	  ||(h->version != GA2_FITNESSCACHE_VERSION)
+	  ||(h->capacity == 0) || (h->capacity & (h->capacity - 1))
+	  ||(sizeof(ga2FitnessIndexHeader) + h->capacity * 2 * sizeof(uint64_t) != (uint64_t)st.st_size) )
+	{
+		munmap(m, st.st_size);
+		return false;
+	}
+	_maps.push_back(std::make_pair(m, (size_t)st.st_size));
+	_index = (unsigned char *)m;
+	return true;
+}
+
+//returns the index in use, first switching to a new one if another
+//thread or process has replaced it. Old mappings stay valid until close(),
+//so a lookup still probing one is never pulled out from under.
+unsigned char *ga2FitnessCache::_currentIndex(void)
+{
+	unsigned char *index = _index.load();
+	if( index && __atomic_load_n(&ga2IndexHeader(index)->replaced, __ATOMIC_ACQUIRE) )
+	{
+		std::lock_guard<std::mutex> l(_lock);
+		if(_index.load() == index)
+			_mapIndex();
+		index = _index.load();
+	}
+	return index;
+}
+
+uint64_t ga2FitnessCache::_key(const std::vector<ga2Gene> &genes)
+{
+	uint64_t key = ga2Checksum(genes.empty() ? NULL : &genes[0], genes.size() * sizeof(ga2Gene));
+	key ^= (_problem + 0x9E3779B97F4A7C15ULL) * 0xBF58476D1CE4E5B9ULL;
+	return key ? key : 1; //zero marks an empty slot
+}
+
+//fills in the offset before publishing the key, for lock-free readers.
+//Only ever called with the log locked.
+void ga2FitnessCache::_insert(unsigned char *index, uint64_t key, uint64_t offset)
+{
+	uint64_t mask = ga2IndexHeader(index)->capacity - 1;
+	uint64_t *slots = ga2IndexSlots(index);
+	uint64_t i = key & mask;
+	while(__atomic_load_n(&slots[2*i], __ATOMIC_RELAXED))
+		i = (i + 1) & mask;
+	__atomic_store_n(&slots[2*i+1], offset, __ATOMIC_RELAXED);
+	__atomic_store_n(&slots[2*i], key, __ATOMIC_RELEASE);
+}
+
+bool ga2FitnessCache::_find(unsigned char *index, uint64_t key, const std::vector<ga2Gene> &genes, double &fitness)
+{
+	uint64_t mask = ga2IndexHeader(index)->capacity - 1;
+	uint64_t *slots = ga2IndexSlots(index);
+	uint64_t i = key & mask, probes;
+	std::vector<unsigned char> buf(sizeof(ga2FitnessRecord) + genes.size() * sizeof(ga2Gene));
+	for(probes = 0; probes <= mask; ++probes, i = (i + 1) & mask)
+	{
+		uint64_t k = __atomic_load_n(&slots[2*i], __ATOMIC_ACQUIRE);
+		if(!k)
+			return false;
+		if(k != key)
+			continue;
+		uint64_t offset = __atomic_load_n(&slots[2*i+1], __ATOMIC_RELAXED);
+		if(pread(_fd, &buf[0], buf.size(), offset) != (ssize_t)buf.size())
+			continue;
+		ga2FitnessRecord rec;
+		memcpy(&rec, &buf[0], sizeof(rec));
+		if( (rec.problem != _problem) || (rec.key != key) || (rec.geneCount != genes.size())
+		  ||(genes.size() && memcmp(&buf[sizeof(rec)], &genes[0], genes.size() * sizeof(ga2Gene)) != 0)
+		  ||(ga2Checksum(&buf[0], offsetof(ga2FitnessRecord, checksum))
+			 + ga2Checksum(&buf[sizeof(rec)], buf.size() - sizeof(rec)) != rec.checksum) )
+			continue;
+		fitness = rec.fitness;
+		return true;
+	}
+	return false;
+}
+
+//writes a fresh index under a temporary name and renames it into place,
+//either from every intact record in the log or, to grow it, from the
+//index in use. Only ever called with the log locked.
+bool ga2FitnessCache::_buildIndex(bool fromLog)
+{
+	std::vector<uint64_t> entries; //key, offset pairs
+	uint64_t logBytes = GA2_FITNESSCACHE_HEADER;
+	unsigned char *old = _index.load();
+	if(fromLog)
+	{
+		ga2FitnessRecord rec;
+		std::vector<unsigned char> buf;
+		while(pread(_fd, &rec, sizeof(rec), logBytes) == sizeof(rec))
+		{
+			buf.resize(sizeof(rec) + rec.geneCount * sizeof(ga2Gene));
+			if(pread(_fd, &buf[0], buf.size(), logBytes) != (ssize_t)buf.size())
+				break;
+			if(ga2Checksum(&buf[0], offsetof(ga2FitnessRecord, checksum))
+			   + ga2Checksum(&buf[sizeof(rec)], buf.size() - sizeof(rec)) != rec.checksum)
+				break;
+			entries.push_back(rec.key);
+			entries.push_back(logBytes);
+			logBytes += buf.size();
+		}
+	}
+	else
+	{
+		ga2FitnessIndexHeader *h = ga2IndexHeader(old);
+		uint64_t *slots = ga2IndexSlots(old), i;
+		for(i = 0; i < h->capacity; ++i)
+			if(slots[2*i])
+			{
+				entries.push_back(slots[2*i]);
+				entries.push_back(slots[2*i+1]);
+			}
+		logBytes = h->logBytes;
+	}
+
+	uint64_t count = entries.size() / 2, capacity = GA2_FITNESSCACHE_MINSLOTS;
+	while(capacity < 4 * count)
+		capacity <<= 1;
+	size_t bytes = sizeof(ga2FitnessIndexHeader) + capacity * 2 * sizeof(uint64_t);
+	char pid[32];
+	snprintf(pid, sizeof(pid), ".%d", (int)getpid());
+	std::string tmp = _indexPath + pid;
+	int fd = ::open(tmp.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+	if(fd < 0)
+		return false;
+	void *m = MAP_FAILED;
+	if(ftruncate(fd, bytes) == 0)
+		m = mmap(NULL, bytes, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(m == MAP_FAILED)
+	{
+		unlink(tmp.c_str());
+		return false;
+	}
+
+	unsigned char *index = (unsigned char *)m;
+	ga2FitnessIndexHeader *h = ga2IndexHeader(index);
+	memcpy(h->magic, GA2_FITNESSCACHE_MAGIC, sizeof(GA2_FITNESSCACHE_MAGIC));
+	h->version = GA2_FITNESSCACHE_VERSION;
+	h->capacity = capacity;
+	h->count = count;
+	h->logBytes = logBytes;
+	uint64_t i;
+	for(i = 0; i < count; ++i)
+		_insert(index, entries[2*i], entries[2*i+1]);
+	if(rename(tmp.c_str(), _indexPath.c_str()) != 0)
+	{
+		munmap(m, bytes);
+		unlink(tmp.c_str());
+		return false;
+	}
+	_maps.push_back(std::make_pair(m, bytes));
+	_index = index;
+	if(old)
+		__atomic_store_n(&ga2IndexHeader(old)->replaced, 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/**
+ * \param genes The genome to look up
+ * \param fitness Receives its fitness, if it is known
+ *
+ * Returns true if a fitness has been stored for this genome under this
+ * problem, by this process or any other. Safe to call from any thread.
+ */
+bool ga2FitnessCache::lookup(const std::vector<ga2Gene> &genes, double &fitness)
+{
+	unsigned char *index = _currentIndex();
+	if( index && _find(index, _key(genes), genes, fitness) )
+	{
+		++_hits;
+		return true;
+	}
+	++_misses;
+	return false;
+}
+
+/**
+ * \param genes The genome
+ * \param fitness Its fitness
+ *
+ * Appends the fitness to the log and indexes it, unless it is there
+ * already. Safe to call from any thread and any process.
+ */
+bool ga2FitnessCache::store(const std::vector<ga2Gene> &genes, double fitness)
+{
+	if(_fd < 0)
+		return false;
+	uint64_t key = _key(genes);
+	std::lock_guard<std::mutex> guard(_lock);
+	ga2FileLock l(_fd);
+	unsigned char *index = _index.load();
+	if(__atomic_load_n(&ga2IndexHeader(index)->replaced, __ATOMIC_ACQUIRE))
+	{
+		if(!_mapIndex())
+			return false;
+		index = _index.load();
+	}
+	double known;
+	if(_find(index, key, genes, known))
+		return true;
+
+	//anything past the last indexed record was left by a writer that died
+	//half way through; it goes
+	ga2FitnessIndexHeader *h = ga2IndexHeader(index);
+	struct stat st;
+	if( (fstat(_fd, &st) == 0) && ((uint64_t)st.st_size > h->logBytes) )
+		if(ftruncate(_fd, h->logBytes) != 0)
+			return false;
+
+	ga2FitnessRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.problem = _problem;
+	rec.key = key;
+	rec.fitness = fitness;
+	rec.geneCount = genes.size();
+	std::vector<unsigned char> buf(sizeof(rec) + genes.size() * sizeof(ga2Gene));
+	if(!genes.empty())
+		memcpy(&buf[sizeof(rec)], &genes[0], genes.size() * sizeof(ga2Gene));
+	memcpy(&buf[0], &rec, sizeof(rec));
+	rec.checksum = ga2Checksum(&buf[0], offsetof(ga2FitnessRecord, checksum))
+				 + ga2Checksum(&buf[sizeof(rec)], buf.size() - sizeof(rec));
+	memcpy(&buf[0], &rec, sizeof(rec));
+	uint64_t offset = h->logBytes;
+	if(pwrite(_fd, &buf[0], buf.size(), offset) != (ssize_t)buf.size())
+		return false;
+	if(_sync)
+		fdatasync(_fd);
+
+	if((h->count + 1) * 2 > h->capacity)
+	{
+		if(!_buildIndex(false))
+			return false;
+		index = _index.load();
+		h = ga2IndexHeader(index);
+	}
+	//the record is counted before it is published: a crash in between
+	//costs one entry rather than leaving a key that points nowhere
+	h->logBytes = offset + buf.size();
+	++h->count;
+	_insert(index, key, offset);
+	return true;
+}
+
+/**
+ * Counts every fitness value in the cache, whichever problem it belongs
+ * to.
+ */
+long ga2FitnessCache::getSize(void)
+{
+	unsigned char *index = _currentIndex();
+	return index ? ga2IndexHeader(index)->count : 0;
+}
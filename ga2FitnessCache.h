@@ -0,0 +1,133 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2FitnessCache.h: interface for the ga2FitnessCache class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2FITNESSCACHE_H__
+#define __GA2FITNESSCACHE_H__
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "ga2Gene.h"
+
+#define GA2_FITNESSCACHE_MAGIC "GA2FIT"
+#define GA2_FITNESSCACHE_VERSION 1
+
+///The header of a fitness cache index file.
+/**
+ * Followed by capacity slots, each two uint64_t: the key of a genome
+ * (zero for an empty slot) and the offset of its record in the log.
+ */
+struct ga2FitnessIndexHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t capacity; //a power of two
+	uint64_t count;
+	uint64_t logBytes; //of the log, up to the end of its last indexed record
+	uint64_t replaced; //set once a bigger index has taken this one's place
+	uint64_t pad[2];
+};
+
+///One fitness value in a fitness cache log, followed by its genes.
+struct ga2FitnessRecord
+{
+	uint64_t problem;
+	uint64_t key;
+	double fitness;
+	uint32_t geneCount;
+	uint32_t reserved;
+	uint64_t checksum; //of the fields above and the genes
+};
+
+///Remembers fitness values on disk, across runs and processes.
+/**
+ * The ga2FitnessCache class stores every fitness value it is given in an
+ * append-only log, together with the genes it belongs to and a problem
+ * identifier chosen by the caller, so that a later run on the same problem
+ * (or another run going on at the same time) can look it up instead of
+ * calling an expensive fitness function again. Hand one to
+ * ga2Population::setFitnessCache() or ga2Chromosome::setFitnessCache().
+ *
+ * The log is indexed by an open addressing hash table in a second file,
+ * with ".idx" appended, which is mapped into memory; a lookup is a probe
+ * of the table and one read of the log, and the genes in the log are
+ * compared, so a hash collision can never return a wrong fitness. The
+ * index can always be rebuilt from the log, and is, if it is missing or
+ * does not match.
+ *
+ * Lookups take no locks. Additions are serialised between threads by a
+ * mutex and between processes by flock() on the log; a new index slot is
+ * filled in before its key is published, so readers in other processes
+ * either see a complete entry or none. When the index fills up, the
+ * process adding to it writes a bigger one, renames it into place and
+ * marks the old one replaced, and everyone else switches over at their
+ * next lookup.
+ */
+class ga2FitnessCache
+{
+	std::string _path;
+	std::string _indexPath;
+	uint64_t _problem;
+	bool _sync;
+	int _fd;
+	std::atomic<unsigned char *> _index;
+	std::vector< std::pair<void *, size_t> > _maps; //every index mapped, unmapped by close()
+	std::mutex _lock;
+	std::atomic<long> _hits;
+	std::atomic<long> _misses;
+
+	uint64_t _key(const std::vector<ga2Gene> &genes);
+	bool _mapIndex(void);
+	bool _buildIndex(bool fromLog);
+	void _insert(unsigned char *index, uint64_t key, uint64_t offset);
+	bool _find(unsigned char *index, uint64_t key, const std::vector<ga2Gene> &genes, double &fitness);
+	unsigned char *_currentIndex(void);
+
+public:
+	///The constructor.
+	ga2FitnessCache();
+	///The destructor. Closes the cache.
+	virtual ~ga2FitnessCache();
+	///Open (or create) a cache, for one problem.
+	bool open(const char *path, uint64_t problem);
+	///Close the cache.
+	void close(void);
+	///Is a cache open?
+	bool isOpen(void) {return _fd >= 0;};
+	///Wait for every new fitness value to reach the disk before going on.
+	void setSync(bool val) {_sync = val;};
+	///Look up the fitness of a genome.
+	bool lookup(const std::vector<ga2Gene> &genes, double &fitness);
+	///Remember the fitness of a genome.
+	bool store(const std::vector<ga2Gene> &genes, double fitness);
+	///Return the number of fitness values in the cache, for all problems.
+	long getSize(void);
+	///Return the number of successful lookups.
+	long getHitCount(void) {return _hits.load();};
+	///Return the number of unsuccessful lookups.
+	long getMissCount(void) {return _misses.load();};
+};
+
+#endif
@@ -0,0 +1,475 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Genealogy.cpp: implementation of the ga2Genealogy class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ga2.h"
+
+//the log starts with the magic string and the version, padded to 16 bytes
+#define GA2_GENEALOGY_HEADER 16
+//blocks are gathered up to this many bytes before being written
+#define GA2_GENEALOGY_BATCH 65536
+
+static void ga2PutVarint(std::vector<unsigned char> &out, uint64_t v)
+{
+	while(v >= 0x80)
+	{
+		out.push_back((unsigned char)(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back((unsigned char)v);
+}
+
+static inline uint64_t ga2Zigzag(int64_t v)
+{
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t ga2Unzigzag(uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+//reads varints without running off the end of a damaged block
+static bool ga2GetVarint(const unsigned char *&p, const unsigned char *end, uint64_t &v)
+{
+	int shift = 0;
+	v = 0;
+	while(p < end && shift < 64)
+	{
+		unsigned char b = *p++;
+		v |= (uint64_t)(b & 0x7f) << shift;
+		if(!(b & 0x80))
+			return true;
+		shift += 7;
+	}
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+ga2Genealogy::ga2Genealogy()
+{
+	_fd = -1;
+	_idxFd = -1;
+	_generation = 0;
+	_offset = 0;
+	_map = NULL;
+	_mapSize = 0;
+	_idx = NULL;
+	_idxSize = 0;
+	_numGenerations = 0;
+}
+
+/**
+ * Destructor. Writes out anything still buffered.
+ */
+ga2Genealogy::~ga2Genealogy()
+{
+	close();
+}
+
+/**
+ * \param path The log file. The index is written alongside it, with
+ * ".idx" appended.
+ */
+bool ga2Genealogy::create(const char *path)
+{
+	close();
+	std::string idxPath = std::string(path) + ".idx";
+	_fd = ::open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	_idxFd = ::open(idxPath.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if( (_fd < 0) || (_idxFd < 0) )
+	{
+		close();
+		return false;
+	}
+	unsigned char header[GA2_GENEALOGY_HEADER];
+	uint32_t version = GA2_GENEALOGY_VERSION;
+	memset(header, 0, sizeof(header));
+	memcpy(header, GA2_GENEALOGY_MAGIC, sizeof(GA2_GENEALOGY_MAGIC));
+	memcpy(header + 8, &version, sizeof(version));
+	_buffer.assign(header, header + sizeof(header));
+	_offset = sizeof(header);
+	_generation = 0;
+	_slotOf.clear();
+	return true;
+}
+
+/**
+ * Writes out whatever has been buffered or, if a log is mapped for
+ * reading, unmaps it.
+ */
+void ga2Genealogy::close(void)
+{
+	if(_fd >= 0)
+	{
+		_flush();
+		::close(_fd);
+	}
+	if(_idxFd >= 0)
+		::close(_idxFd);
+	if(_map)
+		munmap((void *)_map, _mapSize);
+	if(_idx)
+		munmap((void *)_idx, _idxSize);
+	_fd = -1;
+	_idxFd = -1;
+	_map = NULL;
+	_idx = NULL;
+	_mapSize = 0;
+	_idxSize = 0;
+	_numGenerations = 0;
+	_slotOf.clear();
+}
+
+bool ga2Genealogy::_flush(void)
+{
+	bool ok = true;
+	if(!_buffer.empty())
+		ok = ::write(_fd, &_buffer[0], _buffer.size()) == (ssize_t)_buffer.size();
+	if(!_index.empty())
+		ok = ok && (::write(_idxFd, &_index[0], _index.size() * sizeof(uint64_t))
+					== (ssize_t)(_index.size() * sizeof(uint64_t)));
+	_buffer.clear();
+	_index.clear();
+	return ok;
+}
+
+/**
+ * \param pop The population to record
+ *
+ * Appends one generation: a birth record for every chromosome that was
+ * not in the population last time record() was called, and copy runs for
+ * the rest. The first call records everything as born with no parents.
+ * ga2Population::step() calls this itself when a genealogy has been set.
+ */
+bool ga2Genealogy::record(ga2Population &pop)
+{
+	if(_fd < 0)
+		return false;
+	int i, n = pop._chromosomes.size() < pop._size ? pop._chromosomes.size() : pop._size;
+	std::vector<int> births;
+	std::vector<int> runs;
+	for(i = 0; i < n; ++i)
+	{
+		std::unordered_map<uint64_t, int>::iterator it = _slotOf.find(pop._chromosomes[i].getId());
+		if(it == _slotOf.end())
+		{
+			births.push_back(i);
+			continue;
+		}
+		int src = it->second;
+		size_t r = runs.size();
+		if( r && (runs[r-3] + runs[r-1] == i) && (runs[r-2] + runs[r-1] == src) )
+			++runs[r-1];
+		else
+		{
+			runs.push_back(i);
+			runs.push_back(src);
+			runs.push_back(1);
+		}
+	}
+
+	ga2GenealogyBlock h;
+	h.generation = _generation;
+	h.numBirths = births.size();
+	h.numRuns = runs.size() / 3;
+	h.parentLag = pop._parentLag;
+
+	std::vector<unsigned char> payload;
+	size_t k;
+	for(k = 0; k < births.size(); ++k)
+	{
+		ga2Chromosome &c = pop._chromosomes[births[k]];
+		double f = c.isEvaluated() ? c.getFitness() : 0.0;
+		payload.insert(payload.end(), (unsigned char *)&f, (unsigned char *)&f + sizeof(f));
+	}
+	int prev = 0;
+	for(k = 0; k < births.size(); ++k)
+	{
+		ga2PutVarint(payload, births[k] - prev);
+		prev = births[k];
+	}
+	for(k = 0; k < births.size(); ++k)
+	{
+		int p0 = _generation ? pop._chromosomes[births[k]].getParent(0) : -1;
+		ga2PutVarint(payload, ga2Zigzag((int64_t)p0 - births[k]));
+	}
+	for(k = 0; k < births.size(); ++k)
+	{
+		ga2Chromosome &c = pop._chromosomes[births[k]];
+		int p0 = _generation ? c.getParent(0) : -1;
+		int p1 = _generation ? c.getParent(1) : -1;
+		ga2PutVarint(payload, ga2Zigzag((int64_t)p1 - p0));
+	}
+	for(k = 0; k < births.size(); ++k)
+		ga2PutVarint(payload, ga2Zigzag(pop._chromosomes[births[k]].getCrossSite()));
+	prev = 0;
+	for(k = 0; k < runs.size(); k += 3)
+	{
+		ga2PutVarint(payload, runs[k] - prev);
+		ga2PutVarint(payload, ga2Zigzag((int64_t)runs[k+1] - runs[k]));
+		ga2PutVarint(payload, runs[k+2]);
+		prev = runs[k] + runs[k+2];
+	}
+	h.bytes = payload.size();
+
+	_index.push_back(_offset);
+	_buffer.insert(_buffer.end(), (unsigned char *)&h, (unsigned char *)&h + sizeof(h));
+	_buffer.insert(_buffer.end(), payload.begin(), payload.end());
+	_offset += sizeof(h) + payload.size();
+	++_generation;
+
+	_slotOf.clear();
+	for(i = 0; i < n; ++i)
+		_slotOf[pop._chromosomes[i].getId()] = i;
+
+	if(_buffer.size() >= GA2_GENEALOGY_BATCH)
+		return _flush();
+	return true;
+}
+
+/**
+ * \param path A log written by create() and record()
+ *
+ * Maps the log and its index. A log cut short by a crash is usable up to
+ * its last complete generation.
+ */
+bool ga2Genealogy::open(const char *path)
+{
+	close();
+	std::string idxPath = std::string(path) + ".idx";
+	struct stat st;
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+	if( (fstat(fd, &st) == 0) && (st.st_size >= GA2_GENEALOGY_HEADER) )
+	{
+		_mapSize = st.st_size;
+		void *m = mmap(NULL, _mapSize, PROT_READ, MAP_SHARED, fd, 0);
+		_map = (m == MAP_FAILED) ? NULL : (const unsigned char *)m;
+	}
+	::close(fd);
+	uint32_t version = 0;
+	if(_map)
+		memcpy(&version, _map + 8, sizeof(version));
+	if( !_map || (memcmp(_map, GA2_GENEALOGY_MAGIC, sizeof(GA2_GENEALOGY_MAGIC)) != 0)
+	  ||(version != GA2_GENEALOGY_VERSION) )
+	{
+		close();
+		return false;
+	}
+
+	fd = ::open(idxPath.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		close();
+		return false;
+	}
+	if( (fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(uint64_t)) )
+	{
+		_idxSize = st.st_size;
+		void *m = mmap(NULL, _idxSize, PROT_READ, MAP_SHARED, fd, 0);
+		_idx = (m == MAP_FAILED) ? NULL : (const uint64_t *)m;
+	}
+	::close(fd);
+
+	//drop any trailing generations the log does not fully hold
+	_numGenerations = _idx ? _idxSize / sizeof(uint64_t) : 0;
+	while(_numGenerations > 0)
+	{
+		uint64_t off = _idx[_numGenerations-1];
+		ga2GenealogyBlock h;
+		if(off + sizeof(h) <= _mapSize)
+		{
+			memcpy(&h, _map + off, sizeof(h));
+			if(off + sizeof(h) + h.bytes <= _mapSize)
+				break;
+		}
+		--_numGenerations;
+	}
+	return true;
+}
+
+/**
+ * Returns the number of generations recorded so far, or held by the log
+ * that is open for reading.
+ */
+long ga2Genealogy::getNumGenerations(void)
+{
+	return _map ? _numGenerations : _generation;
+}
+
+//decodes one block. runs receive (destination, source, length) triples.
+bool ga2Genealogy::_decode(long generation, ga2GenealogyBlock &h,
+						   std::vector<ga2LineageRecord> &births, std::vector<int> &runs)
+{
+	if( !_map || (generation < 0) || (generation >= _numGenerations) )
+		return false;
+	uint64_t off = _idx[generation];
+	memcpy(&h, _map + off, sizeof(h));
+	const unsigned char *p = _map + off + sizeof(h);
+	const unsigned char *end = p + h.bytes;
+	if(h.numBirths * sizeof(double) > h.bytes)
+		return false;
+
+	uint32_t i;
+	uint64_t v;
+	births.resize(h.numBirths);
+	for(i = 0; i < h.numBirths; ++i, p += sizeof(double))
+	{
+		births[i].generation = generation;
+		memcpy(&births[i].fitness, p, sizeof(double));
+	}
+	int prev = 0;
+	for(i = 0; i < h.numBirths; ++i)
+	{
+		if(!ga2GetVarint(p, end, v))
+			return false;
+		births[i].slot = prev + (int)v;
+		prev = births[i].slot;
+	}
+	for(i = 0; i < h.numBirths; ++i)
+	{
+		if(!ga2GetVarint(p, end, v))
+			return false;
+		births[i].parent0 = births[i].slot + (int)ga2Unzigzag(v);
+	}
+	for(i = 0; i < h.numBirths; ++i)
+	{
+		if(!ga2GetVarint(p, end, v))
+			return false;
+		births[i].parent1 = births[i].parent0 + (int)ga2Unzigzag(v);
+	}
+	for(i = 0; i < h.numBirths; ++i)
+	{
+		if(!ga2GetVarint(p, end, v))
+			return false;
+		births[i].crossSite = (int)ga2Unzigzag(v);
+	}
+	runs.resize(h.numRuns * 3);
+	prev = 0;
+	for(i = 0; i < h.numRuns; ++i)
+	{
+		uint64_t d, s, len;
+		if( !ga2GetVarint(p, end, d) || !ga2GetVarint(p, end, s) || !ga2GetVarint(p, end, len) )
+			return false;
+		runs[3*i] = prev + (int)d;
+		runs[3*i+1] = runs[3*i] + (int)ga2Unzigzag(s);
+		runs[3*i+2] = (int)len;
+		prev = runs[3*i] + runs[3*i+2];
+	}
+	return true;
+}
+
+/**
+ * \param generation The generation to look at
+ * \param births Receives a record for each chromosome born in it
+ *
+ * Only for a log opened with ga2Genealogy::open().
+ */
+bool ga2Genealogy::getBirths(long generation, std::vector<ga2LineageRecord> &births)
+{
+	ga2GenealogyBlock h;
+	std::vector<int> runs;
+	return _decode(generation, h, births, runs);
+}
+
+/**
+ * \param generation The generation to look at
+ * \param slot The slot to look at
+ * \param rec Receives the birth record of the chromosome in that slot
+ *
+ * Follows the chromosome back through the generations it survived to the
+ * one it was born in. Only for a log opened with ga2Genealogy::open().
+ */
+bool ga2Genealogy::getRecord(long generation, int slot, ga2LineageRecord &rec)
+{
+	ga2GenealogyBlock h;
+	std::vector<ga2LineageRecord> births;
+	std::vector<int> runs;
+	while(_decode(generation, h, births, runs))
+	{
+		//births and runs are both in slot order
+		size_t lo = 0, hi = births.size();
+		while(lo < hi)
+		{
+			size_t mid = (lo + hi) / 2;
+			if(births[mid].slot < slot)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if( (lo < births.size()) && (births[lo].slot == slot) )
+		{
+			rec = births[lo];
+			return true;
+		}
+		lo = 0;
+		hi = runs.size() / 3;
+		while(lo < hi)
+		{
+			size_t mid = (lo + hi) / 2;
+			if(runs[3*mid] + runs[3*mid+2] <= slot)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if( (lo == runs.size() / 3) || (runs[3*lo] > slot) )
+			return false;
+		slot = runs[3*lo+1] + (slot - runs[3*lo]);
+		--generation;
+	}
+	return false;
+}
+
+/**
+ * \param generation The generation to start from, usually the last
+ * \param slot The slot to start from, for instance that of the best
+ * chromosome
+ * \param lineage Receives the birth records along the way, newest first
+ *
+ * Follows the chromosome's first parent, then that chromosome's first
+ * parent, and so on, back to the first generation. Only for a log opened
+ * with ga2Genealogy::open().
+ */
+bool ga2Genealogy::getLineage(long generation, int slot, std::vector<ga2LineageRecord> &lineage)
+{
+	lineage.clear();
+	ga2LineageRecord rec;
+	ga2GenealogyBlock h;
+	for(;;)
+	{
+		if(!getRecord(generation, slot, rec))
+			return false;
+		lineage.push_back(rec);
+		if( (rec.parent0 < 0) || (rec.generation == 0) )
+			return true;
+		memcpy(&h, _map + _idx[rec.generation], sizeof(h));
+		generation = rec.generation - h.parentLag;
+		slot = rec.parent0;
+	}
+}
@@ -0,0 +1,131 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Genealogy.h: interface for the ga2Genealogy class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2GENEALOGY_H__
+#define __GA2GENEALOGY_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stddef.h>
+#include <stdint.h>
+
+class ga2Population;
+
+#define GA2_GENEALOGY_MAGIC "GA2GEN"
+#define GA2_GENEALOGY_VERSION 1
+
+///The birth of one chromosome, as kept by ga2Genealogy.
+struct ga2LineageRecord
+{
+	long generation; //generation the chromosome first appeared in
+	int slot;        //its slot in that generation
+	int parent0;     //slots of its parents, -1 for the first generation
+	int parent1;
+	int crossSite;
+	double fitness;
+};
+
+///The header of one generation in a genealogy log.
+/**
+ * Followed by numBirths fitness values (double), then, as unsigned LEB128
+ * varints, the births column by column: slot (as the difference from the
+ * previous birth's slot), parent0 (zigzag encoded, as the difference from
+ * the slot), parent1 (zigzag, difference from parent0) and crossSite
+ * (zigzag). Then numRuns copy runs, each three varints: destination (as
+ * the difference from the end of the previous run), source (zigzag,
+ * difference from the destination) and length. Parents are slots in the
+ * generation parentLag records back; runs always refer to the previous
+ * one.
+ */
+struct ga2GenealogyBlock
+{
+	uint64_t generation;
+	uint32_t numBirths;
+	uint32_t numRuns;
+	uint32_t bytes; //of everything after this header
+	uint32_t parentLag;
+};
+
+///Records who descended from whom, for queries after the run.
+/**
+ * A ga2Genealogy attached to a population with
+ * ga2Population::setGenealogy() appends one block per generation to a log
+ * file: a ga2LineageRecord for each chromosome born that generation, and
+ * a few copy runs saying which slot every survivor moved to. Survivors are
+ * recognised by ga2Chromosome::getId(), just as ga2DeltaCheckpoint does,
+ * so a steady-state generation costs a few bytes per child however large
+ * the population is. The writer holds only the current generation, so its
+ * memory does not grow with the length of the run; the log grows on disk.
+ *
+ * A second file, with ".idx" appended, holds the offset of every block.
+ * Opening a finished log with ga2Genealogy::open() maps both, and queries
+ * such as ga2Genealogy::getLineage() decode only the blocks they visit.
+ *
+ * In pipelined mode (see ga2Population::setPipelined()) children are bred
+ * from the population as it was two generations back, and their parents
+ * are recorded as such.
+ */
+class ga2Genealogy
+{
+	//writing
+	int _fd;
+	int _idxFd;
+	long _generation;
+	uint64_t _offset;
+	std::vector<unsigned char> _buffer;
+	std::vector<uint64_t> _index;
+	std::unordered_map<uint64_t, int> _slotOf; //chromosome id -> slot, last generation
+
+	//reading
+	const unsigned char *_map;
+	size_t _mapSize;
+	const uint64_t *_idx;
+	size_t _idxSize;
+	long _numGenerations;
+
+	bool _flush(void);
+	bool _decode(long generation, ga2GenealogyBlock &h,
+				 std::vector<ga2LineageRecord> &births, std::vector<int> &runs);
+
+public:
+	///The constructor.
+	ga2Genealogy();
+	///The destructor. Closes any log.
+	virtual ~ga2Genealogy();
+	///Start a new log, truncating any old one.
+	bool create(const char *path);
+	///Append a block for the population as it stands.
+	bool record(ga2Population &pop);
+	///Map a finished log for queries.
+	bool open(const char *path);
+	///Finish writing, or unmap.
+	void close(void);
+	///Return the number of generations recorded.
+	long getNumGenerations(void);
+	///Return every chromosome born in a generation.
+	bool getBirths(long generation, std::vector<ga2LineageRecord> &births);
+	///Return the birth record of whatever occupies a slot in a generation.
+	bool getRecord(long generation, int slot, ga2LineageRecord &rec);
+	///Trace a chromosome back through its first parents to the first generation.
+	bool getLineage(long generation, int slot, std::vector<ga2LineageRecord> &lineage);
+};
+
+#endif
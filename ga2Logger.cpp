@@ -0,0 +1,317 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Logger.cpp: implementation of the ga2Logger class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ga2.h"
+
+//a partly filled batch is written out once the writer has been idle this
+//long, so a slow run still shows up in the log
+#define GA2_LOG_IDLEFLUSH 0.1
+
+static double ga2LogNow(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param capacity Number of records the queue holds; rounded up to a power
+ * of two.
+ * \param policy What log() does when the queue is full: GA2_LOG_BLOCK to
+ * wait for the writer, GA2_LOG_DROP to discard the record.
+ */
+ga2Logger::ga2Logger( int capacity, int policy )
+	: _head(0), _tail(0), _stop(false), _sleeping(false), _dropped(0), _written(0), _failed(false)
+{
+	size_t n = 1;
+	while(n < (size_t)capacity)
+		n <<= 1;
+	_ring.resize(n);
+	_mask = n - 1;
+	_fd = -1;
+	_format = GA2_LOG_CSV;
+	_policy = policy;
+	_batchBytes = 1 << 16;
+	_sync = false;
+}
+
+/**
+ * Destructor. Closes the log, writing out everything still queued.
+ */
+ga2Logger::~ga2Logger()
+{
+	close();
+}
+
+/**
+ * \param path File to write; an existing file is truncated.
+ * \param format GA2_LOG_CSV or GA2_LOG_BINARY
+ *
+ * Opens the file and starts the writer thread. A logger that is already
+ * open is closed first.
+ */
+bool ga2Logger::open(const char *path, int format)
+{
+	close();
+	_fd = ::open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if(_fd < 0)
+		return false;
+	_format = format;
+	_head = 0;
+	_tail = 0;
+	_stop = false;
+	_failed = false;
+	_buffer.clear();
+	if(_format == GA2_LOG_BINARY)
+	{
+		char magic[8] = GA2_LOG_MAGIC;
+		uint32_t version = GA2_LOG_VERSION;
+		_buffer.insert(_buffer.end(), magic, magic + 8);
+		_buffer.insert(_buffer.end(), (char *)&version, (char *)&version + sizeof(version));
+	}
+	_thread = std::thread(&ga2Logger::_writerLoop, this);
+	return true;
+}
+
+/**
+ * Waits for the writer to empty the queue, then stops it and closes the
+ * file. Returns false if any write failed.
+ */
+bool ga2Logger::close(void)
+{
+	if(_fd < 0)
+		return true;
+	_stop = true;
+	{
+		std::lock_guard<std::mutex> l(_sleepLock);
+		_wake.notify_one();
+	}
+	_thread.join();
+	_flushBuffer();
+	if(_sync)
+		fdatasync(_fd);
+	::close(_fd);
+	_fd = -1;
+	return !_failed;
+}
+
+//returns the slot to fill, or NULL if the record has to be dropped.
+ga2Logger::_Record *ga2Logger::_acquire(void)
+{
+	if(_fd < 0)
+		return NULL;
+	size_t t = _tail.load(std::memory_order_relaxed);
+	while(t - _head.load(std::memory_order_acquire) > _mask)
+	{
+		if(_policy == GA2_LOG_DROP)
+		{
+			++_dropped;
+			return NULL;
+		}
+		std::this_thread::yield();
+	}
+	return &_ring[t & _mask];
+}
+
+void ga2Logger::_publish(void)
+{
+	_tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+	//only pay for the lock when the writer is actually asleep
+	if(_sleeping.load())
+	{
+		std::lock_guard<std::mutex> l(_sleepLock);
+		_wake.notify_one();
+	}
+}
+
+/**
+ * \param pop The population to log
+ * \param generation The generation number to log it under
+ * \param snapshot Also log the fitness and genes of every chromosome
+ *
+ * Copies the population's statistics (as last computed by
+ * ga2Population::evaluate()) and, if asked, its chromosomes into the
+ * queue. Chromosomes are logged with the fitness they have been given so
+ * far; nothing is evaluated. Returns false if the record was dropped or no
+ * log is open.
+ */
+bool ga2Logger::log(ga2Population &pop, unsigned long generation, bool snapshot)
+{
+	_Record *rec = _acquire();
+	if(!rec)
+		return false;
+	ga2LogHeader &h = rec->header;
+	h.generation = generation;
+	h.maxFitness = pop.getMaxFitness();
+	h.avgFitness = pop.getAvgFitness();
+	h.minFitness = pop.getMinFitness();
+	h.sumFitness = pop.getSumFitness();
+	h.size = pop.getSize();
+	h.chromoSize = pop._chromoSize;
+	h.count = 0;
+	h.reserved = 0;
+	if(snapshot)
+	{
+		int L = pop._chromoSize, i, j;
+		int n = pop._chromosomes.size() < pop._size ? pop._chromosomes.size() : pop._size;
+		rec->fitness.resize(n);
+		rec->genes.resize((size_t)n * L);
+		for(i = 0; i < n; ++i)
+		{
+			ga2Chromosome &c = pop._chromosomes[i];
+			rec->fitness[i] = c.isEvaluated() ? c.getFitness() : 0.0;
+			for(j = 0; j < L; ++j)
+				rec->genes[(size_t)i * L + j] = c.getGene(j);
+		}
+		h.count = n;
+	}
+	_publish();
+	return true;
+}
+
+/**
+ * \param generation The generation number
+ * \param maxFitness The highest fitness
+ * \param avgFitness The average fitness
+ * \param minFitness The lowest fitness
+ * \param sumFitness The sum of all fitness values
+ * \param size The number of chromosomes
+ *
+ * For logging the other population types, such as ga2CellularPopulation.
+ */
+bool ga2Logger::logStats(unsigned long generation, double maxFitness, double avgFitness, double minFitness,
+						 double sumFitness, int size)
+{
+	_Record *rec = _acquire();
+	if(!rec)
+		return false;
+	ga2LogHeader &h = rec->header;
+	h.generation = generation;
+	h.maxFitness = maxFitness;
+	h.avgFitness = avgFitness;
+	h.minFitness = minFitness;
+	h.sumFitness = sumFitness;
+	h.size = size;
+	h.chromoSize = 0;
+	h.count = 0;
+	h.reserved = 0;
+	_publish();
+	return true;
+}
+
+void ga2Logger::_formatRecord(_Record &rec)
+{
+	const ga2LogHeader &h = rec.header;
+	size_t L = h.chromoSize, i, j;
+	if(_format == GA2_LOG_BINARY)
+	{
+		_buffer.insert(_buffer.end(), (const char *)&h, (const char *)&h + sizeof(h));
+		if(h.count)
+		{
+			_buffer.insert(_buffer.end(), (const char *)&rec.fitness[0],
+						   (const char *)&rec.fitness[0] + h.count * sizeof(double));
+			_buffer.insert(_buffer.end(), (const char *)&rec.genes[0],
+						   (const char *)&rec.genes[0] + h.count * L * sizeof(ga2Gene));
+		}
+		return;
+	}
+
+	char line[160];
+	int len = snprintf(line, sizeof(line), "G,%llu,%.17g,%.17g,%.17g,%.17g,%u\n",
+					   (unsigned long long)h.generation, h.maxFitness, h.avgFitness,
+					   h.minFitness, h.sumFitness, h.size);
+	_buffer.insert(_buffer.end(), line, line + len);
+	for(i = 0; i < h.count; ++i)
+	{
+		len = snprintf(line, sizeof(line), "C,%llu,%u,%.17g",
+					   (unsigned long long)h.generation, (unsigned)i, rec.fitness[i]);
+		_buffer.insert(_buffer.end(), line, line + len);
+		for(j = 0; j < L; ++j)
+		{
+			len = snprintf(line, sizeof(line), ",%.9g", rec.genes[i * L + j]);
+			_buffer.insert(_buffer.end(), line, line + len);
+		}
+		_buffer.push_back('\n');
+	}
+}
+
+void ga2Logger::_flushBuffer(void)
+{
+	size_t done = 0;
+	while(done < _buffer.size())
+	{
+		ssize_t n = ::write(_fd, &_buffer[done], _buffer.size() - done);
+		if(n <= 0)
+		{
+			_failed = true;
+			break;
+		}
+		done += n;
+	}
+	if(_sync && done)
+		fdatasync(_fd);
+	_buffer.clear();
+}
+
+void ga2Logger::_writerLoop(void)
+{
+	double lastFlush = ga2LogNow();
+	for(;;)
+	{
+		size_t h = _head.load(std::memory_order_relaxed);
+		if(h == _tail.load(std::memory_order_acquire))
+		{
+			if(_stop)
+			{
+				//close() may have raced with a last log(); look once more
+				if(h == _tail.load(std::memory_order_acquire))
+					break;
+				continue;
+			}
+			if( !_buffer.empty() && (ga2LogNow() - lastFlush >= GA2_LOG_IDLEFLUSH) )
+			{
+				_flushBuffer();
+				lastFlush = ga2LogNow();
+			}
+			std::unique_lock<std::mutex> l(_sleepLock);
+			_sleeping = true;
+			if( (h == _tail.load()) && !_stop )
+				_wake.wait_for(l, std::chrono::milliseconds(10));
+			_sleeping = false;
+			continue;
+		}
+
+		_formatRecord(_ring[h & _mask]);
+		_head.store(h + 1, std::memory_order_release);
+		++_written;
+		if(_buffer.size() >= _batchBytes)
+		{
+			_flushBuffer();
+			lastFlush = ga2LogNow();
+		}
+	}
+}
@@ -0,0 +1,148 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Logger.h: interface for the ga2Logger class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2LOGGER_H__
+#define __GA2LOGGER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "ga2Gene.h"
+
+class ga2Population;
+
+#define GA2_LOG_MAGIC "GA2LOG"
+#define GA2_LOG_VERSION 1
+
+#define GA2_LOG_CSV 1
+#define GA2_LOG_BINARY 2
+
+#define GA2_LOG_BLOCK 1
+#define GA2_LOG_DROP 2
+
+///The header of one record in a binary log.
+/**
+ * Followed by count fitness values (double) and count * chromoSize genes
+ * when the record carries a population snapshot; count is zero otherwise.
+ * A binary log starts with an 8 byte magic string and a uint32_t version.
+ */
+struct ga2LogHeader
+{
+	uint64_t generation;
+	double maxFitness;
+	double avgFitness;
+	double minFitness;
+	double sumFitness;
+	uint32_t size;
+	uint32_t chromoSize;
+	uint32_t count;
+	uint32_t reserved;
+};
+
+///Writes per-generation statistics and snapshots from a background thread.
+/**
+ * The ga2Logger class takes the formatting and writing of a log off the
+ * thread running the algorithm. ga2Logger::log() copies what is to be
+ * written into a slot of a fixed ring and returns; a background thread
+ * takes records off the ring, formats them, and writes them out in
+ * batches of ga2Logger::setBatchBytes() bytes.
+ *
+ * The ring is a single producer, single consumer queue without locks: only
+ * one thread may call log() (or logStats()) at a time. Slots are reused,
+ * so once the ring has warmed up logging allocates nothing. When the ring
+ * is full, log() either waits for a slot (GA2_LOG_BLOCK) or throws the
+ * record away and counts it (GA2_LOG_DROP).
+ *
+ * In GA2_LOG_CSV format each generation is a line
+ * "G,generation,max,avg,min,sum,size" and each chromosome of a
+ * snapshot a line "C,generation,index,fitness,gene,gene,...". In
+ * GA2_LOG_BINARY format each is a ga2LogHeader followed by the snapshot.
+ */
+class ga2Logger
+{
+	struct _Record
+	{
+		ga2LogHeader header;
+		std::vector<double> fitness;
+		std::vector<ga2Gene> genes;
+	};
+
+	int _fd;
+	int _format;
+	int _policy;
+	size_t _batchBytes;
+	bool _sync;
+
+	std::vector<_Record> _ring;
+	size_t _mask;
+	std::atomic<size_t> _head; //next record to write; moved by the writer
+	std::atomic<size_t> _tail; //next free slot; moved by log()
+	std::atomic<bool> _stop;
+	std::atomic<bool> _sleeping;
+	std::atomic<long> _dropped;
+	std::atomic<long> _written;
+	std::atomic<bool> _failed;
+	std::mutex _sleepLock;
+	std::condition_variable _wake;
+	std::thread _thread;
+
+	std::vector<char> _buffer;
+
+	void _writerLoop(void);
+	void _formatRecord(_Record &rec);
+	void _flushBuffer(void);
+	_Record *_acquire(void);
+	void _publish(void);
+
+public:
+	///The constructor.
+	ga2Logger( int capacity = 1024, int policy = GA2_LOG_BLOCK );
+	///The destructor. Writes out anything still queued.
+	virtual ~ga2Logger();
+	///Start logging to a file, truncating it.
+	bool open(const char *path, int format = GA2_LOG_CSV);
+	///Write out everything queued, stop the writer and close the file.
+	bool close(void);
+	///Is a log open?
+	bool isOpen(void) {return _fd >= 0;};
+	///Queue one generation's statistics, and optionally the whole population.
+	bool log(ga2Population &pop, unsigned long generation, bool snapshot = false);
+	///Queue statistics that did not come from a ga2Population.
+	bool logStats(unsigned long generation, double maxFitness, double avgFitness, double minFitness,
+				  double sumFitness, int size);
+	///Set what happens when the queue is full: GA2_LOG_BLOCK or GA2_LOG_DROP.
+	void setPolicy(int policy) {_policy = policy;};
+	///Set how many bytes are gathered before each write to the file.
+	void setBatchBytes(size_t bytes) {_batchBytes = bytes;};
+	///Wait for each batch to reach the disk.
+	void setSync(bool val) {_sync = val;};
+	///Return the number of records thrown away because the queue was full.
+	long getDropCount(void) {return _dropped.load();};
+	///Return the number of records written so far.
+	long getWriteCount(void) {return _written.load();};
+	///Return the number of records waiting to be written.
+	long getQueued(void) {return _tail.load() - _head.load();};
+};
+
+#endif
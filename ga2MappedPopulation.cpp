@@ -0,0 +1,414 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2MappedPopulation.cpp: implementation of the ga2MappedPopulation class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "ga2.h"
+
+#define GA2_PAGE 4096
+
+//gives advice about the whole pages inside [p, p+bytes)
+static void ga2Advise(void *p, size_t bytes, int advice)
+{
+	uintptr_t begin = ((uintptr_t)p + GA2_PAGE - 1) & ~(uintptr_t)(GA2_PAGE - 1);
+	uintptr_t end = ((uintptr_t)p + bytes) & ~(uintptr_t)(GA2_PAGE - 1);
+	if(end > begin)
+		madvise((void *)begin, end - begin, advice);
+}
+
+//breeds (or, for init, randomly creates) and evaluates part of a block;
+//handed to the scheduler.
+class ga2MappedTask : public ga2Task
+{
+	ga2MappedPopulation &_pop;
+	bool _init;
+public:
+	ga2MappedTask(ga2MappedPopulation &pop, bool init) : _pop(pop), _init(init) {};
+	void run(int begin, int end)
+	{
+		int k;
+		for(k = begin; k < end; ++k)
+			_pop._breedChild(k, _init);
+	};
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param size Number of chromosomes in the population
+ * \param chromoSize Number of genes per chromosome
+ *
+ * Nothing is allocated until ga2MappedPopulation::init() or
+ * ga2MappedPopulation::open() is called.
+ */
+ga2MappedPopulation::ga2MappedPopulation( int size, int chromoSize )
+	: _size(size), _chromoSize(chromoSize)
+{
+	_current = 0;
+	_evalFunc = NULL;
+	_scheduler = NULL;
+	_mutationRate = 0.0;
+	_crossoverRate = 1.0;
+	_crossoverType = GA2_CROSSOVER_ONEPOINT;
+	_replacementType = GA2_REPLACE_GENERATIONAL;
+	_tournamentSize = 2;
+	_blockSize = 4096;
+	_integer = false;
+	_seed = 1;
+	_blockBegin = _blockEnd = 0;
+	_sumFitness = _avgFitness = 0.0;
+	_minFitness = _maxFitness = 0.0;
+	_generation = 0;
+	_evaluations = 0;
+}
+
+/**
+ * Destructor. Call ga2MappedPopulation::sync() first to leave a
+ * checkpoint behind.
+ */
+ga2MappedPopulation::~ga2MappedPopulation()
+{
+}
+
+ga2Gene ga2MappedPopulation::_randomGene(ga2Random &rng, int i)
+{
+	float range = _chromoMaxRanges[i] - _chromoMinRanges[i];
+	float f;
+	if(_integer)
+	{
+		f = (rng.uniform() * (range+1)) + _chromoMinRanges[i];
+		f = (int)f; //trunc it down to size
+	}
+	else //no rounding
+		f = (rng.uniform() * range) + _chromoMinRanges[i];
+	return f;
+}
+
+int ga2MappedPopulation::_tournament(ga2Random &rng)
+{
+	const double *fit = _files[_current].getFitness();
+	int best = rng.below(_size), k;
+	for(k = 1; k < _tournamentSize; ++k)
+	{
+		int c = rng.below(_size);
+		if(fit[c] > fit[best])
+			best = c;
+	}
+	return best;
+}
+
+//k indexes the current block. every child has its own generator, so the
+//result does not depend on which thread breeds it.
+void ga2MappedPopulation::_breedChild(int k, bool init)
+{
+	ga2Random rng(_seed ^ ((uint64_t)init << 63) ^ ((uint64_t)_generation << 36) ^ (uint64_t)(_blockBegin + k));
+	ga2Gene *child = &_children[(size_t)k * _chromoSize];
+	int i;
+	if(init)
+	{
+		for(i = 0; i < _chromoSize; ++i)
+			child[i] = _randomGene(rng, i);
+	}
+	else
+	{
+		const ga2Gene *a = &_parents[(size_t)2 * k * _chromoSize];
+		const ga2Gene *b = a + _chromoSize;
+		if(rng.uniform() > _crossoverRate)
+			memcpy(child, a, _chromoSize * sizeof(ga2Gene));
+		else if(_crossoverType == GA2_CROSSOVER_UNIFORM)
+			for(i = 0; i < _chromoSize; ++i)
+				child[i] = (rng.next() >> 63) ? a[i] : b[i];
+		else
+		{
+			int coPoint = rng.below(_chromoSize);
+			memcpy(child, a, coPoint * sizeof(ga2Gene));
+			memcpy(child + coPoint, b + coPoint, (_chromoSize - coPoint) * sizeof(ga2Gene));
+		}
+		for(i = 0; i < _chromoSize; ++i)
+			if(rng.uniform() < _mutationRate)
+				child[i] = _randomGene(rng, i);
+	}
+	_childFitness[k] = _evalFunc ? _evalFunc(std::vector<ga2Gene>(child, child + _chromoSize)) : 0.0;
+}
+
+//breeds the block [_blockBegin, _blockEnd) and writes it out: into the
+//current file for init, into the next one otherwise.
+void ga2MappedPopulation::_runBlock(bool init)
+{
+	int n = _blockEnd - _blockBegin, k;
+	size_t L = _chromoSize;
+	ga2Checkpoint &cur = _files[_current];
+	ga2Checkpoint &dst = init ? cur : _files[1-_current];
+	_children.resize(n * L);
+	_childFitness.resize(n);
+
+	if(!init)
+	{
+		//pick every parent of the block first, then fetch them in slot
+		//order, so the gene matrix is read in one forward sweep
+		ga2Random rng(_seed ^ ((uint64_t)_generation << 36) ^ (uint64_t)_blockBegin ^ 0x5E1EC7ULL << 40);
+		std::vector< std::pair<int, int> > picks(2 * n);
+		for(k = 0; k < 2 * n; ++k)
+			picks[k] = std::make_pair(_tournament(rng), k);
+		std::sort(picks.begin(), picks.end());
+		_parents.resize(2 * n * L);
+		for(k = 0; k < 2 * n; ++k)
+			memcpy(&_parents[picks[k].second * L], cur.getGenes(picks[k].first), L * sizeof(ga2Gene));
+	}
+
+	ga2MappedTask task(*this, init);
+	if(_scheduler)
+		_scheduler->parallelFor(task, n);
+	else
+		task.run(0, n);
+	_evaluations += n;
+
+	const double *curFit = cur.getFitness();
+	double *fit = dst.getFitness();
+	unsigned char *evaluated = dst.getEvaluated();
+	for(k = 0; k < n; ++k)
+	{
+		int slot = _blockBegin + k;
+		double f = _childFitness[k];
+		const ga2Gene *genes = &_children[k * L];
+		if( !init && (_replacementType == GA2_REPLACE_STEADYSTATE) && (f < curFit[slot]) )
+		{
+			f = curFit[slot];
+			genes = cur.getGenes(slot);
+		}
+		memcpy(dst.getGenes(slot), genes, L * sizeof(ga2Gene));
+		fit[slot] = f;
+		evaluated[slot] = 1;
+
+		_sumFitness += f;
+		if(f < _minFitness)
+			_minFitness = f;
+		if(f > _maxFitness)
+		{
+			_maxFitness = f;
+			_bestGenes.assign(genes, genes + L);
+		}
+	}
+
+	//this stretch is finished with: start it on its way to the disk and
+	//let the pages go
+	ga2Gene *done = dst.getGenes(_blockBegin);
+	msync((void *)((uintptr_t)done & ~(uintptr_t)(GA2_PAGE - 1)),
+		  ((uintptr_t)done & (GA2_PAGE - 1)) + n * L * sizeof(ga2Gene), MS_ASYNC);
+	ga2Advise(done, n * L * sizeof(ga2Gene), MADV_DONTNEED);
+}
+
+//one pass over the whole population, block by block.
+bool ga2MappedPopulation::_sweep(bool init)
+{
+	ga2Checkpoint &cur = _files[_current];
+	ga2Checkpoint &dst = init ? cur : _files[1-_current];
+	size_t matrixBytes = (size_t)_size * _chromoSize * sizeof(ga2Gene);
+	ga2Advise(dst.getGeneMatrix(), matrixBytes, MADV_SEQUENTIAL);
+	if(!init)
+	{
+		//parents are scattered thinly over a big population; reading
+		//ahead of them would only waste memory
+		bool sparse = (size_t)2 * _blockSize * GA2_PAGE < matrixBytes;
+		ga2Advise(cur.getGeneMatrix(), matrixBytes, sparse ? MADV_RANDOM : MADV_SEQUENTIAL);
+		ga2Advise(cur.getFitness(), (size_t)_size * sizeof(double), MADV_WILLNEED);
+	}
+
+	_sumFitness = 0.0;
+	_minFitness = DBL_MAX;
+	_maxFitness = -DBL_MAX;
+	for(_blockBegin = 0; _blockBegin < _size; _blockBegin = _blockEnd)
+	{
+		_blockEnd = _blockBegin + _blockSize < _size ? _blockBegin + _blockSize : _size;
+		_runBlock(init);
+	}
+	_avgFitness = _sumFitness / _size;
+	_parents.clear();
+	_children.clear();
+	_childFitness.clear();
+
+	if(init)
+		return true;
+
+	//the next generation becomes the current one, under the main path
+	++_generation;
+	dst.setGeneration(_generation);
+	ga2Advise(cur.getGeneMatrix(), matrixBytes, MADV_DONTNEED);
+	std::string swap = _path + ".swap";
+	if( (rename(_path.c_str(), swap.c_str()) != 0)
+	  ||(rename(_nextPath.c_str(), _path.c_str()) != 0)
+	  ||(rename(swap.c_str(), _nextPath.c_str()) != 0) )
+		return false;
+	_current = 1 - _current;
+	return true;
+}
+
+//maps the current generation (creating or opening it) and creates the
+//file the next generation is written into.
+bool ga2MappedPopulation::_prepare(const char *path, bool create)
+{
+	_path = path;
+	_nextPath = _path + ".next";
+	_current = 0;
+	ga2Checkpoint &cur = _files[0];
+	if(create)
+	{
+		if( (_chromoMaxRanges.size() != _chromoSize)
+		  ||(_chromoMinRanges.size() != _chromoSize) )
+			return false;
+		if(!cur.create(path, _size, _chromoSize))
+			return false;
+		_generation = 0;
+	}
+	else
+	{
+		if(!cur.open(path, true))
+			return false;
+		_size = cur.getSize();
+		_chromoSize = cur.getChromoSize();
+		_generation = cur.getGeneration();
+	}
+	int i;
+	if(create)
+		for(i = 0; i < _chromoSize; ++i)
+		{
+			cur.getMinRanges()[i] = _chromoMinRanges[i];
+			cur.getMaxRanges()[i] = _chromoMaxRanges[i];
+		}
+	else
+	{
+		_chromoMinRanges.assign(cur.getMinRanges(), cur.getMinRanges() + _chromoSize);
+		_chromoMaxRanges.assign(cur.getMaxRanges(), cur.getMaxRanges() + _chromoSize);
+	}
+
+	ga2Checkpoint &next = _files[1];
+	if(!next.create(_nextPath.c_str(), _size, _chromoSize))
+		return false;
+	memcpy(next.getMinRanges(), cur.getMinRanges(), 2 * _chromoSize * sizeof(float));
+	return true;
+}
+
+/**
+ * \param path Where to keep the population. Two files are created: this
+ * one and one with ".next" appended. Existing files are truncated.
+ *
+ * The ranges must have been set. Genes are generated and evaluated block
+ * by block, so the whole population never has to fit in memory.
+ */
+bool ga2MappedPopulation::init(const char *path)
+{
+	if(!_prepare(path, true))
+		return false;
+	return _sweep(true);
+}
+
+/**
+ * \param path A population file left by an earlier run, after
+ * ga2MappedPopulation::sync(), or by ga2Population::writeCheckpoint().
+ *
+ * The size, genes, ranges and generation number all come from the file,
+ * which is verified first. The statistics are brought up to date with one
+ * sequential pass over the fitness values.
+ */
+bool ga2MappedPopulation::open(const char *path)
+{
+	if(!_prepare(path, false))
+		return false;
+	ga2Checkpoint &cur = _files[_current];
+	const double *fit = cur.getFitness();
+	int i, best = 0;
+	_sumFitness = 0.0;
+	_minFitness = DBL_MAX;
+	_maxFitness = -DBL_MAX;
+	for(i = 0; i < _size; ++i)
+	{
+		_sumFitness += fit[i];
+		if(fit[i] < _minFitness)
+			_minFitness = fit[i];
+		if(fit[i] > _maxFitness)
+		{
+			_maxFitness = fit[i];
+			best = i;
+		}
+	}
+	_avgFitness = _sumFitness / _size;
+	_bestGenes.assign(cur.getGenes(best), cur.getGenes(best) + _chromoSize);
+	return true;
+}
+
+/**
+ * Runs one generation as a single sweep over the file. See the class
+ * description for the order the pages are visited in.
+ */
+bool ga2MappedPopulation::step(void)
+{
+	if(!_files[_current].isOpen())
+		return false;
+	return _sweep(false);
+}
+
+/**
+ * Recomputes the checksums of the current generation and waits for it to
+ * reach the disk. This reads the whole file, so it is worth doing only
+ * every so often.
+ */
+bool ga2MappedPopulation::sync(void)
+{
+	return _files[_current].sync();
+}
+
+/**
+ * \param index Slot of the chromosome
+ *
+ * Returns a copy of the chromosome's genes.
+ */
+std::vector<ga2Gene> ga2MappedPopulation::getGenes(int index)
+{
+	const ga2Gene *g = _files[_current].getGenes(index);
+	return std::vector<ga2Gene>(g, g + _chromoSize);
+}
+
+/**
+ * \param ranges A vector containing the upper bound for the values of each
+ * gene.
+ */
+void ga2MappedPopulation::setMaxRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMaxRanges = ranges;
+}
+
+/**
+ * \param ranges A vector containing the lower bound for the values of each
+ * gene.
+ */
+void ga2MappedPopulation::setMinRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMinRanges = ranges;
+}
@@ -0,0 +1,186 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2MappedPopulation.h: interface for the ga2MappedPopulation class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2MAPPEDPOPULATION_H__
+#define __GA2MAPPEDPOPULATION_H__
+
+#include <string>
+#include <vector>
+#include "ga2Gene.h"
+#include "ga2Random.h"
+#include "ga2Scheduler.h"
+#include "ga2Checkpoint.h"
+
+///A population too big for memory, kept in a memory-mapped file.
+/**
+ * The ga2MappedPopulation class keeps its genes and fitness values in a
+ * binary population file (see ga2Checkpoint) instead of in memory, so a
+ * population can be far larger than RAM: the operating system pages the
+ * parts in use in and out, and the resident set stays bounded.
+ *
+ * That only works if the pages are touched in a friendly order, so each
+ * generation is a single sweep from the first slot to the last, in blocks
+ * of ga2MappedPopulation::setBlockSize() children. For each block, parents
+ * are picked by tournament on the fitness array alone; the chosen parents'
+ * genes are then gathered in ascending slot order, so each page of the
+ * gene matrix is read at most once per block and always moving forward.
+ * The block is bred and evaluated in memory (on the scheduler, if one is
+ * set), and each child is written to its slot of the next generation's
+ * file, which is filled strictly sequentially. Finished stretches of that
+ * file are handed back to the operating system with madvise().
+ *
+ * Two files are used: the current generation at the given path, and the
+ * next generation being written, at the same path with ".next" appended.
+ * They swap names at the end of each step(), so the path always holds the
+ * newest generation, and after ga2MappedPopulation::sync() it is a valid
+ * checkpoint that ga2Population::readCheckpoint() can load.
+ *
+ * Every child has its own random number generator, seeded from the seed,
+ * the generation and its slot, so results do not depend on the number of
+ * threads.
+ */
+class ga2MappedPopulation
+{
+	int _size;
+	int _chromoSize;
+	std::string _path;
+	std::string _nextPath;
+	ga2Checkpoint _files[2];
+	int _current;
+
+	double(* _evalFunc)(std::vector<ga2Gene>);
+	ga2Scheduler *_scheduler;
+	std::vector<float> _chromoMaxRanges;
+	std::vector<float> _chromoMinRanges;
+
+	double _mutationRate;
+	double _crossoverRate;
+	int _crossoverType;
+	int _replacementType;
+	int _tournamentSize;
+	int _blockSize;
+	bool _integer;
+	uint64_t _seed;
+
+	//the block being bred
+	int _blockBegin;
+	int _blockEnd;
+	std::vector<ga2Gene> _parents; //two per child, gathered from the file
+	std::vector<ga2Gene> _children;
+	std::vector<double> _childFitness;
+
+	double _sumFitness;
+	double _avgFitness;
+	double _minFitness;
+	double _maxFitness;
+	std::vector<ga2Gene> _bestGenes;
+	long _generation;
+	long _evaluations;
+
+	friend class ga2MappedTask;
+	ga2Gene _randomGene(ga2Random &rng, int i);
+	int _tournament(ga2Random &rng);
+	void _breedChild(int k, bool init);
+	void _runBlock(bool init);
+	bool _prepare(const char *path, bool create);
+	bool _sweep(bool init);
+
+public:
+	///The constructor.
+	ga2MappedPopulation( int size, int chromoSize );
+	///The destructor. Unmaps the files without syncing them.
+	virtual ~ga2MappedPopulation();
+	///Set the evaluation function to use.
+	/**
+	 * \param func the function to call. Must be of form
+	 * double my_func(std::vector<ga2Gene> chromo_to_evaluate), and must be
+	 * safe to call from several threads if a scheduler is set.
+	 */
+	void setEvalFunc(double (* func)(std::vector<ga2Gene>)) {_evalFunc = func;};
+	///Set the scheduler used to breed and evaluate each block in parallel.
+	void setScheduler(ga2Scheduler *sched) {_scheduler = sched;};
+	///Set the minimum values for each gene.
+	void setMinRanges(std::vector<float> ranges);
+	///Set the maximum values for each gene.
+	void setMaxRanges(std::vector<float> ranges);
+	///Set the crossover function to use.
+	/**
+	 * \param type valid values are GA2_CROSSOVER_ONEPOINT or
+	 * GA2_CROSSOVER_UNIFORM
+	 */
+	void setCrossoverType(int type) {_crossoverType = type;};
+	///Set the replacement policy.
+	/**
+	 * \param type GA2_REPLACE_GENERATIONAL puts every child in the next
+	 * generation (the default); GA2_REPLACE_STEADYSTATE keeps a child only
+	 * if it is at least as fit as the chromosome in the slot it is bred
+	 * for, so nothing fit is ever lost.
+	 */
+	void setReplaceType(int type) {_replacementType = type;};
+	///Set the number of chromosomes in each selection tournament.
+	void setTournamentSize(int size) {_tournamentSize = size < 1 ? 1 : size;};
+	///Set the number of children bred between writes to the file.
+	/**
+	 * Larger blocks read the parents' pages in fewer, longer sweeps but
+	 * hold more genes in memory: three chromosomes per child.
+	 * The default is 4096.
+	 */
+	void setBlockSize(int size) {_blockSize = size < 1 ? 1 : size;};
+	///Set the probability of a gene mutating.
+	void setMutationRate(float mRate) {_mutationRate = mRate;};
+	///Set the probability of a pair of parents crossing-over.
+	void setCrossoverRate(float cRate) {_crossoverRate = cRate;};
+	///Are we using integer genes or floating point genes?
+	void setInteger(bool val) {_integer = val;};
+	///Set the seed that every random number is derived from.
+	void setSeed(uint64_t seed) {_seed = seed;};
+	///Create the files, then randomly initialise and evaluate every slot.
+	bool init(const char *path);
+	///Carry on from a population file written earlier.
+	bool open(const char *path);
+	///Breed, evaluate and replace one generation.
+	bool step(void);
+	///Make the file at the path a complete, checksummed checkpoint.
+	bool sync(void);
+	///Return the size of the population.
+	int getSize(void) {return _size;};
+	///Return the number of genes per chromosome.
+	int getChromoSize(void) {return _chromoSize;};
+	///Return the fitness of a single chromosome.
+	double getFitness(int index) {return _files[_current].getFitness()[index];};
+	///Return the genes of a single chromosome.
+	std::vector<ga2Gene> getGenes(int index);
+	///Return the most fit chromosome.
+	std::vector<ga2Gene> getBestFitChromosome(void) {return _bestGenes;};
+	///Return the highest fitness value in the population.
+	double getMaxFitness(void) {return _maxFitness;};
+	///Return the smallest fitness value in the population.
+	double getMinFitness(void) {return _minFitness;};
+	///Return the average fitness of the population.
+	double getAvgFitness(void) {return _avgFitness;};
+	///Return the sum of all fitness values in the population.
+	double getSumFitness(void) {return _sumFitness;};
+	///Return the generation number, carried over from the file by open().
+	long getGeneration(void) {return _generation;};
+	///Return the number of times the fitness function has been called.
+	long getEvaluationCount(void) {return _evaluations;};
+};
+
+#endif
@@ -0,0 +1,658 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2MultiObjective.cpp: implementation of the ga2MultiObjective class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <float.h>
+#include <functional>
+#include <map>
+#include <stdlib.h>
+#include <string.h>
+#include "ga2.h"
+
+//evaluates a range of chromosomes; handed to the scheduler.
+class ga2MultiObjectiveTask : public ga2Task
+{
+	ga2MultiObjective &_mo;
+	int _offset;
+public:
+	ga2MultiObjectiveTask(ga2MultiObjective &mo, int offset) : _mo(mo), _offset(offset) {};
+	void run(int begin, int end) {_mo._evaluate(_offset + begin, _offset + end);};
+};
+
+//orders points lexicographically on their objectives, best first
+class ga2LexGreater
+{
+	const double *_obj;
+	int _m;
+public:
+	ga2LexGreater(const double *obj, int m) : _obj(obj), _m(m) {};
+	bool operator()(int a, int b) const
+	{
+		const double *x = _obj + (size_t)a * _m, *y = _obj + (size_t)b * _m;
+		int k;
+		for(k = 0; k < _m; ++k)
+			if(x[k] != y[k])
+				return x[k] > y[k];
+		return false;
+	};
+};
+
+//orders points on a single objective, worst first
+class ga2ObjectiveLess
+{
+	const double *_obj;
+	int _m, _k;
+public:
+	ga2ObjectiveLess(const double *obj, int m, int k) : _obj(obj), _m(m), _k(k) {};
+	bool operator()(int a, int b) const {return _obj[(size_t)a * _m + _k] < _obj[(size_t)b * _m + _k];};
+};
+
+//orders members by front, then by crowding distance, best first
+class ga2CrowdedBetter
+{
+	const int *_rank;
+	const double *_crowding;
+public:
+	ga2CrowdedBetter(const int *rank, const double *crowding) : _rank(rank), _crowding(crowding) {};
+	bool operator()(int a, int b) const
+	{
+		if(_rank[a] != _rank[b])
+			return _rank[a] < _rank[b];
+		return _crowding[a] > _crowding[b];
+	};
+};
+
+//Jensen's divide and conquer non-dominated sort, generalised by Fortin et
+//al. to points that share values. Points are indices into the objective
+//array, and every list handed around is in lexicographic order, best
+//first; no two points are equal in every objective. Front numbers only
+//ever go up, each step raising a point to one more than the front of a
+//point shown to dominate it.
+class ga2NondominatedSorter
+{
+	const double *_obj;
+	int _m;
+	int *_front;
+	typedef std::map< double, int, std::greater<double> > _Stairs;
+
+	double _value(int p, int k) const {return _obj[(size_t)p * _m + k];};
+
+	//is a at least as good as b in objectives 0 to obj?
+	bool _weaklyDominates(int a, int b, int obj) const
+	{
+		int k;
+		for(k = 0; k <= obj; ++k)
+			if(_value(a, k) < _value(b, k))
+				return false;
+		return true;
+	};
+
+	void _raise(int p, int dominator)
+	{
+		if(_front[p] <= _front[dominator])
+			_front[p] = _front[dominator] + 1;
+	};
+
+	double _median(const std::vector<int> &s, int obj)
+	{
+		std::vector<double> v(s.size());
+		size_t i;
+		for(i = 0; i < s.size(); ++i)
+			v[i] = _value(s[i], obj);
+		std::nth_element(v.begin(), v.begin() + v.size()/2, v.end());
+		return v[v.size()/2];
+	};
+
+	//the highest front among points at least as good as value in objective
+	//1, or -1. The stairs run from best to worst in objective 1, with
+	//fronts strictly rising, so that is the last step at or above value.
+	int _highestAbove(_Stairs &stairs, double value)
+	{
+		_Stairs::iterator it = stairs.upper_bound(value);
+		if(it == stairs.begin())
+			return -1;
+		--it;
+		return it->second;
+	};
+
+	//adds a point, then drops the steps it makes redundant: those below
+	//it in objective 1 and no higher in front.
+	void _addStair(_Stairs &stairs, double value, int front)
+	{
+		if(_highestAbove(stairs, value) >= front)
+			return;
+		_Stairs::iterator it = stairs.upper_bound(value);
+		while( (it != stairs.end()) && (it->second <= front) )
+			it = stairs.erase(it);
+		stairs[value] = front;
+	};
+
+	//two objectives left: everything earlier in the list is at least as
+	//good in objective 0, so a point is dominated by exactly the earlier
+	//points that are at least as good in objective 1.
+	void _sweepA(const std::vector<int> &s)
+	{
+		_Stairs stairs;
+		size_t i;
+		for(i = 0; i < s.size(); ++i)
+		{
+			double v = _value(s[i], 1);
+			int f = _highestAbove(stairs, v);
+			if(_front[s[i]] <= f)
+				_front[s[i]] = f + 1;
+			_addStair(stairs, v, _front[s[i]]);
+		}
+	};
+
+	//as _sweepA, but only the points in l are added to the stairs and only
+	//the points in h are raised.
+	void _sweepB(const std::vector<int> &l, const std::vector<int> &h)
+	{
+		_Stairs stairs;
+		size_t i, j = 0;
+		for(i = 0; i < h.size(); ++i)
+		{
+			double h0 = _value(h[i], 0), h1 = _value(h[i], 1);
+			while(j < l.size())
+			{
+				double l0 = _value(l[j], 0), l1 = _value(l[j], 1);
+				if( (l0 < h0) || ( (l0 == h0) && (l1 < h1) ) )
+					break;
+				_addStair(stairs, l1, _front[l[j]]);
+				++j;
+			}
+			int f = _highestAbove(stairs, h1);
+			if(_front[h[i]] <= f)
+				_front[h[i]] = f + 1;
+		}
+	};
+
+public:
+	ga2NondominatedSorter(const double *obj, int m, int *front) : _obj(obj), _m(m), _front(front) {};
+
+	//ranks the points of s against each other on objectives 0 to obj. The
+	//points of s are equal in every objective after obj.
+	void helperA(const std::vector<int> &s, int obj)
+	{
+		size_t i;
+		if(s.size() < 2)
+			return;
+		if(s.size() == 2)
+		{
+			if(_weaklyDominates(s[0], s[1], obj))
+				_raise(s[1], s[0]);
+			return;
+		}
+		if(obj == 1)
+		{
+			_sweepA(s);
+			return;
+		}
+		double lo = _value(s[0], obj), hi = lo;
+		for(i = 1; i < s.size(); ++i)
+		{
+			double v = _value(s[i], obj);
+			lo = std::min(lo, v);
+			hi = std::max(hi, v);
+		}
+		if(lo == hi)
+		{
+			helperA(s, obj - 1);
+			return;
+		}
+
+		//split on the median, with the points equal to it on whichever
+		//side balances the halves better
+		double med = _median(s, obj);
+		int above = 0, below = 0, equal = 0;
+		for(i = 0; i < s.size(); ++i)
+		{
+			double v = _value(s[i], obj);
+			if(v > med)
+				++above;
+			else if(v < med)
+				++below;
+			else
+				++equal;
+		}
+		bool equalAbove = abs(above + equal - below) <= abs(above - below - equal);
+		std::vector<int> best, worst;
+		for(i = 0; i < s.size(); ++i)
+		{
+			double v = _value(s[i], obj);
+			if( (v > med) || ( (v == med) && equalAbove ) )
+				best.push_back(s[i]);
+			else
+				worst.push_back(s[i]);
+		}
+		helperA(best, obj);
+		helperB(best, worst, obj - 1);
+		helperA(worst, obj);
+	};
+
+	//raises the points of h by those of l, on objectives 0 to obj, given
+	//that l already has its final fronts and is at least as good as h in
+	//every objective after obj.
+	void helperB(const std::vector<int> &l, const std::vector<int> &h, int obj)
+	{
+		size_t i, j;
+		if(l.empty() || h.empty())
+			return;
+		if( (l.size() == 1) || (h.size() == 1) )
+		{
+			for(i = 0; i < h.size(); ++i)
+				for(j = 0; j < l.size(); ++j)
+					if(_weaklyDominates(l[j], h[i], obj))
+						_raise(h[i], l[j]);
+			return;
+		}
+		if(obj == 1)
+		{
+			_sweepB(l, h);
+			return;
+		}
+		double lMin = _value(l[0], obj), lMax = lMin, hMin = _value(h[0], obj), hMax = hMin;
+		for(i = 1; i < l.size(); ++i)
+		{
+			lMin = std::min(lMin, _value(l[i], obj));
+			lMax = std::max(lMax, _value(l[i], obj));
+		}
+		for(i = 1; i < h.size(); ++i)
+		{
+			hMin = std::min(hMin, _value(h[i], obj));
+			hMax = std::max(hMax, _value(h[i], obj));
+		}
+		if(lMin >= hMax)
+		{
+			helperB(l, h, obj - 1);
+			return;
+		}
+		if(lMax < hMin) //nothing in l can dominate anything in h
+			return;
+
+		double med = _median(l.size() > h.size() ? l : h, obj);
+		int lAbove = 0, lBelow = 0, lEqual = 0, hAbove = 0, hBelow = 0, hEqual = 0;
+		for(i = 0; i < l.size(); ++i)
+		{
+			double v = _value(l[i], obj);
+			if(v > med)
+				++lAbove;
+			else if(v < med)
+				++lBelow;
+			else
+				++lEqual;
+		}
+		for(i = 0; i < h.size(); ++i)
+		{
+			double v = _value(h[i], obj);
+			if(v > med)
+				++hAbove;
+			else if(v < med)
+				++hBelow;
+			else
+				++hEqual;
+		}
+		bool equalAbove = abs(lAbove + lEqual - lBelow + hAbove + hEqual - hBelow)
+					   <= abs(lAbove - lBelow - lEqual + hAbove - hBelow - hEqual);
+		std::vector<int> l1, l2, h1, h2;
+		for(i = 0; i < l.size(); ++i)
+		{
+			double v = _value(l[i], obj);
+			if( (v > med) || ( (v == med) && equalAbove ) )
+				l1.push_back(l[i]);
+			else
+				l2.push_back(l[i]);
+		}
+		for(i = 0; i < h.size(); ++i)
+		{
+			double v = _value(h[i], obj);
+			if( (v > med) || ( (v == med) && equalAbove ) )
+				h1.push_back(h[i]);
+			else
+				h2.push_back(h[i]);
+		}
+		helperB(l1, h1, obj);
+		helperB(l1, h2, obj - 1);
+		helperB(l2, h2, obj);
+	};
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param size Number of members. Rounded up to two.
+ * \param chromoSize Number of genes per chromosome.
+ * \param numObjectives Number of values the evaluation function returns.
+ */
+ga2MultiObjective::ga2MultiObjective( int size, int chromoSize, int numObjectives )
+	: _size(size < 2 ? 2 : size), _chromoSize(chromoSize), _numObjectives(numObjectives < 1 ? 1 : numObjectives)
+{
+	_evalFunc = NULL;
+	_scheduler = NULL;
+	_mutationRate = 0.01;
+	_crossoverRate = 0.9;
+	_crossoverType = GA2_CROSSOVER_UNIFORM;
+	_integer = false;
+	_generations = 0;
+	_evaluations = 0;
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2MultiObjective::~ga2MultiObjective()
+{
+}
+
+/**
+ * \param objectives n rows of numObjectives values, higher being better.
+ * \param n Number of points.
+ * \param numObjectives Number of objectives.
+ * \param rank Filled in with the front of each point: 0 for points no
+ * other point dominates, 1 for points only those of front 0 dominate, and
+ * so on. Points with equal objectives share a front.
+ *
+ * Takes O(n log^(numObjectives-1) n) time.
+ */
+void ga2MultiObjective::nondominatedSort(const double *objectives, int n, int numObjectives, int *rank)
+{
+	if( (n <= 0) || (numObjectives <= 0) )
+		return;
+	std::vector<int> order(n);
+	int i, k;
+	for(i = 0; i < n; ++i)
+		order[i] = i;
+	ga2LexGreater greater(objectives, numObjectives);
+	std::sort(order.begin(), order.end(), greater);
+
+	//sort only one of each group of equal points, and share its front
+	std::vector<int> unique, same(n);
+	unique.reserve(n);
+	for(i = 0; i < n; ++i)
+	{
+		int p = order[i];
+		rank[p] = 0;
+		if( !unique.empty() && !greater(unique.back(), p) )
+			same[p] = unique.back();
+		else
+		{
+			same[p] = p;
+			unique.push_back(p);
+		}
+	}
+	if(numObjectives == 1)
+	{
+		for(k = 0; k < unique.size(); ++k)
+			rank[unique[k]] = k;
+	}
+	else
+	{
+		ga2NondominatedSorter sorter(objectives, numObjectives, rank);
+		sorter.helperA(unique, numObjectives - 1);
+	}
+	for(i = 0; i < n; ++i)
+		rank[i] = rank[same[i]];
+}
+
+//sorts the first n chromosomes into fronts, and works out the crowding
+//distance of each within its front: the sum over the objectives of the gap
+//between its neighbours either side, as a fraction of the front's spread.
+//The ends of each front are never crowded.
+void ga2MultiObjective::_rankAndCrowd(int n)
+{
+	const double *obj = &_objectives[0];
+	int m = _numObjectives;
+	nondominatedSort(obj, n, m, &_rank[0]);
+
+	//bucket the members by front
+	int i, j, k, fronts = 0;
+	for(i = 0; i < n; ++i)
+		fronts = std::max(fronts, _rank[i] + 1);
+	std::vector<int> start(fronts + 1, 0);
+	for(i = 0; i < n; ++i)
+		++start[_rank[i] + 1];
+	for(i = 0; i < fronts; ++i)
+		start[i+1] += start[i];
+	std::vector<int> fill(start.begin(), start.end() - 1);
+	_order.resize(n);
+	for(i = 0; i < n; ++i)
+		_order[fill[_rank[i]]++] = i;
+
+	for(i = 0; i < n; ++i)
+		_crowding[i] = 0.0;
+	for(i = 0; i < fronts; ++i)
+	{
+		int *front = &_order[start[i]];
+		int size = start[i+1] - start[i];
+		for(k = 0; k < m; ++k)
+		{
+			std::sort(front, front + size, ga2ObjectiveLess(obj, m, k));
+			double lo = obj[(size_t)front[0] * m + k];
+			double range = obj[(size_t)front[size-1] * m + k] - lo;
+			_crowding[front[0]] = _crowding[front[size-1]] = DBL_MAX;
+			if(range <= 0.0)
+				continue;
+			for(j = 1; j < size - 1; ++j)
+			{
+				if(_crowding[front[j]] == DBL_MAX)
+					continue;
+				_crowding[front[j]] += (obj[(size_t)front[j+1] * m + k] - obj[(size_t)front[j-1] * m + k]) / range;
+			}
+		}
+	}
+}
+
+ga2Gene ga2MultiObjective::_randomGene(int i)
+{
+	float range = _chromoMaxRanges[i] - _chromoMinRanges[i];
+	float f;
+	if(_integer)
+	{
+		f = (_random.uniform() * (range+1)) + _chromoMinRanges[i];
+		f = (int)f; //trunc it down to size
+	}
+	else //no rounding
+		f = (_random.uniform() * range) + _chromoMinRanges[i];
+	return f;
+}
+
+void ga2MultiObjective::_evaluate(int begin, int end)
+{
+	std::vector<ga2Gene> scratch(_chromoSize);
+	std::vector<double> result;
+	int i, k;
+	for(i = begin; i < end; ++i)
+	{
+		scratch.assign(&_genes[(size_t)i * _chromoSize], &_genes[(size_t)i * _chromoSize] + _chromoSize);
+		if(_evalFunc)
+			result = _evalFunc(scratch);
+		double *o = &_objectives[(size_t)i * _numObjectives];
+		for(k = 0; k < _numObjectives; ++k)
+			o[k] = k < result.size() ? result[k] : 0.0;
+	}
+}
+
+//binary tournament on front, then crowding
+int ga2MultiObjective::_tournament(void)
+{
+	int a = _random.below(_size), b = _random.below(_size);
+	if(_rank[a] != _rank[b])
+		return _rank[a] < _rank[b] ? a : b;
+	return _crowding[a] >= _crowding[b] ? a : b;
+}
+
+/**
+ * Returns false if the ranges have not been set.
+ */
+bool ga2MultiObjective::init(void)
+{
+	if( (_chromoMaxRanges.size() != _chromoSize) || (_chromoMinRanges.size() != _chromoSize) )
+		return false;
+	size_t slots = 2 * (size_t)_size;
+	_genes.assign(slots * _chromoSize, 0.0);
+	_objectives.assign(slots * _numObjectives, 0.0);
+	_nextGenes.assign(slots * _chromoSize, 0.0);
+	_nextObjectives.assign(slots * _numObjectives, 0.0);
+	_rank.assign(slots, 0);
+	_crowding.assign(slots, 0.0);
+	int i, j;
+	for(i = 0; i < _size; ++i)
+		for(j = 0; j < _chromoSize; ++j)
+			_genes[(size_t)i * _chromoSize + j] = _randomGene(j);
+	ga2MultiObjectiveTask task(*this, 0);
+	if(_scheduler)
+		_scheduler->parallelFor(task, _size);
+	else
+		task.run(0, _size);
+	_evaluations += _size;
+	_rankAndCrowd(_size);
+	_generations = 0;
+	return true;
+}
+
+/**
+ * The population is ranked and crowded afresh as parents and offspring
+ * together, so ga2MultiObjective::getRank() and
+ * ga2MultiObjective::getCrowding() describe the members within that larger
+ * set. Initialises the population if that has not been done.
+ */
+bool ga2MultiObjective::step(void)
+{
+	if(_rank.empty() && !init())
+		return false;
+	int n = _size, L = _chromoSize, M = _numObjectives;
+	int i, j;
+
+	//breed a full generation of offspring into the upper half
+	for(i = 0; i < n; i += 2)
+	{
+		ga2Gene *a = &_genes[(size_t)(n + i) * L];
+		ga2Gene *b = (i+1 < n) ? a + L : NULL;
+		memcpy(a, &_genes[(size_t)_tournament() * L], L * sizeof(ga2Gene));
+		const ga2Gene *mate = &_genes[(size_t)_tournament() * L];
+		if(b)
+			memcpy(b, mate, L * sizeof(ga2Gene));
+		if(_random.uniform() <= _crossoverRate)
+		{
+			int coPoint = _random.below(L);
+			for(j = 0; j < L; ++j)
+			{
+				bool swap = (_crossoverType == GA2_CROSSOVER_UNIFORM) ?
+							(_random.next() >> 63) : (j >= coPoint);
+				if(!swap)
+					continue;
+				ga2Gene t = a[j];
+				a[j] = mate[j];
+				if(b)
+					b[j] = t;
+			}
+		}
+		for(j = 0; j < L; ++j)
+		{
+			if(_random.uniform() <= _mutationRate)
+				a[j] = _randomGene(j);
+			if(b && _random.uniform() <= _mutationRate)
+				b[j] = _randomGene(j);
+		}
+	}
+	ga2MultiObjectiveTask task(*this, n);
+	if(_scheduler)
+		_scheduler->parallelFor(task, n);
+	else
+		task.run(0, n);
+	_evaluations += n;
+
+	//rank everybody, and keep the best half
+	_rankAndCrowd(2 * n);
+	std::vector<int> order(2 * n);
+	for(i = 0; i < 2 * n; ++i)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), ga2CrowdedBetter(&_rank[0], &_crowding[0]));
+	std::vector<int> rank(2 * n, 0);
+	std::vector<double> crowding(2 * n, 0.0);
+	for(i = 0; i < n; ++i)
+	{
+		int p = order[i];
+		memcpy(&_nextGenes[(size_t)i * L], &_genes[(size_t)p * L], L * sizeof(ga2Gene));
+		memcpy(&_nextObjectives[(size_t)i * M], &_objectives[(size_t)p * M], M * sizeof(double));
+		rank[i] = _rank[p];
+		crowding[i] = _crowding[p];
+	}
+	_genes.swap(_nextGenes);
+	_objectives.swap(_nextObjectives);
+	_rank.swap(rank);
+	_crowding.swap(crowding);
+	++_generations;
+	return true;
+}
+
+/**
+ * \param generations Number of generations to step.
+ */
+bool ga2MultiObjective::run(int generations)
+{
+	int g;
+	for(g = 0; g < generations; ++g)
+		if(!step())
+			return false;
+	return true;
+}
+
+std::vector<ga2Gene> ga2MultiObjective::getGenes(int index)
+{
+	if( (index < 0) || (index >= _size) || _genes.empty() )
+		return std::vector<ga2Gene>();
+	const ga2Gene *g = &_genes[(size_t)index * _chromoSize];
+	return std::vector<ga2Gene>(g, g + _chromoSize);
+}
+
+std::vector<int> ga2MultiObjective::getParetoFront(void)
+{
+	std::vector<int> front;
+	int i;
+	for(i = 0; i < _size && i < _rank.size(); ++i)
+		if(_rank[i] == 0)
+			front.push_back(i);
+	return front;
+}
+
+/**
+ * \param ranges A vector containing the upper bound for the values of each
+ * gene.
+ */
+void ga2MultiObjective::setMaxRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMaxRanges = ranges;
+}
+
+/**
+ * \param ranges A vector containing the lower bound for the values of each
+ * gene.
+ */
+void ga2MultiObjective::setMinRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMinRanges = ranges;
+}
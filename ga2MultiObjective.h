@@ -0,0 +1,143 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2MultiObjective.h: interface for the ga2MultiObjective class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2MULTIOBJECTIVE_H__
+#define __GA2MULTIOBJECTIVE_H__
+
+#include <vector>
+#include "ga2Gene.h"
+#include "ga2Random.h"
+#include "ga2Scheduler.h"
+
+///A population that optimises several objectives at once, by NSGA-II.
+/**
+ * The ga2MultiObjective class is for problems with no single fitness, such
+ * as cost against latency against risk. The evaluation function returns a
+ * vector of objectives, and, as with fitness everywhere else in ga2,
+ * higher is better for each of them: negate anything to be minimised. One
+ * chromosome dominates another if it is at least as good in every
+ * objective and better in at least one.
+ *
+ * Each generation breeds as many offspring as there are members, by binary
+ * tournament, crossover and mutation. Parents and offspring are then
+ * ranked together into fronts by non-dominated sorting (front 0 is
+ * dominated by nobody, front 1 only by front 0, and so on), and the
+ * population is refilled front by front. The front that does not fit is
+ * cut by crowding distance, keeping the members in the least crowded parts
+ * of the front. Tournaments are decided on front, then on crowding.
+ *
+ * Sorting uses Jensen's divide and conquer algorithm, with Fortin's
+ * generalisation to ties, which takes O(N log^(M-1) N) time for N
+ * chromosomes and M objectives instead of the O(M N^2) of the usual
+ * pairwise comparison, so populations of hundreds of thousands are
+ * practical. Genes and objectives live in flat arrays, as in ga2MultiRun.
+ */
+class ga2MultiObjective
+{
+	int _size;
+	int _chromoSize;
+	int _numObjectives;
+
+	std::vector<double>(* _evalFunc)(std::vector<ga2Gene>);
+	ga2Scheduler *_scheduler;
+	std::vector<float> _chromoMaxRanges;
+	std::vector<float> _chromoMinRanges;
+	double _mutationRate;
+	double _crossoverRate;
+	int _crossoverType;
+	bool _integer;
+	ga2Random _random;
+	long _generations;
+	long _evaluations;
+
+	//members in [0, size), offspring in [size, 2 size)
+	std::vector<ga2Gene> _genes;
+	std::vector<double> _objectives;
+	std::vector<int> _rank;
+	std::vector<double> _crowding;
+	//scratch, kept to save reallocating every generation
+	std::vector<ga2Gene> _nextGenes;
+	std::vector<double> _nextObjectives;
+	std::vector<int> _order;
+
+	friend class ga2MultiObjectiveTask;
+	ga2Gene _randomGene(int i);
+	int _tournament(void);
+	void _evaluate(int begin, int end);
+	void _rankAndCrowd(int n);
+
+public:
+	///The constructor.
+	ga2MultiObjective( int size, int chromoSize, int numObjectives );
+	///The destructor.
+	virtual ~ga2MultiObjective();
+	///Set the evaluation function to use.
+	/**
+	 * \param func the function to call. Must be of form
+	 * std::vector<double> my_func(std::vector<ga2Gene> chromo_to_evaluate),
+	 * returning one value per objective, and must be safe to call from
+	 * several threads if a scheduler is set.
+	 */
+	void setEvalFunc(std::vector<double> (* func)(std::vector<ga2Gene>)) {_evalFunc = func;};
+	///Set the scheduler evaluations are spread over.
+	void setScheduler(ga2Scheduler *sched) {_scheduler = sched;};
+	///Set the minimum values for each gene.
+	void setMinRanges(std::vector<float> ranges);
+	///Set the maximum values for each gene.
+	void setMaxRanges(std::vector<float> ranges);
+	///Set the probability of each gene of an offspring mutating.
+	void setMutationRate(float mRate) {_mutationRate = mRate;};
+	///Set the probability of a pair of parents crossing-over.
+	void setCrossoverRate(float cRate) {_crossoverRate = cRate;};
+	///Set the crossover: GA2_CROSSOVER_ONEPOINT or GA2_CROSSOVER_UNIFORM.
+	void setCrossoverType(int type) {_crossoverType = type;};
+	///Are we using integer genes or floating point genes?
+	void setInteger(bool val) {_integer = val;};
+	///Restart the random number generator from a seed.
+	void setSeed(uint64_t seed) {_random.setSeed(seed);};
+	///Randomly initialise, evaluate and rank the population.
+	bool init(void);
+	///Run one generation: breed, evaluate, sort and cut back.
+	bool step(void);
+	///Run a number of generations.
+	bool run(int generations);
+	///Return the size of the population.
+	int getSize(void) {return _size;};
+	///Return the number of objectives.
+	int getNumObjectives(void) {return _numObjectives;};
+	///Return the number of generations stepped.
+	long getGenerations(void) {return _generations;};
+	///Return the number of chromosomes evaluated.
+	long getEvaluations(void) {return _evaluations;};
+	///Return the genes of a member.
+	std::vector<ga2Gene> getGenes(int index);
+	///Return one objective of a member.
+	double getObjective(int index, int objective) {return _objectives[(size_t)index * _numObjectives + objective];};
+	///Return the front a member is in; 0 is the best.
+	int getRank(int index) {return _rank[index];};
+	///Return the crowding distance of a member within its front.
+	double getCrowding(int index) {return _crowding[index];};
+	///Return the indices of the members in the best front.
+	std::vector<int> getParetoFront(void);
+	///Rank points into non-dominated fronts.
+	static void nondominatedSort(const double *objectives, int n, int numObjectives, int *rank);
+};
+
+#endif
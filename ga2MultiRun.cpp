@@ -0,0 +1,403 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2MultiRun.cpp: implementation of the ga2MultiRun class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+#include <time.h>
+#include "ga2.h"
+
+//advances whole runs; handed to the scheduler, one item per run.
+class ga2MultiRunTask : public ga2Task
+{
+	ga2MultiRun &_multi;
+	int _generations;
+public:
+	ga2MultiRunTask(ga2MultiRun &multi, int generations)
+		: _multi(multi), _generations(generations) {};
+	void run(int begin, int end)
+	{
+		std::vector<ga2Gene> scratch(_multi._chromoSize);
+		int r, g;
+		for(r = begin; r < end; ++r)
+		{
+			if(!_multi._isInitialised)
+				_multi._initRun(r, scratch);
+			for(g = 0; g < _generations; ++g)
+				_multi._generation(r, scratch);
+			_multi._updateResult(r);
+		}
+	};
+};
+
+//sorts slot indices by fitness, best first
+class ga2FitterThan
+{
+	const double *_fitness;
+public:
+	ga2FitterThan(const double *fitness) : _fitness(fitness) {};
+	bool operator()(int a, int b) const {return _fitness[a] > _fitness[b];};
+};
+
+ga2RunParams::ga2RunParams()
+{
+	size = 50;
+	mutationRate = 0.01;
+	crossoverRate = 0.9;
+	crossoverType = GA2_CROSSOVER_ONEPOINT;
+	selectionType = GA2_SELECT_ROULETTE;
+	replacementType = GA2_REPLACE_GENERATIONAL;
+	replacementSize = 10;
+	integer = false;
+	seed = time(NULL);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param chromoSize Number of genes per chromosome, the same for every run.
+ */
+ga2MultiRun::ga2MultiRun( int chromoSize ) : _chromoSize(chromoSize)
+{
+	_evalFunc = NULL;
+	_scheduler = NULL;
+	_isInitialised = false;
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2MultiRun::~ga2MultiRun()
+{
+}
+
+/**
+ * \param params The settings for the new run. Sizes below two are
+ * rounded up to two.
+ *
+ * Runs can only be added before the first call to ga2MultiRun::run().
+ */
+int ga2MultiRun::addRun(const ga2RunParams &params)
+{
+	if(_isInitialised)
+		return -1;
+	_params.push_back(params);
+	if(_params.back().size < 2)
+		_params.back().size = 2;
+	return _params.size() - 1;
+}
+
+//lays every run out in the shared arrays: each run gets its population
+//followed by room for a full generation of offspring.
+void ga2MultiRun::_allocate(void)
+{
+	int r;
+	long total = 0;
+	_offset.clear();
+	for(r = 0; r < _params.size(); ++r)
+	{
+		_offset.push_back(total);
+		total += 2 * _params[r].size;
+	}
+	_genes.assign((size_t)total * _chromoSize, 0.0);
+	_fitness.assign(total, 0.0);
+	_wheel.assign(total, 0.0);
+	_order.assign(total, 0);
+	_results.assign(_params.size(), ga2RunResult());
+	_random.resize(_params.size());
+	for(r = 0; r < _params.size(); ++r) //runs added from the same params still differ
+		_random[r].setSeed(_params[r].seed + r * 0x9E3779B97F4A7C15ULL);
+}
+
+/**
+ * \param generations Number of generations to advance each run by.
+ *
+ * The first call allocates the shared storage and randomly initialises
+ * every run; later calls carry on where the previous one stopped. Returns
+ * false if the ranges have not been set, or there are no runs.
+ */
+bool ga2MultiRun::run(int generations)
+{
+	if( (_chromoMaxRanges.size() != _chromoSize)
+	  ||(_chromoMinRanges.size() != _chromoSize)
+	  ||_params.empty() )
+		return false;
+	if(!_isInitialised)
+		_allocate();
+
+	ga2MultiRunTask task(*this, generations);
+	if(_scheduler)
+		_scheduler->parallelFor(task, _params.size());
+	else
+		task.run(0, _params.size());
+	_isInitialised = true;
+	return true;
+}
+
+ga2Gene ga2MultiRun::_randomGene(int r, ga2Random &rng, int i)
+{
+	float range = _chromoMaxRanges[i] - _chromoMinRanges[i];
+	float f;
+	if(_params[r].integer)
+	{
+		f = (rng.uniform() * (range+1)) + _chromoMinRanges[i];
+		f = (int)f; //trunc it down to size
+	}
+	else //no rounding
+		f = (rng.uniform() * range) + _chromoMinRanges[i];
+	return f;
+}
+
+double ga2MultiRun::_evaluate(const ga2Gene *genes, std::vector<ga2Gene> &scratch)
+{
+	if(_evalFunc == NULL)
+		return 0;
+	scratch.assign(genes, genes + _chromoSize);
+	return _evalFunc(scratch);
+}
+
+void ga2MultiRun::_initRun(int r, std::vector<ga2Gene> &scratch)
+{
+	ga2Random &rng = _random[r];
+	int n = _params[r].size;
+	ga2Gene *pop = &_genes[(size_t)_offset[r] * _chromoSize];
+	double *fit = &_fitness[_offset[r]];
+	int i, j;
+	for(i = 0; i < n; ++i)
+	{
+		ga2Gene *g = pop + (size_t)i * _chromoSize;
+		for(j = 0; j < _chromoSize; ++j)
+			g[j] = _randomGene(r, rng, j);
+		fit[i] = _evaluate(g, scratch);
+	}
+	_results[r].generations = 0;
+	_results[r].evaluations = n;
+}
+
+//builds the wheel for this generation, then spins it by binary search
+//instead of walking the population for every pick.
+int ga2MultiRun::_select(int r, ga2Random &rng)
+{
+	int n = _params[r].size;
+	const double *wheel = &_wheel[_offset[r]];
+	double spin = rng.uniform() * wheel[n-1];
+	int i = std::upper_bound(wheel, wheel + n, spin) - wheel;
+	if(i >= n)
+		i = n-1;
+	if(_params[r].selectionType == GA2_SELECT_RANKED)
+		return _order[_offset[r] + i];
+	return i;
+}
+
+void ga2MultiRun::_generation(int r, std::vector<ga2Gene> &scratch)
+{
+	const ga2RunParams &p = _params[r];
+	ga2Random &rng = _random[r];
+	int n = p.size, L = _chromoSize;
+	ga2Gene *pop = &_genes[(size_t)_offset[r] * L];
+	ga2Gene *next = pop + (size_t)n * L;
+	double *fit = &_fitness[_offset[r]];
+	double *nextFit = fit + n;
+	double *wheel = &_wheel[_offset[r]];
+	int *order = &_order[_offset[r]];
+	int i, j;
+
+	//set up the wheel
+	double sum = 0.0;
+	if(p.selectionType == GA2_SELECT_RANKED)
+	{
+		for(i = 0; i < n; ++i)
+			order[i] = i;
+		std::sort(order, order + n, ga2FitterThan(fit));
+		for(i = 0; i < n; ++i)
+			wheel[i] = sum += n - i;
+	}
+	else
+	{
+		for(i = 0; i < n; ++i)
+			wheel[i] = sum += (fit[i] > 0.0 ? fit[i] : 0.0);
+		if(sum <= 0.0) //nobody has any fitness; pick uniformly
+			for(i = 0; i < n; ++i)
+				wheel[i] = i+1;
+	}
+
+	//breed
+	int m = n;
+	if(p.replacementType != GA2_REPLACE_GENERATIONAL)
+		m = p.replacementSize < n ? p.replacementSize : n;
+	for(i = 0; i < m; i += 2)
+	{
+		ga2Gene *a = next + (size_t)i * L;
+		ga2Gene *b = (i+1 < m) ? a + L : NULL;
+		memcpy(a, pop + (size_t)_select(r, rng) * L, L * sizeof(ga2Gene));
+		const ga2Gene *mate = pop + (size_t)_select(r, rng) * L;
+		if(b)
+			memcpy(b, mate, L * sizeof(ga2Gene));
+
+		if(rng.uniform() <= p.crossoverRate)
+		{
+			int coPoint = rng.below(L);
+			for(j = 0; j < L; ++j)
+			{
+				bool swap = (p.crossoverType == GA2_CROSSOVER_UNIFORM) ?
+							(rng.next() >> 63) : (j >= coPoint);
+				if(!swap)
+					continue;
+				ga2Gene t = a[j];
+				a[j] = mate[j];
+				if(b)
+					b[j] = t;
+			}
+		}
+		for(j = 0; j < L; ++j)
+		{
+			if(rng.uniform() <= p.mutationRate)
+				a[j] = _randomGene(r, rng, j);
+			if(b && rng.uniform() <= p.mutationRate)
+				b[j] = _randomGene(r, rng, j);
+		}
+		nextFit[i] = _evaluate(a, scratch);
+		if(b)
+			nextFit[i+1] = _evaluate(b, scratch);
+	}
+	_results[r].evaluations += m;
+
+	//replace
+	if(p.replacementType == GA2_REPLACE_GENERATIONAL)
+	{
+		memcpy(pop, next, (size_t)n * L * sizeof(ga2Gene));
+		memcpy(fit, nextFit, n * sizeof(double));
+	}
+	else
+	{
+		//keep the best n of the union: walk the offspring from best to worst
+		//against the population from worst to best
+		for(i = 0; i < n; ++i)
+			order[i] = i;
+		std::sort(order, order + n, ga2FitterThan(fit));
+		int *kids = order + n;
+		for(i = 0; i < m; ++i)
+			kids[i] = i;
+		std::sort(kids, kids + m, ga2FitterThan(nextFit));
+		int worst = n-1;
+		for(i = 0; i < m && worst >= 0; ++i)
+		{
+			double f = nextFit[kids[i]];
+			if(f <= fit[order[worst]])
+				break;
+			if(p.replacementType == GA2_REPLACE_STEADYSTATENODUPLICATES)
+			{
+				for(j = 0; j < n; ++j)
+					if(fit[j] == f)
+						break;
+				if(j != n)
+					continue;
+			}
+			int slot = order[worst--];
+			memcpy(pop + (size_t)slot * L, next + (size_t)kids[i] * L, L * sizeof(ga2Gene));
+			fit[slot] = f;
+		}
+	}
+	++_results[r].generations;
+}
+
+void ga2MultiRun::_updateResult(int r)
+{
+	int n = _params[r].size;
+	const double *fit = &_fitness[_offset[r]];
+	ga2RunResult &res = _results[r];
+	double sum = 0.0;
+	int best = 0, i;
+	res.minFitness = DBL_MAX;
+	for(i = 0; i < n; ++i)
+	{
+		sum += fit[i];
+		if(fit[i] < res.minFitness)
+			res.minFitness = fit[i];
+		if(fit[i] > fit[best])
+			best = i;
+	}
+	res.maxFitness = fit[best];
+	res.avgFitness = sum / n;
+	const ga2Gene *g = &_genes[((size_t)_offset[r] + best) * _chromoSize];
+	res.best.assign(g, g + _chromoSize);
+}
+
+/**
+ * Returns the index of the run whose best chromosome is the fittest of
+ * all, or -1 if nothing has been run yet.
+ */
+int ga2MultiRun::getBestRun(void)
+{
+	if(!_isInitialised)
+		return -1;
+	int r, best = 0;
+	for(r = 1; r < _results.size(); ++r)
+		if(_results[r].maxFitness > _results[best].maxFitness)
+			best = r;
+	return best;
+}
+
+/**
+ * Prints a whitespace separated table with a header line, then one line
+ * per run: its index, settings, generations and evaluations done, and
+ * maximum, average and minimum fitness.
+ */
+void ga2MultiRun::printResults(std::ostream &out)
+{
+	out << "run size mutation crossover select replace seed"
+		<< " generations evaluations max avg min\n";
+	int r;
+	for(r = 0; r < _results.size(); ++r)
+	{
+		const ga2RunParams &p = _params[r];
+		const ga2RunResult &res = _results[r];
+		out << r << " " << p.size << " " << p.mutationRate << " "
+			<< p.crossoverRate << " " << p.selectionType << " "
+			<< p.replacementType << " " << p.seed << " "
+			<< res.generations << " " << res.evaluations << " "
+			<< res.maxFitness << " " << res.avgFitness << " "
+			<< res.minFitness << "\n";
+	}
+}
+
+/**
+ * \param ranges A vector containing the upper bound for the values of each
+ * gene.
+ */
+void ga2MultiRun::setMaxRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMaxRanges = ranges;
+}
+
+/**
+ * \param ranges A vector containing the lower bound for the values of each
+ * gene.
+ */
+void ga2MultiRun::setMinRanges(std::vector<float> ranges)
+{
+	if(ranges.size() != _chromoSize)
+		return;
+	_chromoMinRanges = ranges;
+}
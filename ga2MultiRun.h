@@ -0,0 +1,139 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2MultiRun.h: interface for the ga2MultiRun class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2MULTIRUN_H__
+#define __GA2MULTIRUN_H__
+
+#include <iostream>
+#include <vector>
+#include "ga2Gene.h"
+#include "ga2Random.h"
+#include "ga2Scheduler.h"
+
+///The settings of one run in a ga2MultiRun.
+/**
+ * The fields mean the same as the corresponding ga2Population setters.
+ * The constructor fills in reasonable defaults.
+ */
+struct ga2RunParams
+{
+	int size;
+	double mutationRate;
+	double crossoverRate;
+	int crossoverType;
+	int selectionType;
+	int replacementType;
+	int replacementSize;
+	bool integer;
+	uint64_t seed;
+
+	///The constructor.
+	ga2RunParams();
+};
+
+///The outcome of one run in a ga2MultiRun.
+struct ga2RunResult
+{
+	long generations;
+	long evaluations;
+	double maxFitness;
+	double avgFitness;
+	double minFitness;
+	std::vector<ga2Gene> best;
+};
+
+///Runs many small, independent GAs at once.
+/**
+ * The ga2MultiRun class is for random restarts and parameter sweeps: lots
+ * of small populations, all solving the same problem, each with its own
+ * parameters and its own random number generator. Rather than a separate
+ * ga2Population (and a separate heap full of ga2Chromosomes) for every run,
+ * all the runs share two flat arrays, one of genes and one of fitness
+ * values, with each run owning a contiguous slice. A whole run is one item
+ * of work for the ga2Scheduler, so runs proceed without waiting for each
+ * other, and the work-stealing evens out runs that take longer than
+ * others.
+ *
+ * Each run's generator starts from its seed mixed with its index, so
+ * adding the same ga2RunParams many times gives independent restarts,
+ * and the results do not depend on the number of threads.
+ */
+class ga2MultiRun
+{
+	int _chromoSize;
+	double(* _evalFunc)(std::vector<ga2Gene>);
+	ga2Scheduler *_scheduler;
+	std::vector<float> _chromoMaxRanges;
+	std::vector<float> _chromoMinRanges;
+
+	std::vector<ga2RunParams> _params;
+	std::vector<ga2RunResult> _results;
+	std::vector<ga2Random> _random;
+	std::vector<long> _offset;   //start of each run's slice, in chromosomes
+	std::vector<ga2Gene> _genes; //for each run: population, then offspring
+	std::vector<double> _fitness;
+	std::vector<double> _wheel;  //selection scratch, one per population slot
+	std::vector<int> _order;
+	bool _isInitialised;
+
+	friend class ga2MultiRunTask;
+	void _allocate(void);
+	void _initRun(int r, std::vector<ga2Gene> &scratch);
+	void _generation(int r, std::vector<ga2Gene> &scratch);
+	int _select(int r, ga2Random &rng);
+	ga2Gene _randomGene(int r, ga2Random &rng, int i);
+	double _evaluate(const ga2Gene *genes, std::vector<ga2Gene> &scratch);
+	void _updateResult(int r);
+
+public:
+	///The constructor.
+	ga2MultiRun( int chromoSize );
+	///The destructor.
+	virtual ~ga2MultiRun();
+	///Set the evaluation function shared by every run.
+	/**
+	 * \param func the function to call. Must be of form
+	 * double my_func(std::vector<ga2Gene> chromo_to_evaluate), and must be
+	 * safe to call from several threads if a scheduler is set.
+	 */
+	void setEvalFunc(double (* func)(std::vector<ga2Gene>)) {_evalFunc = func;};
+	///Set the scheduler the runs are spread over.
+	void setScheduler(ga2Scheduler *sched) {_scheduler = sched;};
+	///Set the minimum values for each gene.
+	void setMinRanges(std::vector<float> ranges);
+	///Set the maximum values for each gene.
+	void setMaxRanges(std::vector<float> ranges);
+	///Add a run. Returns its index, or -1 once the runs have started.
+	int addRun(const ga2RunParams &params);
+	///Return the number of runs.
+	int getNumRuns(void) {return _params.size();};
+	///Return the settings of a run.
+	const ga2RunParams &getParams(int run) {return _params[run];};
+	///Initialise every run (if not done yet) and advance each by some generations.
+	bool run(int generations);
+	///Return the outcome of a run so far.
+	const ga2RunResult &getResult(int run) {return _results[run];};
+	///Return the index of the run with the highest fitness.
+	int getBestRun(void);
+	///Print one line per run, with its settings and outcome.
+	void printResults(std::ostream &out);
+};
+
+#endif
@@ -21,8 +21,80 @@
 #include <fstream>
 #include <time.h>
 #include <math.h>
+#include <limits.h>
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+#include <chrono>
 #include "ga2.h"
 
+//the running statistics are recomputed from scratch this often (in calls
+//to evaluate()), so rounding errors cannot pile up
+#define GA2_STATS_RESYNC 1024
+//and about the mean afresh once it has moved this many standard deviations
+//from the shift they were kept about, before they start to cancel
+#define GA2_STATS_DRIFT 100.0
+
+//adaptive control. Operator quality is an exponential average of the
+//gains, taken at this rate; every crossover type keeps at least the minimum
+//probability, so one that falls behind early can still come back; and the
+//1/5th rule multiplies or divides the mutation strength by the step.
+#define GA2_ADAPT_RATE 0.3
+#define GA2_ADAPT_MINPROBABILITY 0.05
+#define GA2_ADAPT_STEP 1.1
+
+//local search steps are scaled to the population's spread in each gene,
+//but never below this fraction of its range; and it gives up on a
+//chromosome once its step has been halved below this fraction of the first
+#define GA2_LOCALSEARCH_MINSPREAD 1e-6
+#define GA2_LOCALSEARCH_MINSTEP 1e-3
+
+//where local search has got to with one chromosome
+struct ga2SearchState
+{
+	int coord; //gene being tried
+	int dir; //+1 or -1
+	double step; //of the population's spread
+	int used; //budget spent
+	int stalled; //moves tried since the last improvement
+};
+
+//evaluates a range of chromosomes; handed to the scheduler in batches.
+//holds on to the elements rather than the vector, so the vector itself can
+//be swapped while a batch is in flight.
+class ga2EvaluateTask : public ga2Task
+{
+	ga2Chromosome *_chromos;
+	ga2FitnessCache *_cache;
+public:
+	ga2EvaluateTask(std::vector< ga2Chromosome > &chromos, ga2FitnessCache *cache)
+		: _chromos(chromos.empty() ? NULL : &chromos[0]), _cache(cache) {};
+	void run(int begin, int end)
+	{
+		int i;
+		for(i = begin; i < end; ++i)
+		{
+			//copies carry their cache along, which may since have been
+			//swapped or detached
+			_chromos[i].setFitnessCache(_cache);
+			_chromos[i].getFitness();
+		}
+	};
+};
+
+ga2StopCriteria::ga2StopCriteria()
+{
+	maxGenerations = 0;
+	maxEvaluations = 0;
+	maxSeconds = 0.0;
+	useTargetFitness = false;
+	targetFitness = 0.0;
+	stagnationGenerations = 0;
+	stagnationTolerance = 0.0;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -40,6 +112,55 @@ ga2Population::ga2Population( int initialSize, int chromoSize ) : _size(initialS
 	srand(time(NULL));
 	_integer = false;
 	_isSorted = false;
+	_mutationRate = 0.0;
+	_crossoverRate = 1.0;
+	_replacementSize = 0;
+	_crossoverType = GA2_CROSSOVER_UNIFORM;
+	_mutationType = GA2_MUTATE_RESET;
+	_sbxEta = 15.0;
+	_blxAlpha = 0.5;
+	_mutationSigma = 0.1;
+	_polynomialEta = 20.0;
+	_operatorRandom.setSeed(rand());
+	_adaptiveMutation = false;
+	_successRate = 0.0;
+	int t;
+	for(t = 0; t < GA2_CROSSOVER_ADAPTIVE; ++t)
+	{
+		_operatorQuality[t] = 0.0;
+		_operatorProbability[t] = t ? 1.0 / (GA2_CROSSOVER_ADAPTIVE - 1) : 0.0;
+	}
+	_permutation = false;
+	_nicheType = GA2_NICHE_NONE;
+	_nicheRadius = 0.1;
+	_nicheCapacity = 1;
+	_localSearchMode = GA2_LOCALSEARCH_NONE;
+	_localSearchFraction = 0.0;
+	_localSearchBudget = 0;
+	_localSearchStep = 1.0;
+	_scheduler = NULL;
+	_pipelined = false;
+	_inFlightTask = NULL;
+	_inFlightJob = NULL;
+	_genealogy = NULL;
+	_parentLag = 1;
+	_fitnessCache = NULL;
+	_profiler = NULL;
+	_tracer = NULL;
+	_generation = 0;
+	_evaluations = 0;
+	_progressFunc = NULL;
+	_progressData = NULL;
+	_progressInterval = 1;
+	_improvementFunc = NULL;
+	_improvementData = NULL;
+	_sumFitness = _avgFitness = _varFitness = 0.0;
+	_fitnessShift = _shiftedSumFitness = _shiftedSumSqFitness = 0.0;
+	_maxFitness = _minFitness = 0.0;
+	_bestIndex = 0;
+	_statsValid = false;
+	_statsAge = 0;
+	_cacheHits = 0;
 	_chromosomes.reserve(2*initialSize);
 	_nextGen.reserve(initialSize);
 }
@@ -49,6 +170,7 @@ ga2Population::ga2Population( int initialSize, int chromoSize ) : _size(initialS
  */
 ga2Population::~ga2Population()
 {
+	flush();
 	if(!_chromosomes.empty())
 		_chromosomes.clear();
 	if(!_nextGen.empty())
@@ -69,6 +191,11 @@ ga2Population::~ga2Population()
  * fitness (only appropriate for certain types of selection. See
  * ga2Population::setSelectType()), ga2Population::setSort() should be called
  * first.
+ *
+ * If seeds have been added (see ga2Population::addSeed() and
+ * ga2Population::addSeeds()), the first chromosomes are made from them, in
+ * the order they were added, and only the rest are randomly initialised.
+ * Seed genes are clamped to the population's ranges. The seeds are used up.
  */
 bool ga2Population::init(void)
 {
@@ -77,15 +204,52 @@ bool ga2Population::init(void)
 	  ||(_chromoMinRanges.size() != _chromoSize) )
 		return false;
 
+	ga2ProfileScope scope(_profiler, GA2_PHASE_INIT, _tracer);
+	_operatorRandom.setSeed(rand()); //so srand() repeats a run
 	int i;
+	std::vector< ga2Chromosome > fresh;
+	fresh.reserve(_size);
 	for(i = 0; i < _size; ++i)
 	{
 		ga2Chromosome newChromo(_chromoSize);
 		newChromo.setMaxRanges(_chromoMaxRanges);
 		newChromo.setMinRanges(_chromoMinRanges);
-		newChromo.randomInit(_integer);
+		if(i < _seeds.size())
+		{
+			std::vector<ga2Gene> &genes = _seeds[i];
+			bool clamped = false;
+			int j;
+			for(j = 0; j < _chromoSize; ++j)
+			{
+				if(genes[j] < _chromoMinRanges[j])
+				{
+					genes[j] = _chromoMinRanges[j];
+					clamped = true;
+				}
+				else if(genes[j] > _chromoMaxRanges[j])
+				{
+					genes[j] = _chromoMaxRanges[j];
+					clamped = true;
+				}
+			}
+			newChromo.setGenes(genes);
+			if(_seedEvaluated[i] && !clamped)
+				newChromo.setFitness(_seedFitness[i]);
+		}
+		else if(_permutation)
+			newChromo.randomPermutation();
+		else
+			newChromo.randomInit(_integer);
 		newChromo.setEvalFunc(_evalFunc);
-		newChromo.evaluate();
+		fresh.push_back(newChromo);
+	}
+	clearSeeds();
+	//rand() is not thread safe, so only the evaluations go in parallel
+	_evaluateBatch(fresh);
+
+	for(i = 0; i < _size; ++i)
+	{
+		ga2Chromosome &newChromo = fresh[i];
 		if(!_isSorted)
 			_chromosomes.push_back(newChromo);
 		else //we have to do an insertion sort. large elements first, small last
@@ -104,22 +268,154 @@ bool ga2Population::init(void)
 			}
 		}
 	}
+	_statsValid = false;
+	_updateStats();
+	scope.end();
+	_parentLag = 1;
+	if(_genealogy)
+		_genealogy->record(*this);
+	_profileGeneration();
+	return true;
+}
+
+/**
+ * \param genes The genes of the chromosome, one per gene in the population's
+ * chromosomes.
+ *
+ * Queues a chromosome to be put into the population by the next call to
+ * ga2Population::init(), instead of a random one; it is evaluated there.
+ * Returns false, and adds nothing, if the number of genes is wrong.
+ */
+bool ga2Population::addSeed(const std::vector<ga2Gene> &genes)
+{
+	if(genes.size() != _chromoSize)
+		return false;
+	_seeds.push_back(genes);
+	_seedFitness.push_back(0.0);
+	_seedEvaluated.push_back(false);
 	return true;
 }
 
+/**
+ * \param genomes A list of chromosomes' genes, as for
+ * ga2Population::addSeed().
+ *
+ * Returns the number added; those with the wrong number of genes are
+ * skipped.
+ */
+int ga2Population::addSeeds(const std::vector< std::vector<ga2Gene> > &genomes)
+{
+	int i, added = 0;
+	for(i = 0; i < genomes.size(); ++i)
+		if(addSeed(genomes[i]))
+			++added;
+	return added;
+}
+
+//orders the n candidates best first (evaluated ones by fitness, then the
+//rest as they come) and queues the first count of them as seeds.
+void ga2Population::_addSeeds(const ga2Gene *const *genes, const double *fitness, const unsigned char *evaluated,
+							  int n, int count, bool keepFitness)
+{
+	std::vector<int> order(n);
+	int i;
+	for(i = 0; i < n; ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [fitness, evaluated](int a, int b) {
+		if(evaluated[a] != evaluated[b])
+			return evaluated[a] > evaluated[b];
+		return evaluated[a] && (fitness[a] > fitness[b]);
+	});
+	if( (count < 0) || (count > n) )
+		count = n;
+	for(i = 0; i < count; ++i)
+	{
+		int j = order[i];
+		_seeds.push_back(std::vector<ga2Gene>(genes[j], genes[j] + _chromoSize));
+		_seedFitness.push_back(fitness[j]);
+		_seedEvaluated.push_back(keepFitness && evaluated[j]);
+	}
+}
+
+/**
+ * \param path A checkpoint written by ga2Population::writeCheckpoint(),
+ * ga2DeltaCheckpoint or ga2MappedPopulation.
+ * \param count How many chromosomes to take, or -1 for all of them.
+ * \param keepFitness Keep the fitness values saved in the file rather than
+ * evaluating the chromosomes again. Only do this if the fitness function has
+ * not changed since the file was written.
+ *
+ * Queues the best count chromosomes in the file as seeds for
+ * ga2Population::init(). Returns the number added, or -1 if the file cannot
+ * be read or its chromosomes are not the size of this population's.
+ */
+int ga2Population::addSeeds(const char *path, int count, bool keepFitness)
+{
+	ga2Checkpoint ckpt;
+	if( !ckpt.open(path) || (ckpt.getChromoSize() != _chromoSize) )
+		return -1;
+	int i, n = ckpt.getSize(), before = _seeds.size();
+	std::vector<const ga2Gene *> genes(n);
+	for(i = 0; i < n; ++i)
+		genes[i] = ckpt.getGenes(i);
+	if(n)
+		_addSeeds(&genes[0], ckpt.getFitness(), ckpt.getEvaluated(), n, count, keepFitness);
+	return _seeds.size() - before;
+}
+
+/**
+ * \param prior Another population, typically the last generation of an
+ * earlier run.
+ * \param count How many chromosomes to take, or -1 for all of them.
+ * \param keepFitness Keep the fitness values of prior's chromosomes rather
+ * than evaluating them again.
+ *
+ * Queues the elite of prior (its best count chromosomes) as seeds for
+ * ga2Population::init(); chromosomes of prior that have not been evaluated
+ * come after those that have. Returns the number added, or -1 if prior's
+ * chromosomes are not the size of this population's.
+ */
+int ga2Population::addSeeds(ga2Population &prior, int count, bool keepFitness)
+{
+	if(prior._chromoSize != _chromoSize)
+		return -1;
+	prior.flush();
+	int i, n = prior._chromosomes.size(), before = _seeds.size();
+	std::vector< std::vector<ga2Gene> > copies(n);
+	std::vector<const ga2Gene *> genes(n);
+	std::vector<double> fitness(n);
+	std::vector<unsigned char> evaluated(n);
+	for(i = 0; i < n; ++i)
+	{
+		ga2Chromosome &c = prior._chromosomes[i];
+		copies[i] = c.getGenes();
+		genes[i] = copies[i].empty() ? NULL : &copies[i][0];
+		evaluated[i] = c.isEvaluated();
+		fitness[i] = evaluated[i] ? c.getFitness() : 0.0;
+	}
+	if(n)
+		_addSeeds(&genes[0], &fitness[0], &evaluated[0], n, count, keepFitness);
+	return _seeds.size() - before;
+}
+
 /**
  * The selection function. Call when you are ready to select parents for
  * the next generation.
  */
 bool ga2Population::select(void)
 {
+	ga2ProfileScope scope(_profiler, GA2_PHASE_SELECT, _tracer);
 	//select pairs of chromosomes and put them in nextGen
 	_nextGen.clear();
+	_niche();
 	int i, s1, s2;
+	bool crowding = _replacementType == GA2_REPLACE_CROWDING;
 	for(i = 0; i < _replacementSize; i+=2)
 	{
-		s1 = _selectFunc();
-		s2 = _selectFunc();
+		//crowding puts the pressure in replacement, so parents are drawn
+		//uniformly
+		s1 = crowding ? _operatorRandom.below(_chromosomes.size()) : _selectFunc();
+		s2 = crowding ? _operatorRandom.below(_chromosomes.size()) : _selectFunc();
 		
 		_chromosomes[s1].setParent(0, s1);
 		_chromosomes[s1].setParent(1, s1);
@@ -128,29 +424,30 @@ bool ga2Population::select(void)
 		_nextGen.push_back(_chromosomes[s1]);
 		_nextGen.push_back(_chromosomes[s2]);
 	}
+	for(i = 0; i < _nextGen.size(); ++i)
+	{
+		_nextGen[i]._operator = -1;
+		_nextGen[i]._parentFitness = _nextGen[i]._fitness;
+	}
 	return true;
 }
 
 /**
  * Calls the fitness function assigned to each chromosome, if necessary.
  * If a chromosome has already been evaluated, and has not changed since,
- * it is not evaluated again.
+ * it is not evaluated again. If a scheduler has been set with
+ * ga2Population::setScheduler(), the evaluations are spread over its workers.
+ *
+ * Then brings the statistics (ga2Population::getMaxFitness() and friends,
+ * and the diversity measures) up to date. They are kept as running sums,
+ * updated as chromosomes come and go, so this does not go over every gene
+ * of every chromosome again; for a sorted population it is constant time.
  */
 bool ga2Population::evaluate(void)
 {
-	int i;
-	float f;
-	_sumFitness = _avgFitness = 0.0;
-	_maxFitness = -1*(double)INT_MAX;
-	_minFitness = (double)INT_MAX;
-	for(i = 0; i < _size; ++i)
-	{
-		f = _chromosomes[i].getFitness();
-		_sumFitness += f;
-		if(f > _maxFitness) _maxFitness = f;
-		if(f < _minFitness) _minFitness = f;
-	}
-	_avgFitness = _sumFitness/(double)_size;
+	ga2ProfileScope scope(_profiler, GA2_PHASE_EVALUATE, _tracer);
+	_evaluateBatch(_chromosomes);
+	_updateStats();
 	return true;
 }
 
@@ -160,12 +457,15 @@ bool ga2Population::evaluate(void)
  */
 bool ga2Population::crossover(void)
 {
+	ga2ProfileScope scope(_profiler, GA2_PHASE_CROSSOVER, _tracer);
 	_crossCount = 0;
 	int i;
 	for(i = 0; i < _replacementSize; i+=2)
 	{
 		_crossoverFunc(_nextGen[i], _nextGen[i+1]);
 	}
+	if(_profiler)
+		_profiler->count(GA2_COUNTER_CROSSOVERS, _crossCount);
 	return true;
 }
 
@@ -174,23 +474,454 @@ bool ga2Population::crossover(void)
  */
 bool ga2Population::mutate(void)
 {
+	ga2ProfileScope scope(_profiler, GA2_PHASE_MUTATE, _tracer);
 	_mutationCount = 0;
 	int i;
 	for(i = 0; i < _replacementSize; ++i)
 	{
 		_mutateFunc(_nextGen[i]);
 	}
+	if(_profiler)
+		_profiler->count(GA2_COUNTER_MUTATIONS, _mutationCount);
 	return true;
 }
 
 /**
- * Replace the current generation with the next generation.
+ * Refines a fraction of the next generation, chosen at random, by
+ * coordinate search (see ga2Population::setLocalSearch()). Does nothing if
+ * local search is off; ga2Population::step() calls it after
+ * ga2Population::mutate().
+ *
+ * Each chosen chromosome moves one gene at a time by a step, up and then
+ * down, keeping any move that improves its fitness. Steps are measured in
+ * standard deviations of the population in that gene, so the search
+ * reaches as far as the population is spread, and no further: wide early
+ * on, and finer as the population converges. A gene that does not
+ * improve either way is passed over for the next; once every gene has
+ * failed in a row, the step is halved. This goes on until the chromosome
+ * has used up its budget of evaluations or its step has become too small
+ * to matter. Every chromosome being refined takes one step at a time, so
+ * each round of neighbours is evaluated together as one batch, through the
+ * scheduler and fitness cache like any other.
+ *
+ * The refined chromosomes come back evaluated, so ga2Population::replace()
+ * does not evaluate them again. Permutations are left alone, as moving
+ * single genes would break them. The evaluations are counted by
+ * ga2Population::getEvaluations().
+ */
+bool ga2Population::localSearch(void)
+{
+	if( (_localSearchMode == GA2_LOCALSEARCH_NONE) || (_localSearchBudget <= 0)
+	  ||(_localSearchFraction <= 0.0) || _nextGen.empty() || _permutation )
+		return true;
+	ga2ProfileScope scope(_profiler, GA2_PHASE_LOCALSEARCH, _tracer);
+	int i, c, L = _chromoSize;
+	std::vector<int> chosen;
+	for(i = 0; i < _nextGen.size(); ++i)
+		if(_operatorRandom.uniform() < _localSearchFraction)
+			chosen.push_back(i);
+	int k = chosen.size();
+	if(!k)
+		return true;
+
+	std::vector<double> spread(L);
+	for(i = 0; i < L; ++i)
+	{
+		double least = GA2_LOCALSEARCH_MINSPREAD * (_chromoMaxRanges[i] - _chromoMinRanges[i]);
+		spread[i] = sqrt(getGeneVariance(i));
+		spread[i] = spread[i] > least ? spread[i] : least;
+	}
+
+	//the starting points, evaluated together
+	std::vector< ga2Chromosome > current, trials;
+	std::vector<int> owner;
+	std::vector<ga2SearchState> state(k);
+	current.reserve(k);
+	trials.reserve(k);
+	owner.reserve(k);
+	for(c = 0; c < k; ++c)
+	{
+		current.push_back(_nextGen[chosen[c]]);
+		ga2SearchState &st = state[c];
+		st.coord = _operatorRandom.below(L);
+		st.dir = 1;
+		st.step = _localSearchStep;
+		st.used = 0;
+		st.stalled = 0;
+	}
+	_evaluateBatch(current);
+	std::vector<double> start(k);
+	for(c = 0; c < k; ++c)
+		start[c] = current[c]._fitness;
+
+	for(;;)
+	{
+		trials.clear();
+		owner.clear();
+		for(c = 0; c < k; ++c)
+		{
+			ga2SearchState &st = state[c];
+			if( (st.used >= _localSearchBudget) || (st.step < GA2_LOCALSEARCH_MINSTEP * _localSearchStep) )
+				continue;
+			int j = st.coord;
+			float lo = _chromoMinRanges[j], hi = _chromoMaxRanges[j];
+			double delta = st.step * spread[j];
+			if(_integer)
+				delta = delta < 1.0 ? 1.0 : floor(delta + 0.5);
+			double g = current[c]._genes[j] + st.dir * delta;
+			g = g < lo ? lo : (g > hi ? hi : g);
+			++st.used;
+			if((ga2Gene)g == current[c]._genes[j])
+			{
+				//against the bound; counts as a failed move
+				owner.push_back(-1 - c);
+				continue;
+			}
+			trials.push_back(current[c]);
+			ga2Chromosome &t = trials.back();
+			t._genes[j] = g;
+			t._isEvaluated = false;
+			t._id = ga2Chromosome::_newId();
+			owner.push_back(c);
+		}
+		if(owner.empty())
+			break;
+		_evaluateBatch(trials);
+
+		int next = 0;
+		for(i = 0; i < owner.size(); ++i)
+		{
+			bool better = false;
+			c = owner[i];
+			if(c >= 0)
+			{
+				ga2Chromosome &t = trials[next++];
+				if(t._fitness > current[c]._fitness)
+				{
+					current[c] = t;
+					better = true;
+				}
+			}
+			else
+				c = -1 - c;
+			ga2SearchState &st = state[c];
+			if(better) //keep going the same way
+			{
+				st.stalled = 0;
+				continue;
+			}
+			if(st.dir > 0)
+				st.dir = -1;
+			else
+			{
+				st.dir = 1;
+				st.coord = (st.coord + 1) % L;
+			}
+			if(++st.stalled >= 2 * L)
+			{
+				st.step *= 0.5;
+				st.stalled = 0;
+			}
+		}
+	}
+
+	for(c = 0; c < k; ++c)
+	{
+		ga2Chromosome &o = _nextGen[chosen[c]], &best = current[c];
+		bool improved = best._fitness > start[c];
+		if(_localSearchMode == GA2_LOCALSEARCH_LAMARCKIAN)
+		{
+			o._genes = best._genes;
+			o._id = best._id;
+		}
+		else if(improved)
+			o._id = ga2Chromosome::_newId(); //same genes, different fitness
+		else
+			o._id = best._id;
+		o._fitness = best._fitness;
+		o._isEvaluated = true;
+	}
+	return true;
+}
+
+/**
+ * Replace the current generation with the next generation. The offspring
+ * are evaluated first, as one batch, since most replacement schemes need
+ * their fitness.
  */
 bool ga2Population::replace(void)
 {
+	ga2ProfileScope evaluating(_profiler, GA2_PHASE_EVALUATE, _tracer);
+	_evaluateBatch(_nextGen);
+	evaluating.end();
+	ga2ProfileScope scope(_profiler, GA2_PHASE_REPLACE, _tracer);
+	_adapt(_nextGen);
 	return _replaceFunc();
 }
 
+/**
+ * Runs one complete generation: select, crossover, mutate, local search
+ * (if set; see ga2Population::setLocalSearch()), replace and evaluate.
+ *
+ * In pipelined mode (see ga2Population::setPipelined()) the offspring are
+ * not evaluated before step() returns. Instead they are handed to the
+ * scheduler, and the next call breeds its offspring from the population as
+ * it stands, then waits for the previous batch and replaces with it. The
+ * workers move straight from the tail of one batch onto the next, so no
+ * generation ever waits on its slowest evaluation; the price is that
+ * parents are chosen from a population one generation behind. The
+ * statistics reported by ga2Population::getMaxFitness() and friends lag in
+ * the same way. Call ga2Population::flush() to bring everything up to date.
+ */
+bool ga2Population::step(void)
+{
+	return _step(true);
+}
+
+//one generation. Every member is evaluated once replaced, so the sweep by
+//evaluate() afterwards only finds work if the caller has changed something
+//between steps; run() owns the loop, so it skips it and just brings the
+//statistics up to date.
+bool ga2Population::_step(bool sweep)
+{
+	ga2TraceScope traced(_tracer, "generation", "ga2", "generation", ++_generation);
+	if(!_pipelined || !_scheduler || (_replacementType == GA2_REPLACE_CROWDING))
+	{
+		select();
+		crossover();
+		mutate();
+		localSearch();
+		if(!replace())
+			return false;
+		if(sweep)
+			evaluate();
+		else
+			_updateStats();
+		_parentLag = 1;
+		if(_genealogy)
+			_genealogy->record(*this);
+		_profileGeneration();
+		return true;
+	}
+
+	select();
+	crossover();
+	mutate();
+	localSearch();
+	int i;
+	long fresh = 0;
+	for(i = 0; i < _nextGen.size(); ++i)
+		if(!_nextGen[i].isEvaluated())
+			++fresh;
+	_evaluations += fresh;
+	if(_profiler)
+		_profiler->count(GA2_COUNTER_EVALUATIONS, fresh);
+	ga2EvaluateTask *task = new ga2EvaluateTask(_nextGen, _fitnessCache);
+	ga2Job *job = _scheduler->submit(*task, _nextGen.size());
+
+	//park the fresh offspring and pull in the batch submitted last time.
+	//swapping leaves the elements where the new task can see them.
+	_inFlight.swap(_nextGen);
+	bool replaced = true;
+	_parentLag = _inFlightJob ? 2 : 1; //bred last step, from the one before
+	if(_inFlightJob)
+	{
+		ga2ProfileScope waiting(_profiler, GA2_PHASE_EVALUATE, _tracer);
+		_scheduler->wait(_inFlightJob);
+		delete _inFlightTask;
+		waiting.end();
+		ga2ProfileScope scope(_profiler, GA2_PHASE_REPLACE, _tracer);
+		_adapt(_nextGen);
+		replaced = _replaceFunc();
+		scope.end();
+		if(sweep)
+			evaluate();
+		else
+			_updateStats();
+	}
+	_inFlightTask = task;
+	_inFlightJob = job;
+	if(_genealogy)
+		_genealogy->record(*this);
+	_profileGeneration();
+	return replaced;
+}
+
+/**
+ * \param stop When to stop; see ga2StopCriteria.
+ *
+ * Steps generations, initialising the population first if that has not
+ * been done, until one of the stopping criteria is met, the progress
+ * function (see ga2Population::setProgressFunc()) asks to stop, or a step
+ * fails. Returns which of these it was: one of GA2_STOP_GENERATIONS,
+ * GA2_STOP_EVALUATIONS, GA2_STOP_TIME, GA2_STOP_TARGET,
+ * GA2_STOP_STAGNATION, GA2_STOP_CALLBACK or GA2_STOP_FAILED. Generations,
+ * evaluations and time are counted from the start of this call, and are
+ * checked between generations, so a run can overshoot an evaluation budget
+ * by up to one generation's offspring.
+ *
+ * Does the same work as calling ga2Population::step() in a loop, minus
+ * the pass over the whole population that step() makes to evaluate
+ * anything changed behind its back. A pipelined run is flushed before
+ * returning, so the population and its statistics are current.
+ */
+int ga2Population::run(const ga2StopCriteria &stop)
+{
+	if(_chromosomes.empty() && !init())
+		return GA2_STOP_FAILED;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	long generations = 0, lastImprovement = 0;
+	long evaluations = _evaluations;
+	double best = _maxFitness;
+	int reason = GA2_STOP_NONE;
+	while(reason == GA2_STOP_NONE)
+	{
+		if( stop.useTargetFitness && (_maxFitness >= stop.targetFitness) )
+			reason = GA2_STOP_TARGET;
+		else if( (stop.maxGenerations > 0) && (generations >= stop.maxGenerations) )
+			reason = GA2_STOP_GENERATIONS;
+		else if( (stop.maxEvaluations > 0) && (_evaluations - evaluations >= stop.maxEvaluations) )
+			reason = GA2_STOP_EVALUATIONS;
+		else if( (stop.maxSeconds > 0.0) &&
+				 (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= stop.maxSeconds) )
+			reason = GA2_STOP_TIME;
+		else if( (stop.stagnationGenerations > 0) && (generations - lastImprovement >= stop.stagnationGenerations) )
+			reason = GA2_STOP_STAGNATION;
+		if(reason != GA2_STOP_NONE)
+			break;
+
+		if(!_step(false))
+		{
+			reason = GA2_STOP_FAILED;
+			break;
+		}
+		++generations;
+		if(_maxFitness > best + stop.stagnationTolerance)
+		{
+			best = _maxFitness;
+			lastImprovement = generations;
+			if(_improvementFunc)
+				_improvementFunc(*this, _improvementData);
+		}
+		if( _progressFunc && !(generations % _progressInterval) && !_progressFunc(*this, _progressData) )
+			reason = GA2_STOP_CALLBACK;
+	}
+	flush();
+	return reason;
+}
+
+/**
+ * Waits for any offspring still being evaluated by a pipelined
+ * ga2Population::step() and replaces with them, so the population and its
+ * statistics are current. Call before serialising the population or
+ * reading the final result. Harmless when nothing is in flight.
+ */
+bool ga2Population::flush(void)
+{
+	if(!_inFlightJob)
+		return true;
+	ga2ProfileScope waiting(_profiler, GA2_PHASE_EVALUATE, _tracer);
+	_scheduler->wait(_inFlightJob);
+	delete _inFlightTask;
+	waiting.end();
+	_inFlightTask = NULL;
+	_inFlightJob = NULL;
+	_nextGen.swap(_inFlight);
+	_inFlight.clear();
+	ga2ProfileScope scope(_profiler, GA2_PHASE_REPLACE, _tracer);
+	_adapt(_nextGen);
+	bool replaced = _replaceFunc();
+	scope.end();
+	evaluate();
+	_parentLag = 2; //the step that bred this batch recorded the one before
+	if(_genealogy)
+		_genealogy->record(*this);
+	return replaced;
+}
+
+/**
+ * \param val true to overlap offspring evaluation with breeding.
+ *
+ * Pipelining only has an effect when a scheduler has been set with
+ * ga2Population::setScheduler() and generations are run through
+ * ga2Population::step(), and is skipped while the replacement is
+ * GA2_REPLACE_CROWDING. Turning it off flushes the pipeline.
+ */
+void ga2Population::setPipelined(bool val)
+{
+	if(!val)
+		flush();
+	_pipelined = val;
+}
+
+/**
+ * \param cache an open ga2FitnessCache, or NULL for none (the default).
+ *
+ * Every chromosome the population evaluates from then on is looked up
+ * in the cache first, and added to it if it is not there. The cache
+ * may be shared with other populations and other processes working on
+ * the same problem. The population does not take ownership, but none of
+ * its members refers to the old cache once this returns, so that may
+ * then be closed.
+ */
+void ga2Population::setFitnessCache(ga2FitnessCache *cache)
+{
+	flush();
+	int i;
+	for(i = 0; i < _chromosomes.size(); ++i)
+		_chromosomes[i].setFitnessCache(cache);
+	_fitnessCache = cache;
+	_cacheHits = cache ? cache->getHitCount() : 0;
+}
+
+/**
+ * \param profiler a ga2Profiler, or NULL to stop profiling (the default).
+ *
+ * Once set, every phase (ga2Population::init(), ga2Population::select()
+ * and so on) is timed, evaluations, cache hits, crossovers and mutations
+ * are counted, and ga2Population::init() and each ga2Population::step()
+ * close a generation in it. The population does not take ownership.
+ */
+void ga2Population::setProfiler(ga2Profiler *profiler)
+{
+	_profiler = profiler;
+	_cacheHits = _fitnessCache ? _fitnessCache->getHitCount() : 0;
+}
+
+//closes a generation in the profiler. Cache hits are taken from the cache's
+//own count, so they include those of anyone sharing it at the same time.
+void ga2Population::_profileGeneration(void)
+{
+	if(!_profiler)
+		return;
+	if(_fitnessCache)
+	{
+		long hits = _fitnessCache->getHitCount();
+		_profiler->count(GA2_COUNTER_CACHEHITS, hits - _cacheHits);
+		_cacheHits = hits;
+	}
+	_profiler->endGeneration();
+}
+
+//evaluates every chromosome in chromos that needs it, on the scheduler if
+//there is one.
+void ga2Population::_evaluateBatch(std::vector< ga2Chromosome > &chromos)
+{
+	int i;
+	long fresh = 0;
+	for(i = 0; i < chromos.size(); ++i)
+		if(!chromos[i].isEvaluated())
+			++fresh;
+	_evaluations += fresh;
+	if(_profiler)
+		_profiler->count(GA2_COUNTER_EVALUATIONS, fresh);
+	ga2EvaluateTask task(chromos, _fitnessCache);
+	if(_scheduler)
+		_scheduler->parallelFor(task, chromos.size());
+	else
+		task.run(0, chromos.size());
+}
+
 int ga2Population::_selectRoulette(void)
 {
 	float partialSum= 0.0, sumFitness = 0.0;
@@ -200,7 +931,7 @@ int ga2Population::_selectRoulette(void)
 	//initialize some stuff, like the total fitness of the population
 	for(i = 0; i < _size; ++i)
 	{
-		sumFitness += _chromosomes[i].getFitness();
+		sumFitness += _nicheFitness.empty() ? _chromosomes[i].getFitness() : _nicheFitness[i];
 	}
 
 	//spin that wheel!
@@ -210,10 +941,10 @@ int ga2Population::_selectRoulette(void)
 	do
 	{
 		++i;
-		partialSum += _chromosomes[i].getFitness();
+		partialSum += _nicheFitness.empty() ? _chromosomes[i].getFitness() : _nicheFitness[i];
 	}while( (partialSum < wheelPosition) && (i != _size-1) );
 
-	return _size-i;
+	return i;
 }
 
 int ga2Population::_selectRanked(void)
@@ -239,97 +970,298 @@ int ga2Population::_selectRanked(void)
 		++i;
 		partialSum += i;
 	}
-	return i;
+	//ranks go by niche fitness while niching
+	return _nicheOrder.empty() ? i : _nicheOrder[i];
 }
 
-bool ga2Population::_crossoverOnePoint(ga2Chromosome &a, ga2Chromosome &b)
+//The real-coded operators below work on a whole chromosome's genes at a
+//time, as plain loops over arrays with no branches and no calls into the
+//random number generator, so the compiler can vectorise them. The random
+//draws they need are made beforehand, into _draws.
+
+//simulated binary crossover, in place. u gives the spread of each gene's
+//children; w decides whether the gene crosses (w < 0.5) and, if it does,
+//which child gets which value (w < 0.25 swaps them).
+static void ga2KernelSBX(ga2Gene *a, ga2Gene *b, const float *lo, const float *hi,
+						 const double *u, const double *w, int n, double eta)
 {
-	float coPoint = ((float)rand()/(float)RAND_MAX) * _chromoSize;
-	ga2Chromosome *a1, *a2, *b1, *b2;
-	a1 = a.grabSlice(0, coPoint);
-	a2 = a.grabSlice(coPoint, _chromoSize);
-	b1 = b.grabSlice(0, coPoint);
-	b2 = b.grabSlice(coPoint, _chromoSize);
+	double e = 1.0 / (eta + 1.0);
+	int j;
+	for(j = 0; j < n; ++j)
+	{
+		double y1 = a[j] < b[j] ? a[j] : b[j];
+		double y2 = a[j] < b[j] ? b[j] : a[j];
+		double d = y2 - y1;
+		double dd = d > 1e-14 ? d : 1e-14;
+		double beta = 1.0 + 2.0 * (y1 - lo[j]) / dd;
+		double alpha = 2.0 - pow(beta, -(eta + 1.0));
+		double ua = u[j] * alpha;
+		double bq = ua <= 1.0 ? pow(ua, e) : pow(1.0 / (2.0 - ua), e);
+		double c1 = 0.5 * (y1 + y2 - bq * d);
+		beta = 1.0 + 2.0 * (hi[j] - y2) / dd;
+		alpha = 2.0 - pow(beta, -(eta + 1.0));
+		ua = u[j] * alpha;
+		bq = ua <= 1.0 ? pow(ua, e) : pow(1.0 / (2.0 - ua), e);
+		double c2 = 0.5 * (y1 + y2 + bq * d);
+		c1 = c1 < lo[j] ? lo[j] : (c1 > hi[j] ? hi[j] : c1);
+		c2 = c2 < lo[j] ? lo[j] : (c2 > hi[j] ? hi[j] : c2);
+		bool cross = (w[j] < 0.5) && (d > 1e-14);
+		bool swap = w[j] < 0.25;
+		ga2Gene na = cross ? (ga2Gene)(swap ? c2 : c1) : a[j];
+		ga2Gene nb = cross ? (ga2Gene)(swap ? c1 : c2) : b[j];
+		a[j] = na;
+		b[j] = nb;
+	}
+}
 
-	ga2Chromosome aNew(_chromoSize), bNew(_chromoSize);
-	
-	aNew = *b2 + *a1;
-	bNew = *a2 + *b1;
-	int tempParent1, tempParent2;
-	tempParent1 = a.getParent(0);
-	tempParent2 = b.getParent(0);
-
-	delete(&a);
-	delete(&b);
-	
-	a = aNew;
-	b = bNew;
-	
-	a.setCrossSite(coPoint);
+//BLX-alpha crossover, in place: each child gene is uniform over the
+//parents' interval widened by alpha of its length at each end.
+static void ga2KernelBLX(ga2Gene *a, ga2Gene *b, const float *lo, const float *hi,
+						 const double *u, const double *w, int n, double alpha)
+{
+	int j;
+	for(j = 0; j < n; ++j)
+	{
+		double y1 = a[j] < b[j] ? a[j] : b[j];
+		double y2 = a[j] < b[j] ? b[j] : a[j];
+		double reach = alpha * (y2 - y1);
+		double from = y1 - reach, width = (y2 - y1) + 2.0 * reach;
+		double c1 = from + u[j] * width;
+		double c2 = from + w[j] * width;
+		a[j] = c1 < lo[j] ? lo[j] : (c1 > hi[j] ? hi[j] : (ga2Gene)c1);
+		b[j] = c2 < lo[j] ? lo[j] : (c2 > hi[j] ? hi[j] : (ga2Gene)c2);
+	}
+}
+
+//Gaussian mutation, in place: genes whose m is below the rate get g
+//standard deviations of sigma times their range added.
+static void ga2KernelGaussian(ga2Gene *a, const float *lo, const float *hi,
+							  const double *m, const double *g, int n,
+							  double rate, double sigma)
+{
+	int j;
+	for(j = 0; j < n; ++j)
+	{
+		double step = m[j] < rate ? sigma * (hi[j] - lo[j]) * g[j] : 0.0;
+		double x = a[j] + step;
+		a[j] = x < lo[j] ? lo[j] : (x > hi[j] ? hi[j] : (ga2Gene)x);
+	}
+}
+
+//polynomial mutation, in place: genes whose m is below the rate move by
+//a step drawn, through u, from Deb's bounded polynomial distribution.
+static void ga2KernelPolynomial(ga2Gene *a, const float *lo, const float *hi,
+								const double *m, const double *u, int n,
+								double rate, double eta)
+{
+	double e = 1.0 / (eta + 1.0);
+	int j;
+	for(j = 0; j < n; ++j)
+	{
+		double range = hi[j] - lo[j];
+		double r = range > 0.0 ? range : 1.0;
+		double d1 = (a[j] - lo[j]) / r, d2 = (hi[j] - a[j]) / r;
+		bool low = u[j] < 0.5;
+		double base = low ? 2.0 * u[j] + (1.0 - 2.0 * u[j]) * pow(1.0 - d1, eta + 1.0)
+						  : 2.0 * (1.0 - u[j]) + 2.0 * (u[j] - 0.5) * pow(1.0 - d2, eta + 1.0);
+		double dq = low ? pow(base, e) - 1.0 : 1.0 - pow(base, e);
+		double x = a[j] + (m[j] < rate ? dq * range : 0.0);
+		a[j] = x < lo[j] ? lo[j] : (x > hi[j] ? hi[j] : (ga2Gene)x);
+	}
+}
+
+//The permutation operators are linear in the length: genes are used as
+//indices into position tables, rather than being searched for.
+
+//order crossover (OX) for one child: takes p's genes in [lo, hi] as they
+//are, and the rest in the order they come in q, starting after hi. used
+//must come in as n zeroes, and is left that way.
+static void ga2KernelOrder(const ga2Gene *p, const ga2Gene *q, ga2Gene *child, int *used,
+						   int n, int lo, int hi)
+{
+	int k, out = (hi + 1) % n;
+	for(k = lo; k <= hi; ++k)
+	{
+		child[k] = p[k];
+		used[(int)p[k]] = 1;
+	}
+	for(k = 0; k < n; ++k)
+	{
+		ga2Gene g = q[(hi + 1 + k) % n];
+		if(used[(int)g])
+			continue;
+		child[out] = g;
+		out = (out + 1) % n;
+	}
+	for(k = lo; k <= hi; ++k)
+		used[(int)p[k]] = 0;
+}
+
+//partially mapped crossover (PMX) for one child: starts from q and swaps
+//p's genes in [lo, hi] into place, which follows the mapping between the
+//two segments without searching for anything.
+static void ga2KernelPMX(const ga2Gene *p, const ga2Gene *q, ga2Gene *child, int *pos,
+						 int n, int lo, int hi)
+{
+	int k;
+	for(k = 0; k < n; ++k)
+	{
+		child[k] = q[k];
+		pos[(int)q[k]] = k;
+	}
+	for(k = lo; k <= hi; ++k)
+	{
+		int v = p[k], at = pos[v];
+		ga2Gene displaced = child[k];
+		child[at] = displaced;
+		pos[(int)displaced] = at;
+		child[k] = v;
+		pos[v] = k;
+	}
+}
+
+//cycle crossover, in place: finds the cycles of positions that a and b
+//fill with the same genes, and swaps every other cycle between them.
+static void ga2KernelCycle(ga2Gene *a, ga2Gene *b, int *pos, int *cycle, int n)
+{
+	int k, c = 0;
+	for(k = 0; k < n; ++k)
+	{
+		pos[(int)a[k]] = k;
+		cycle[k] = -1;
+	}
+	for(k = 0; k < n; ++k)
+	{
+		if(cycle[k] >= 0)
+			continue;
+		int at = k;
+		do
+		{
+			cycle[at] = c;
+			at = pos[(int)b[at]];
+		}while(at != k);
+		++c;
+	}
+	for(k = 0; k < n; ++k)
+		if(cycle[k] & 1)
+			std::swap(a[k], b[k]);
+}
+
+//marks a pair of parents as new children of each other
+void ga2Population::_offspring(ga2Chromosome &a, ga2Chromosome &b, int crossSite)
+{
+	if(_integer)
+	{
+		int j;
+		for(j = 0; j < _chromoSize; ++j)
+		{
+			a._genes[j] = floorf(a._genes[j] + 0.5f);
+			b._genes[j] = floorf(b._genes[j] + 0.5f);
+		}
+	}
+	int tempParent1 = a.getParent(0), tempParent2 = b.getParent(0);
+	a._isEvaluated = b._isEvaluated = false;
+	a._id = ga2Chromosome::_newId();
+	b._id = ga2Chromosome::_newId();
+	a.setCrossSite(crossSite);
 	a.setParent(0, tempParent1);
 	a.setParent(1, tempParent2);
-	b.setCrossSite(coPoint);
+	b.setCrossSite(crossSite);
 	b.setParent(0, tempParent1);
 	b.setParent(1, tempParent2);
+}
 
+bool ga2Population::_crossoverOnePoint(ga2Chromosome &a, ga2Chromosome &b)
+{
+	int coPoint = ((float)rand()/(float)RAND_MAX) * _chromoSize;
+	int i;
+	for(i = coPoint; i < _chromoSize; ++i)
+		std::swap(a._genes[i], b._genes[i]);
+	_offspring(a, b, coPoint);
 	return true;
 }
 
 bool ga2Population::_crossoverUniform(ga2Chromosome &a, ga2Chromosome &b)
 {
-	ga2Chromosome *c, *d;
 	int flip;
 	int i;
-	
-	//where does the first gene come from? after that, we loop.
-	flip = ((float)rand()/(float)RAND_MAX) * 2;
-	if(flip)
-	{
-		c = a.grabSlice(0, 1);
-		d = b.grabSlice(0, 1);
-	}
-	else
-	{
-		c = b.grabSlice(0, 1);
-		d = a.grabSlice(0, 1);
-	}
-	//now, loop and deal with the rest.
-	for(i = 1; i < _chromoSize; ++i)
+	for(i = 0; i < _chromoSize; ++i)
 	{
 		flip = ((float)rand()/(float)RAND_MAX) * 2;
-		if(flip)
-		{
-			*c = *c + *(a.grabSlice(i, i+1));
-			*d = *d + *(b.grabSlice(i, i+1));
-		}
-		else
-		{
-			*c = *c + *(b.grabSlice(i, i+1));
-			*d = *d + *(a.grabSlice(i, i+1));
-		}
+		if(!flip)
+			std::swap(a._genes[i], b._genes[i]);
 	}
+	_offspring(a, b, 0); //er, no real cross site to speak of in uniform...
+	return true;
+}
+
+bool ga2Population::_crossoverSBX(ga2Chromosome &a, ga2Chromosome &b)
+{
+	int j, n = _chromoSize;
+	_draws.resize(2 * n);
+	double *u = &_draws[0], *w = u + n;
+	for(j = 0; j < 2 * n; ++j)
+		u[j] = _operatorRandom.uniform();
+	ga2KernelSBX(&a._genes[0], &b._genes[0], &_chromoMinRanges[0], &_chromoMaxRanges[0],
+				 u, w, n, _sbxEta);
+	_offspring(a, b, 0);
+	return true;
+}
 
-	//ok ,here is where things get weird. cause we gotta grab a and b's
-	//parents (as set by the selection function) and put them first into c and d
-	//before we can reassign a and b to be c and d.
-	int tempParent1, tempParent2;
-	tempParent1 = a.getParent(0);
-	tempParent2 = b.getParent(0);
+bool ga2Population::_crossoverOrder(ga2Chromosome &a, ga2Chromosome &b)
+{
+	int n = _chromoSize;
+	int lo = _operatorRandom.below(n), hi = _operatorRandom.below(n);
+	if(lo > hi)
+		std::swap(lo, hi);
+	_permScratch.resize(2 * n);
+	_permChildren.resize(2 * n);
+	std::fill(_permScratch.begin(), _permScratch.begin() + n, 0); //PMX and cycle leave it dirty
+	ga2Gene *x = &a._genes[0], *y = &b._genes[0], *c = &_permChildren[0];
+	ga2KernelOrder(x, y, c, &_permScratch[0], n, lo, hi);
+	ga2KernelOrder(y, x, c + n, &_permScratch[0], n, lo, hi);
+	std::copy(c, c + n, x);
+	std::copy(c + n, c + 2 * n, y);
+	_offspring(a, b, lo);
+	return true;
+}
 
-	//the old a and b need to be dealt with somehow...geez, this is icky.
-	//delete(&a);
-	//delete(&b);
-	
-	a = *c;
-	b = *d;
+bool ga2Population::_crossoverPMX(ga2Chromosome &a, ga2Chromosome &b)
+{
+	int n = _chromoSize;
+	int lo = _operatorRandom.below(n), hi = _operatorRandom.below(n);
+	if(lo > hi)
+		std::swap(lo, hi);
+	_permScratch.resize(2 * n);
+	_permChildren.resize(2 * n);
+	ga2Gene *x = &a._genes[0], *y = &b._genes[0], *c = &_permChildren[0];
+	ga2KernelPMX(x, y, c, &_permScratch[0], n, lo, hi);
+	ga2KernelPMX(y, x, c + n, &_permScratch[0], n, lo, hi);
+	std::copy(c, c + n, x);
+	std::copy(c + n, c + 2 * n, y);
+	_offspring(a, b, lo);
+	return true;
+}
 
-	a.setCrossSite(0); //er, no real cross site to speak of in uniform...
-	a.setParent(0, tempParent1);
-	a.setParent(1, tempParent2);
-	b.setCrossSite(0);
-	b.setParent(0, tempParent1);
-	b.setParent(1, tempParent2);
+bool ga2Population::_crossoverCycle(ga2Chromosome &a, ga2Chromosome &b)
+{
+	int n = _chromoSize;
+	_permScratch.resize(2 * n);
+	ga2KernelCycle(&a._genes[0], &b._genes[0], &_permScratch[0], &_permScratch[n], n);
+	_offspring(a, b, 0);
+	return true;
+}
 
+bool ga2Population::_crossoverBLX(ga2Chromosome &a, ga2Chromosome &b)
+{
+	int j, n = _chromoSize;
+	_draws.resize(2 * n);
+	double *u = &_draws[0], *w = u + n;
+	for(j = 0; j < 2 * n; ++j)
+		u[j] = _operatorRandom.uniform();
+	ga2KernelBLX(&a._genes[0], &b._genes[0], &_chromoMinRanges[0], &_chromoMaxRanges[0],
+				 u, w, n, _blxAlpha);
+	_offspring(a, b, 0);
 	return true;
 }
 
@@ -353,6 +1285,9 @@ bool ga2Population::_replaceFunc(void)
 		case GA2_REPLACE_STEADYSTATENODUPLICATES:
 			return _replaceSteadyStateNoDuplicates();
 			break;
+		case GA2_REPLACE_CROWDING:
+			return _replaceCrowding();
+			break;
 		case GA2_REPLACE_STEADYSTATE:
 			return _replaceSteadyState();
 			break;
@@ -375,11 +1310,29 @@ bool ga2Population::_crossoverFunc(ga2Chromosome &a, ga2Chromosome &b)
 
 	++_crossCount;
 
-	switch(_crossoverType)
+	int type = _crossoverType == GA2_CROSSOVER_ADAPTIVE ? _pickCrossover() : _crossoverType;
+	a._operator = b._operator = type;
+	a._parentFitness = b._parentFitness = a._fitness > b._fitness ? a._fitness : b._fitness;
+	switch(type)
 	{
 		case GA2_CROSSOVER_UNIFORM:
 			return _crossoverUniform(a, b);
 			break;
+		case GA2_CROSSOVER_SBX:
+			return _crossoverSBX(a, b);
+			break;
+		case GA2_CROSSOVER_BLX:
+			return _crossoverBLX(a, b);
+			break;
+		case GA2_CROSSOVER_ORDER:
+			return _crossoverOrder(a, b);
+			break;
+		case GA2_CROSSOVER_PMX:
+			return _crossoverPMX(a, b);
+			break;
+		case GA2_CROSSOVER_CYCLE:
+			return _crossoverCycle(a, b);
+			break;
 		case GA2_CROSSOVER_ONEPOINT:
 		default:
 			return _crossoverOnePoint(a, b);
@@ -387,6 +1340,144 @@ bool ga2Population::_crossoverFunc(ga2Chromosome &a, ga2Chromosome &b)
 }
 
 bool ga2Population::_mutateFunc(ga2Chromosome &a)
+{
+	int before = _mutationCount;
+	bool retval;
+	switch(_mutationType)
+	{
+		case GA2_MUTATE_GAUSSIAN:
+			retval = _mutateGaussian(a);
+			break;
+		case GA2_MUTATE_POLYNOMIAL:
+			retval = _mutatePolynomial(a);
+			break;
+		case GA2_MUTATE_SWAP:
+		case GA2_MUTATE_INSERT:
+		case GA2_MUTATE_INVERSION:
+			retval = _mutatePermutation(a);
+			break;
+		case GA2_MUTATE_RESET:
+		default:
+			retval = _mutateReset(a);
+	}
+	if( (_mutationCount != before) && (a._operator < 0) )
+		a._operator = 0;
+	return retval;
+}
+
+//a crossover type for GA2_CROSSOVER_ADAPTIVE, by roulette on the
+//probabilities
+int ga2Population::_pickCrossover(void)
+{
+	double u = _operatorRandom.uniform();
+	int t;
+	for(t = 1; t < GA2_CROSSOVER_ADAPTIVE - 1; ++t)
+	{
+		u -= _operatorProbability[t];
+		if(u < 0.0)
+			break;
+	}
+	return t;
+}
+
+//credits the operators with the offspring's gains over their parents,
+//once they have been evaluated, and adapts the crossover probabilities and
+//the mutation strength to match. Offspring that are plain copies of their
+//parents are left out.
+void ga2Population::_adapt(const std::vector< ga2Chromosome > &offspring)
+{
+	bool adaptive = _crossoverType == GA2_CROSSOVER_ADAPTIVE;
+	if(!adaptive && !_adaptiveMutation)
+		return;
+	double gain[GA2_CROSSOVER_ADAPTIVE];
+	int uses[GA2_CROSSOVER_ADAPTIVE];
+	int i, t, tried = 0, improved = 0;
+	for(t = 0; t < GA2_CROSSOVER_ADAPTIVE; ++t)
+	{
+		gain[t] = 0.0;
+		uses[t] = 0;
+	}
+	for(i = 0; i < offspring.size(); ++i)
+	{
+		const ga2Chromosome &c = offspring[i];
+		if(c._operator < 0)
+			continue;
+		double d = c._fitness - c._parentFitness;
+		//the permutation operators lie past GA2_CROSSOVER_ADAPTIVE and only
+		//count towards the success rate
+		bool matched = c._operator < GA2_CROSSOVER_ADAPTIVE;
+		++tried;
+		if(matched)
+			++uses[c._operator];
+		if(d > 0.0)
+		{
+			++improved;
+			if(matched)
+				gain[c._operator] += d;
+		}
+	}
+	if(!tried)
+		return;
+	_successRate = (double)improved / tried;
+
+	if(adaptive)
+	{
+		//probability matching: each type's chance follows its share of the
+		//average gain per use, above a floor
+		double total = 0.0;
+		for(t = 1; t < GA2_CROSSOVER_ADAPTIVE; ++t)
+		{
+			if(uses[t])
+				_operatorQuality[t] += GA2_ADAPT_RATE * (gain[t] / uses[t] - _operatorQuality[t]);
+			total += _operatorQuality[t];
+		}
+		int types = GA2_CROSSOVER_ADAPTIVE - 1;
+		for(t = 1; t < GA2_CROSSOVER_ADAPTIVE; ++t)
+			_operatorProbability[t] = total > 0.0
+				? GA2_ADAPT_MINPROBABILITY
+				  + (1.0 - types * GA2_ADAPT_MINPROBABILITY) * _operatorQuality[t] / total
+				: 1.0 / types;
+	}
+
+	if(_adaptiveMutation && (_successRate != 0.2))
+	{
+		double factor = _successRate > 0.2 ? GA2_ADAPT_STEP : 1.0 / GA2_ADAPT_STEP;
+		if(_mutationType == GA2_MUTATE_GAUSSIAN)
+		{
+			_mutationSigma *= factor;
+			_mutationSigma = _mutationSigma < 1e-6 ? 1e-6 : (_mutationSigma > 0.5 ? 0.5 : _mutationSigma);
+		}
+		else
+		{
+			//between a gene in a few offspring and half the genes
+			double least = 0.25 / _chromoSize;
+			_mutationRate *= factor;
+			_mutationRate = _mutationRate < least ? least : (_mutationRate > 0.5 ? 0.5 : _mutationRate);
+		}
+	}
+}
+
+/**
+ * \param type One of GA2_CROSSOVER_ONEPOINT, GA2_CROSSOVER_UNIFORM,
+ * GA2_CROSSOVER_SBX or GA2_CROSSOVER_BLX.
+ *
+ * With GA2_CROSSOVER_ADAPTIVE set, each pair crossed over uses one of the
+ * four types, chosen at random with these probabilities. Each type's
+ * children are scored by how far they improve on the fitter parent,
+ * averaged over the type's uses in a generation and smoothed over recent
+ * generations, and the probabilities follow the scores. No type drops
+ * below a small floor, so a type that is poor early but good later is
+ * still noticed. Until the first offspring are evaluated, all four are
+ * equally likely. Returns 0 for any other type.
+ */
+double ga2Population::getCrossoverProbability(int type)
+{
+	if( (type <= 0) || (type >= GA2_CROSSOVER_ADAPTIVE) )
+		return 0.0;
+	return _operatorProbability[type];
+}
+
+bool ga2Population::_mutateReset(ga2Chromosome &a)
 {
 	int i;
 	for(i = 0; i < _chromoSize; ++i)
@@ -405,14 +1496,101 @@ bool ga2Population::_mutateFunc(ga2Chromosome &a)
 			}
 			else //no rounding
 				f = (((float)rand()/(float)RAND_MAX) * range) + _chromoMinRanges[i];
-
-				f = (((float)rand()/(float)RAND_MAX) * range) + _chromoMinRanges[i];
 			a.setGene(i, f);
 		}
 	}
 	return true;
 }
 
+//draws which genes mutate, and counts them. Returns false if none do.
+//Gaussian and polynomial mutation share it, filling the second half of
+//_draws themselves.
+static bool ga2DrawMutations(ga2Random &random, double *m, int n, double rate, int &count)
+{
+	int j, hits = 0;
+	for(j = 0; j < n; ++j)
+	{
+		m[j] = random.uniform();
+		hits += m[j] < rate;
+	}
+	count += hits;
+	return hits != 0;
+}
+
+bool ga2Population::_mutateGaussian(ga2Chromosome &a)
+{
+	int j, n = _chromoSize;
+	_draws.resize(2 * n);
+	double *m = &_draws[0], *g = m + n;
+	if(!ga2DrawMutations(_operatorRandom, m, n, _mutationRate, _mutationCount))
+		return true;
+	for(j = 0; j < n; ++j)
+		g[j] = m[j] < _mutationRate ? _operatorRandom.gaussian() : 0.0;
+	ga2Gene *x = &a._genes[0];
+	ga2KernelGaussian(x, &_chromoMinRanges[0], &_chromoMaxRanges[0], m, g, n,
+					  _mutationRate, _mutationSigma);
+	if(_integer)
+		for(j = 0; j < n; ++j)
+			x[j] = floorf(x[j] + 0.5f);
+	a._isEvaluated = false;
+	a._id = ga2Chromosome::_newId();
+	return true;
+}
+
+//swap, insert and inversion mutation, which keep a permutation one
+bool ga2Population::_mutatePermutation(ga2Chromosome &a)
+{
+	int i, n = _chromoSize, moves = 0;
+	ga2Gene *x = &a._genes[0];
+	for(i = 0; i < n; ++i)
+	{
+		if(_operatorRandom.uniform() >= _mutationRate)
+			continue;
+		int j = _operatorRandom.below(n);
+		if(j == i)
+			continue;
+		++moves;
+		if(_mutationType == GA2_MUTATE_SWAP)
+			std::swap(x[i], x[j]);
+		else if(_mutationType == GA2_MUTATE_INSERT) //take the gene out of i and put it at j
+		{
+			if(i < j)
+				std::rotate(x + i, x + i + 1, x + j + 1);
+			else
+				std::rotate(x + j, x + i, x + i + 1);
+		}
+		else
+			std::reverse(x + (i < j ? i : j), x + (i < j ? j : i) + 1);
+	}
+	if(moves)
+	{
+		_mutationCount += moves;
+		a._isEvaluated = false;
+		a._id = ga2Chromosome::_newId();
+	}
+	return true;
+}
+
+bool ga2Population::_mutatePolynomial(ga2Chromosome &a)
+{
+	int j, n = _chromoSize;
+	_draws.resize(2 * n);
+	double *m = &_draws[0], *u = m + n;
+	if(!ga2DrawMutations(_operatorRandom, m, n, _mutationRate, _mutationCount))
+		return true;
+	for(j = 0; j < n; ++j)
+		u[j] = _operatorRandom.uniform();
+	ga2Gene *x = &a._genes[0];
+	ga2KernelPolynomial(x, &_chromoMinRanges[0], &_chromoMaxRanges[0], m, u, n,
+						_mutationRate, _polynomialEta);
+	if(_integer)
+		for(j = 0; j < n; ++j)
+			x[j] = floorf(x[j] + 0.5f);
+	a._isEvaluated = false;
+	a._id = ga2Chromosome::_newId();
+	return true;
+}
+
 //IMPORTANT! ACHTUNG!
 //note on this function:
 //it will not work (it will, in fact, return false without doing anything)
@@ -428,7 +1606,10 @@ bool ga2Population::_replaceSteadyState(void)
 	{
 		//we have to do an insertion sort. large elements first, small last
 		if(_chromosomes.empty()) //if theres nothing there, just stuff it in there
+		{
 			_chromosomes.push_back(_nextGen[i]);
+			_addStats(_nextGen[i]);
+		}
 		else //we have to look for the right place to put it...
 		{
 			//get an iterator
@@ -438,12 +1619,16 @@ bool ga2Population::_replaceSteadyState(void)
 				  (it->getFitness() > _nextGen[i].getFitness()) )
 				it++;
 			_chromosomes.insert(it, _nextGen[i]);
+			_addStats(_nextGen[i]);
 		}
 	}
 	_nextGen.clear();
 	//we have a lot of excess members. clear them.
 	while(_size != _chromosomes.size())
+	{
+		_removeStats(_chromosomes.back());
 		_chromosomes.pop_back();
+	}
 
 	return true;
 }
@@ -458,7 +1643,10 @@ bool ga2Population::_replaceSteadyStateNoDuplicates(void)
 	{
 		//we have to do an insertion sort. large elements first, small last
 		if(_chromosomes.empty()) //if theres nothing there, just stuff it in there
+		{
 			_chromosomes.push_back(_nextGen[i]);
+			_addStats(_nextGen[i]);
+		}
 		else //we have to look for the right place to put it...
 		{
 			//get an iterator
@@ -476,13 +1664,17 @@ bool ga2Population::_replaceSteadyStateNoDuplicates(void)
 					   (it->getFitness() > _nextGen[i].getFitness()) )
 					it++;
 				_chromosomes.insert(it, _nextGen[i]);
+				_addStats(_nextGen[i]);
 			}
 		}
 	}
 	_nextGen.clear();
 	//we have a lot of excess members. clear them.
 	while(_size != _chromosomes.size())
+	{
+		_removeStats(_chromosomes.back());
 		_chromosomes.pop_back();
+	}
 
 	return true;
 }
@@ -492,9 +1684,11 @@ bool ga2Population::_replaceGenerational(void)
 	int i;
 	//if (!_isSorted)
 	_chromosomes.clear(); //we dont want to clear this list if its all sorted.
+	_clearStats(_nextGen.empty() ? NULL : &_nextGen[0]);
 	//note that we dont care about the replacement size
 	for(i = 0; i < _nextGen.size(); ++i)
 	{
+		_addStats(_nextGen[i]);
 		if(!_isSorted)
 			_chromosomes.push_back(_nextGen[i]);
 		else //we have to do an insertion sort. large elements first, small last
@@ -506,8 +1700,8 @@ bool ga2Population::_replaceGenerational(void)
 				//get an iterator
 				std::vector<ga2Chromosome>::iterator it = _chromosomes.begin();
 				//loop until we find the insertion point
-				while((it->getFitness() > _nextGen[i].getFitness()) &&
-					  (it != _chromosomes.end()) )
+				while((it != _chromosomes.end()) &&
+					  (it->getFitness() > _nextGen[i].getFitness()) )
 					it++;
 				_chromosomes.insert(it, _nextGen[i]);
 			}
@@ -517,11 +1711,440 @@ bool ga2Population::_replaceGenerational(void)
 	_nextGen.clear();
 	if(_isSorted) //if it is sorted, then we have a lot of excess members. clear them.
 		while(_size < _chromosomes.size())
+		{
+			_removeStats(_chromosomes.back());
 			_chromosomes.pop_back();
+		}
+
+	return true;
+}
+
+//sorts chromosomes best first, for sorted populations
+bool ga2Population::_fitter(const ga2Chromosome &a, const ga2Chromosome &b)
+{
+	return a._fitness > b._fitness;
+}
 
+//deterministic crowding: each child against the nearer of its parents
+bool ga2Population::_replaceCrowding(void)
+{
+	int i, n = _chromosomes.size(), L = _chromoSize;
+	if( (_chromoMinRanges.size() != L) || (_chromoMaxRanges.size() != L) )
+		return false;
+	const float *lo = &_chromoMinRanges[0], *hi = &_chromoMaxRanges[0];
+	bool moved = false;
+	for(i = 0; i + 1 < _nextGen.size(); i += 2)
+	{
+		ga2Chromosome *child[2] = {&_nextGen[i], &_nextGen[i+1]};
+		//crossover gives both children the pair's parents in order; a pair
+		//left uncrossed keeps one parent each
+		int p1 = child[0]->getParent(0), p2 = child[0]->getParent(1);
+		if(p2 == p1)
+			p2 = child[1]->getParent(0);
+		if( (p1 < 0) || (p1 >= n) || (p2 < 0) || (p2 >= n) )
+			continue;
+		const ga2Gene *a = &child[0]->_genes[0], *b = &child[1]->_genes[0];
+		const ga2Gene *x = &_chromosomes[p1]._genes[0], *y = &_chromosomes[p2]._genes[0];
+		double straight = ga2SpatialIndex::distance(a, x, L, lo, hi) + ga2SpatialIndex::distance(b, y, L, lo, hi);
+		double crossed = ga2SpatialIndex::distance(a, y, L, lo, hi) + ga2SpatialIndex::distance(b, x, L, lo, hi);
+		int parent[2] = {p1, p2};
+		if(crossed < straight)
+			std::swap(parent[0], parent[1]);
+		int c;
+		for(c = 0; c < 2; ++c)
+		{
+			ga2Chromosome &old = _chromosomes[parent[c]];
+			if(child[c]->_fitness < old._fitness)
+				continue;
+			_removeStats(old);
+			old = *child[c];
+			_addStats(old);
+			moved = true;
+		}
+	}
+	_nextGen.clear();
+	if(_isSorted && moved)
+		std::stable_sort(_chromosomes.begin(), _chromosomes.end(), _fitter);
 	return true;
 }
 
+//orders members by a fitness, fittest first
+struct ga2NicheRank
+{
+	const std::vector<double> *fitness;
+	bool operator()(int a, int b) const {return (*fitness)[a] > (*fitness)[b];};
+};
+
+//orders members by rank, fittest first
+struct ga2NicheByRank
+{
+	const std::vector<int> *rank;
+	bool operator()(int a, int b) const {return (*rank)[a] < (*rank)[b];};
+};
+
+//works out the fitness selection sees when sharing or clearing, and the
+//ranks that go with it. Clears both when not niching.
+void ga2Population::_niche(void)
+{
+	_nicheFitness.clear();
+	_nicheOrder.clear();
+	int n = _chromosomes.size(), i, k;
+	if( (_nicheType == GA2_NICHE_NONE) || (_nicheRadius <= 0.0) || !n
+	  ||(_chromoMinRanges.size() != _chromoSize) || (_chromoMaxRanges.size() != _chromoSize) )
+		return;
+	std::vector<const ga2Gene *> points(n);
+	double least = _chromosomes[0]._fitness;
+	for(i = 0; i < n; ++i)
+	{
+		points[i] = &_chromosomes[i]._genes[0];
+		least = _chromosomes[i]._fitness < least ? _chromosomes[i]._fitness : least;
+	}
+	_nicheIndex.build(points, _chromoSize, &_chromoMinRanges[0], &_chromoMaxRanges[0], _nicheRadius);
+	_nicheFitness.resize(n);
+	for(i = 0; i < n; ++i)
+		_nicheFitness[i] = _chromosomes[i]._fitness - least;
+
+	std::vector<int> neighbours;
+	std::vector<double> distances;
+	if(_nicheType == GA2_NICHE_SHARING)
+	{
+		std::vector<double> raw(_nicheFitness);
+		for(i = 0; i < n; ++i)
+		{
+			_nicheIndex.query(i, neighbours, &distances);
+			double count = 1.0; //itself
+			for(k = 0; k < distances.size(); ++k)
+				count += 1.0 - distances[k] / _nicheRadius;
+			_nicheFitness[i] = raw[i] / count;
+		}
+	}
+	else //clearing: the fittest of each niche take it all
+	{
+		std::vector<int> order(n), rank(n);
+		for(i = 0; i < n; ++i)
+			order[i] = i;
+		if(!_isSorted)
+		{
+			ga2NicheRank byFitness;
+			byFitness.fitness = &_nicheFitness;
+			std::stable_sort(order.begin(), order.end(), byFitness);
+		}
+		for(i = 0; i < n; ++i)
+			rank[order[i]] = i;
+		std::vector<unsigned char> cleared(n, 0);
+		for(i = 0; i < n; ++i)
+		{
+			int winner = order[i];
+			if(cleared[winner])
+				continue;
+			int winners = 1;
+			_nicheIndex.query(winner, neighbours);
+			//in rank order, so the capacity goes to the fittest
+			if(_nicheCapacity > 1)
+			{
+				ga2NicheByRank byRank;
+				byRank.rank = &rank;
+				std::sort(neighbours.begin(), neighbours.end(), byRank);
+			}
+			for(k = 0; k < neighbours.size(); ++k)
+			{
+				int j = neighbours[k];
+				if( (rank[j] < i) || cleared[j] )
+					continue;
+				if(winners < _nicheCapacity)
+					++winners;
+				else
+					cleared[j] = 1;
+			}
+		}
+		for(i = 0; i < n; ++i)
+			if(cleared[i])
+				_nicheFitness[i] = 0.0;
+	}
+
+	_nicheOrder.resize(n);
+	for(i = 0; i < n; ++i)
+		_nicheOrder[i] = i;
+	ga2NicheRank byNiche;
+	byNiche.fitness = &_nicheFitness;
+	std::stable_sort(_nicheOrder.begin(), _nicheOrder.end(), byNiche);
+}
+
+//zeroes the running sums, for a population with no members. They are kept
+//as deviations from centre, if given, as a member added next is likely to
+//be near the rest.
+void ga2Population::_clearStats(const ga2Chromosome *centre)
+{
+	_shiftedSumFitness = _shiftedSumSqFitness = 0.0;
+	_geneSum.assign(_chromoSize, 0.0);
+	_geneSumSq.assign(_chromoSize, 0.0);
+	_fitnessShift = 0.0;
+	_geneShift.assign(_chromoSize, 0.0);
+	if(centre && (centre->_genes.size() == _chromoSize))
+	{
+		_fitnessShift = centre->_fitness;
+		_geneShift.assign(centre->_genes.begin(), centre->_genes.end());
+	}
+	_statsValid = true;
+	_statsAge = 0;
+}
+
+//adds a chromosome that has joined the population to the running sums.
+//The gene loops are kept simple enough for the compiler to vectorise.
+void ga2Population::_addStats(const ga2Chromosome &c)
+{
+	double f = c._fitness - _fitnessShift;
+	_shiftedSumFitness += f;
+	_shiftedSumSqFitness += f * f;
+	if( (c._genes.size() != _chromoSize) || (_geneSum.size() != _chromoSize) )
+	{
+		_statsValid = false;
+		return;
+	}
+	const ga2Gene *g = &c._genes[0];
+	const double *shift = &_geneShift[0];
+	double *sum = &_geneSum[0], *sumSq = &_geneSumSq[0];
+	int j;
+	for(j = 0; j < _chromoSize; ++j)
+	{
+		double x = g[j] - shift[j];
+		sum[j] += x;
+		sumSq[j] += x * x;
+	}
+}
+
+//takes a chromosome that has left the population out of the running sums.
+void ga2Population::_removeStats(const ga2Chromosome &c)
+{
+	double f = c._fitness - _fitnessShift;
+	_shiftedSumFitness -= f;
+	_shiftedSumSqFitness -= f * f;
+	if( (c._genes.size() != _chromoSize) || (_geneSum.size() != _chromoSize) )
+	{
+		_statsValid = false;
+		return;
+	}
+	const ga2Gene *g = &c._genes[0];
+	const double *shift = &_geneShift[0];
+	double *sum = &_geneSum[0], *sumSq = &_geneSumSq[0];
+	int j;
+	for(j = 0; j < _chromoSize; ++j)
+	{
+		double x = g[j] - shift[j];
+		sum[j] -= x;
+		sumSq[j] -= x * x;
+	}
+}
+
+//the full passes over every gene, for when the sums cannot be trusted:
+//after the population has been replaced wholesale, once the members have
+//drifted from the shift, or now and then to clear out rounding errors. The
+//first pass finds the means to shift by. Every member must have been
+//evaluated.
+void ga2Population::_recomputeStats(void)
+{
+	_clearStats();
+	int i, j, n = _chromosomes.size();
+	if(!n)
+		return;
+	for(i = 0; i < n; ++i)
+	{
+		const ga2Chromosome &c = _chromosomes[i];
+		_fitnessShift += c._fitness;
+		if(c._genes.size() == _chromoSize)
+			for(j = 0; j < _chromoSize; ++j)
+				_geneShift[j] += c._genes[j];
+	}
+	_fitnessShift /= n;
+	for(j = 0; j < _chromoSize; ++j)
+		_geneShift[j] /= n;
+	for(i = 0; i < n; ++i)
+		_addStats(_chromosomes[i]);
+}
+
+//whether deviations from a shift, summing to sum with squares summing to
+//sumSq over n members, put the mean so far from the shift, for the spread,
+//that the variance worked out from them would have cancelled. Drift within
+//rounding of the shift itself does not count.
+static bool ga2Drifted(double shift, double sum, double sumSq, int n)
+{
+	double d = sum / n;
+	return (d * d > GA2_STATS_DRIFT * GA2_STATS_DRIFT * (sumSq / n - d * d))
+		&& (fabs(d) > 4.0 * DBL_EPSILON * fabs(shift));
+}
+
+//whether the fitness or any gene has drifted from its shift.
+bool ga2Population::_statsDrifted(void)
+{
+	int j, n = _chromosomes.size();
+	if(!n)
+		return false;
+	if(ga2Drifted(_fitnessShift, _shiftedSumFitness, _shiftedSumSqFitness, n))
+		return true;
+	for(j = 0; j < _geneSum.size(); ++j)
+		if(ga2Drifted(_geneShift[j], _geneSum[j], _geneSumSq[j], n))
+			return true;
+	return false;
+}
+
+//derives the statistics from the running sums. A sorted population has its
+//best first and its worst last; otherwise finding them takes a pass over
+//the fitness values, but not over the genes.
+void ga2Population::_updateStats(void)
+{
+	if( !_statsValid || (++_statsAge >= GA2_STATS_RESYNC) || _statsDrifted() )
+		_recomputeStats();
+	int i, n = _chromosomes.size();
+	if(!n)
+	{
+		_sumFitness = _avgFitness = _varFitness = _maxFitness = _minFitness = 0.0;
+		_bestIndex = 0;
+		return;
+	}
+	if(_isSorted)
+	{
+		_bestIndex = 0;
+		_maxFitness = _chromosomes.front()._fitness;
+		_minFitness = _chromosomes.back()._fitness;
+	}
+	else
+	{
+		_bestIndex = 0;
+		_maxFitness = _minFitness = _chromosomes[0]._fitness;
+		for(i = 1; i < n; ++i)
+		{
+			double f = _chromosomes[i]._fitness;
+			if(f > _maxFitness)
+			{
+				_maxFitness = f;
+				_bestIndex = i;
+			}
+			if(f < _minFitness)
+				_minFitness = f;
+		}
+	}
+	double d = _shiftedSumFitness / n;
+	_sumFitness = _fitnessShift * n + _shiftedSumFitness;
+	_avgFitness = _fitnessShift + d;
+	_varFitness = _shiftedSumSqFitness / n - d * d;
+	if(_varFitness < 0.0)
+		_varFitness = 0.0;
+}
+
+/**
+ * \param index The gene in question.
+ *
+ * Taken from running sums, so it costs nothing to ask for. Up to date as
+ * of the last ga2Population::evaluate() or ga2Population::step().
+ */
+double ga2Population::getGeneVariance(int index)
+{
+	int n = _chromosomes.size();
+	if( !n || (index < 0) || (index >= _geneSum.size()) )
+		return 0.0;
+	double d = _geneSum[index] / n; //mean less the shift
+	double var = _geneSumSq[index] / n - d * d;
+	return var > 0.0 ? var : 0.0;
+}
+
+/**
+ * The variance of each gene as a fraction of that of a gene spread
+ * uniformly over its range, averaged over the genes: about 1 for a freshly
+ * initialised population, and 0 for one that has converged on a single
+ * point. A cheap signal for deciding when to restart. Costs one pass over
+ * the genes of one chromosome.
+ */
+double ga2Population::getDiversity(void)
+{
+	double total = 0.0;
+	int j, counted = 0;
+	for(j = 0; j < _chromoSize; ++j)
+	{
+		double range = _chromoMaxRanges[j] - _chromoMinRanges[j];
+		if(_integer)
+			range += 1.0;
+		if(range <= 0.0)
+			continue;
+		total += 12.0 * getGeneVariance(j) / (range * range);
+		++counted;
+	}
+	return counted ? total / counted : 0.0;
+}
+
+/**
+ * The mean squared Euclidean distance between two different members,
+ * averaged over every pair. Exact, and as cheap as
+ * ga2Population::getDiversity(), since it comes to 2n/(n-1) times the sum
+ * of the gene variances.
+ */
+double ga2Population::getMeanSquaredDistance(void)
+{
+	int j, n = _chromosomes.size();
+	if(n < 2)
+		return 0.0;
+	double total = 0.0;
+	for(j = 0; j < _chromoSize; ++j)
+		total += getGeneVariance(j);
+	return 2.0 * n / (n - 1) * total;
+}
+
+/**
+ * \param pairs How many pairs of members to measure.
+ *
+ * The mean Euclidean distance between randomly chosen pairs of different
+ * members. Costs pairs passes over the genes of two chromosomes.
+ */
+double ga2Population::getSampledDistance(int pairs)
+{
+	int k, j, n = _chromosomes.size();
+	if( (n < 2) || (pairs <= 0) )
+		return 0.0;
+	double total = 0.0;
+	for(k = 0; k < pairs; ++k)
+	{
+		int a = _statsRandom.below(n), b = _statsRandom.below(n - 1);
+		if(b >= a)
+			++b;
+		const std::vector<ga2Gene> &x = _chromosomes[a]._genes, &y = _chromosomes[b]._genes;
+		double d = 0.0;
+		for(j = 0; j < x.size() && j < y.size(); ++j)
+		{
+			double diff = (double)x[j] - y[j];
+			d += diff * diff;
+		}
+		total += sqrt(d);
+	}
+	return total / pairs;
+}
+
+/**
+ * \param val Whether every chromosome is an ordering of 0, 1, ... length - 1.
+ *
+ * For routing, scheduling and other problems whose solutions are orders:
+ * each gene is the number of a city, job and so on, and each appears
+ * exactly once. Switching this on makes the genes integers ranging over
+ * 0 to length - 1, and makes ga2Population::init() start from random
+ * permutations.
+ *
+ * Only the permutation operators keep chromosomes permutations, so set the
+ * crossover type to GA2_CROSSOVER_ORDER, GA2_CROSSOVER_PMX or
+ * GA2_CROSSOVER_CYCLE, and the mutation type to GA2_MUTATE_SWAP,
+ * GA2_MUTATE_INSERT or GA2_MUTATE_INVERSION. All of them take time in
+ * proportion to the length of the chromosome, and their working space is
+ * allocated here, not each time they are used.
+ */
+void ga2Population::setPermutation(bool val)
+{
+	_permutation = val;
+	if(!val)
+		return;
+	_integer = true;
+	setMinRanges(std::vector<float>(_chromoSize, 0.0f));
+	setMaxRanges(std::vector<float>(_chromoSize, (float)(_chromoSize - 1)));
+	_permScratch.resize(2 * _chromoSize);
+	_permChildren.resize(2 * _chromoSize);
+}
+
 /**
  * \param ranges A vector containing the upper bound for the values of each
  * gene.
@@ -568,15 +2191,98 @@ void ga2Population::setMinRanges(std::vector<float> ranges)
  */
 std::vector<ga2Gene> ga2Population::getBestFitChromosome(void)
 {
+	if(_bestIndex >= _chromosomes.size())
+		return std::vector<ga2Gene>();
+	return _chromosomes[_bestIndex].getGenes();
+}
+
+/**
+ * \param path File to write
+ * \param generation A generation number to store with the population
+ *
+ * Saves the population in the binary checkpoint format described in
+ * ga2Checkpoint.h: sizes, ranges, a fitness array and a gene matrix, with
+ * a checksum for each. Nothing is formatted, so this runs at disk speed.
+ * The file is written under a temporary name and renamed into place, so
+ * a crash part way through never leaves a damaged checkpoint behind.
+ * Chromosomes that have not been evaluated are saved as such, and are not
+ * evaluated by saving them.
+ */
+bool ga2Population::writeCheckpoint(const char *path, unsigned long generation)
+{
+	std::string tmp = std::string(path) + ".tmp";
+	ga2Checkpoint ckpt;
+	int n = _chromosomes.size() < _size ? _chromosomes.size() : _size;
+	if(!ckpt.create(tmp.c_str(), n, _chromoSize))
+		return false;
+
+	ckpt.setGeneration(generation);
+	int i;
+	for(i = 0; i < _chromoSize; ++i)
+	{
+		ckpt.getMinRanges()[i] = _chromoMinRanges[i];
+		ckpt.getMaxRanges()[i] = _chromoMaxRanges[i];
+	}
+	double *fitness = ckpt.getFitness();
+	unsigned char *evaluated = ckpt.getEvaluated();
+	for(i = 0; i < n; ++i)
+	{
+		ga2Chromosome &c = _chromosomes[i];
+		evaluated[i] = c.isEvaluated();
+		fitness[i] = c.isEvaluated() ? c.getFitness() : 0.0;
+		std::vector<ga2Gene> genes = c.getGenes();
+		if(!genes.empty())
+			memcpy(ckpt.getGenes(i), &genes[0], _chromoSize * sizeof(ga2Gene));
+	}
+	bool ok = ckpt.sync();
+	ckpt.close();
+	if(!ok || (rename(tmp.c_str(), path) != 0))
+	{
+		remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+/**
+ * \param path File to read
+ *
+ * Restores a population saved with ga2Population::writeCheckpoint(),
+ * replacing the current one, including its size, chromosome size and
+ * ranges. The file is mapped rather than parsed, and checked against its
+ * checksums first: if it is damaged, false is returned and the population
+ * is left as it was. Saved fitness values are kept, so nothing is
+ * re-evaluated.
+ */
+bool ga2Population::readCheckpoint(const char *path)
+{
+	ga2Checkpoint ckpt;
+	if(!ckpt.open(path))
+		return false;
+
+	flush();
+	_size = ckpt.getSize();
+	_chromoSize = ckpt.getChromoSize();
+	_chromoMinRanges.assign(ckpt.getMinRanges(), ckpt.getMinRanges() + _chromoSize);
+	_chromoMaxRanges.assign(ckpt.getMaxRanges(), ckpt.getMaxRanges() + _chromoSize);
+	_chromosomes.clear();
+	_nextGen.clear();
+	_chromosomes.reserve(2*_size);
+
 	int i;
-	float f = 0;
 	for(i = 0; i < _size; ++i)
 	{
-		f = _chromosomes[i].getFitness();
-		if(f = _maxFitness)
-			return _chromosomes[i].getGenes();
+		ga2Chromosome c(_chromoSize);
+		c.setMaxRanges(_chromoMaxRanges);
+		c.setMinRanges(_chromoMinRanges);
+		c.setGenes(std::vector<ga2Gene>(ckpt.getGenes(i), ckpt.getGenes(i) + _chromoSize));
+		c.setEvalFunc(_evalFunc);
+		if(ckpt.getEvaluated()[i])
+			c.setFitness(ckpt.getFitness()[i]);
+		_chromosomes.push_back(c);
 	}
-	return NULL;
+	_statsValid = false;
+	return true;
 }
 
 /**
@@ -624,7 +2330,7 @@ std::istream& operator>> ( std::istream &in, ga2Population &pop )
 		pop._chromoMinRanges.push_back(f);
 	}
 	//now, grab the chromosomes themselves
-	for(i = 0; i < pop._chromoSize; ++i)
+	for(i = 0; i < pop._size; ++i)
 	{
 		ga2Chromosome c(pop._chromoSize);
 		in >> c;
@@ -633,6 +2339,7 @@ std::istream& operator>> ( std::istream &in, ga2Population &pop )
 		c.setEvalFunc(pop._evalFunc);
 		pop._chromosomes.push_back(c);
 	}
+	pop._statsValid = false;
 
 	return in;
 }
@@ -24,6 +24,41 @@
 #include <iostream>
 #include <vector>
 #include "ga2Chromosome.h"
+#include "ga2Random.h"
+#include "ga2Scheduler.h"
+#include "ga2SpatialIndex.h"
+#include "ga2.h" //for the crossover types the adaptive tables are indexed by
+
+class ga2Genealogy;
+class ga2FitnessCache;
+class ga2Profiler;
+class ga2Tracer;
+
+///When ga2Population::run() should stop.
+/**
+ * A run stops as soon as any one of the criteria is met. Zero (or false,
+ * for the target) switches a criterion off; the constructor switches them
+ * all off, so set at least one.
+ */
+struct ga2StopCriteria
+{
+	///Stop after this many generations.
+	long maxGenerations;
+	///Stop once this many chromosomes have been evaluated.
+	long maxEvaluations;
+	///Stop once this much wall time has passed, in seconds.
+	double maxSeconds;
+	///Stop once the best fitness reaches targetFitness.
+	bool useTargetFitness;
+	double targetFitness;
+	///Stop once the best fitness has not improved for this many generations.
+	long stagnationGenerations;
+	///The least gain in the best fitness that counts as an improvement.
+	double stagnationTolerance;
+
+	///The constructor.
+	ga2StopCriteria();
+};
 
 ///A class representing a population of chromosomes
 /**
@@ -37,6 +72,13 @@
  */
 class ga2Population
 {
+	friend class ga2DeltaCheckpoint;
+	friend class ga2Logger;
+	friend class ga2Genealogy;
+	friend class ga2TextLoader;
+	friend class ga2DifferentialEvolution;
+	friend class ga2CMAES;
+
 	int _size;
 
 	double(* _evalFunc)(std::vector<ga2Gene>);
@@ -47,11 +89,35 @@ class ga2Population
 
 	int _selectRanked(void);
 	int _selectFunc(void);
-	bool _crossoverOnePoint(ga2Chromosome &a, ga2Chromosome &b); //inserts two new critters in the nextGen
+	bool _crossoverOnePoint(ga2Chromosome &a, ga2Chromosome &b); //swaps the tails in place
 	bool _crossoverUniform(ga2Chromosome &a, ga2Chromosome &b);
+	bool _crossoverSBX(ga2Chromosome &a, ga2Chromosome &b);
+	bool _crossoverBLX(ga2Chromosome &a, ga2Chromosome &b);
+	bool _mutateReset(ga2Chromosome &a);
+	bool _mutateGaussian(ga2Chromosome &a);
+	bool _mutatePolynomial(ga2Chromosome &a);
+	bool _crossoverOrder(ga2Chromosome &a, ga2Chromosome &b);
+	bool _crossoverPMX(ga2Chromosome &a, ga2Chromosome &b);
+	bool _crossoverCycle(ga2Chromosome &a, ga2Chromosome &b);
+	bool _mutatePermutation(ga2Chromosome &a);
+	void _offspring(ga2Chromosome &a, ga2Chromosome &b, int crossSite);
+	int _pickCrossover(void);
+	void _adapt(const std::vector< ga2Chromosome > &offspring);
 	bool _replaceSteadyState(void);
 	bool _replaceSteadyStateNoDuplicates(void);
 	bool _replaceGenerational(void);
+	bool _replaceCrowding(void);
+	void _niche(void);
+	static bool _fitter(const ga2Chromosome &a, const ga2Chromosome &b);
+	void _evaluateBatch(std::vector< ga2Chromosome > &chromos);
+	void _profileGeneration(void);
+	void _addStats(const ga2Chromosome &c);
+	void _removeStats(const ga2Chromosome &c);
+	void _clearStats(const ga2Chromosome *centre = NULL);
+	void _recomputeStats(void);
+	bool _statsDrifted(void);
+	void _updateStats(void);
+	bool _step(bool sweep);
 
 	int _chromoSize;
 	std::vector<float> _chromoMaxRanges;
@@ -65,10 +131,47 @@ class ga2Population
 	bool _integer;
 	bool _isSorted;
 	int _crossoverType;
+	int _mutationType;
+	double _sbxEta;
+	double _blxAlpha;
+	double _mutationSigma;
+	double _polynomialEta;
+	ga2Random _operatorRandom; //draws for the real-coded operators
+	std::vector<double> _draws; //scratch, two per gene
+	bool _adaptiveMutation;
+	double _successRate;
+	double _operatorQuality[GA2_CROSSOVER_ADAPTIVE]; //indexed by crossover type
+	double _operatorProbability[GA2_CROSSOVER_ADAPTIVE];
+	bool _permutation;
+	std::vector<int> _permScratch; //two per gene
+	std::vector<ga2Gene> _permChildren;
+	int _nicheType;
+	double _nicheRadius;
+	int _nicheCapacity;
+	ga2SpatialIndex _nicheIndex;
+	std::vector<double> _nicheFitness; //what selection sees, while niching
+	std::vector<int> _nicheOrder; //members by niche fitness, fittest first
+	int _localSearchMode;
+	double _localSearchFraction;
+	int _localSearchBudget;
+	double _localSearchStep;
 	int _selectionType;
 	int _replacementType;
 
 	double _sumFitness;
+	double _varFitness;
+	int _bestIndex;
+	//the running sums are of deviations from a shift near the mean, so they
+	//do not cancel for members far from zero
+	double _fitnessShift;
+	double _shiftedSumFitness;
+	double _shiftedSumSqFitness;
+	std::vector<double> _geneShift;
+	std::vector<double> _geneSum; //over the current members, for diversity
+	std::vector<double> _geneSumSq;
+	bool _statsValid; //the running sums match the members
+	int _statsAge; //evaluations since the sums were last recomputed
+	ga2Random _statsRandom;
 	double _avgFitness;
 	double _minFitness;
 	double _maxFitness;
@@ -76,6 +179,31 @@ class ga2Population
 	int _crossCount;
 	int _mutationCount;
 
+	ga2Scheduler *_scheduler;
+	bool _pipelined;
+	std::vector< ga2Chromosome > _inFlight;
+	ga2Task *_inFlightTask;
+	ga2Job *_inFlightJob;
+	ga2Genealogy *_genealogy;
+	int _parentLag; //generations back the last offspring replaced were bred
+	ga2FitnessCache *_fitnessCache;
+	ga2Profiler *_profiler;
+	long _cacheHits; //of the fitness cache, when last profiled
+	ga2Tracer *_tracer;
+	long _generation; //steps taken
+	long _evaluations; //chromosomes evaluated, ever
+	bool (* _progressFunc)(ga2Population &, void *);
+	void *_progressData;
+	long _progressInterval;
+	void (* _improvementFunc)(ga2Population &, void *);
+	void *_improvementData;
+	std::vector< std::vector<ga2Gene> > _seeds; //taken by the next init()
+	std::vector< double > _seedFitness;
+	std::vector< bool > _seedEvaluated;
+
+	void _addSeeds(const ga2Gene *const *genes, const double *fitness, const unsigned char *evaluated,
+				   int n, int count, bool keepFitness);
+
 public:
 	///The constructor.
 	ga2Population( int initialSize, int chromoSize );
@@ -90,24 +218,83 @@ public:
 	void setSelectType(int type) {_selectionType = type;};
 	///Set the crossover function to use.
 	/**
-	 * \param type valid values are GA2_CROSSOVER_ONEPOINT or
-	 * GA2_CROSSOVER_UNIFORM
+	 * \param type valid values are GA2_CROSSOVER_ONEPOINT,
+	 * GA2_CROSSOVER_UNIFORM, GA2_CROSSOVER_SBX, GA2_CROSSOVER_BLX or
+	 * GA2_CROSSOVER_ADAPTIVE
 	 *
-	 * Sets crossover to one-point or uniform. More types to come
+	 * One-point and uniform crossover only swap genes between the parents.
+	 * The other two are for real-valued genes, and make new values:
+	 * simulated binary crossover (SBX) spreads the children about the
+	 * parents the way one-point crossover does bit strings, close to them
+	 * more often than not (see ga2Population::setSBXEta()), and BLX-alpha
+	 * picks each child gene uniformly from the parents' interval widened
+	 * by alpha of its length at each end (see ga2Population::setBLXAlpha()).
+	 * Children are clamped into range, and rounded for integer genes.
+	 *
+	 * GA2_CROSSOVER_ADAPTIVE chooses one of the other four afresh for each
+	 * pair, favouring those whose children have recently improved most on
+	 * their parents (see ga2Population::getCrossoverProbability()), so the
+	 * right one for the problem need not be found by trial and error.
+	 *
+	 * For permutations (see ga2Population::setPermutation()) use
+	 * GA2_CROSSOVER_ORDER, GA2_CROSSOVER_PMX or GA2_CROSSOVER_CYCLE, which
+	 * make children that are permutations too.
 	 */
 	void setCrossoverType(int type) {_crossoverType = type;};
+	///Set the mutation function to use.
+	/**
+	 * \param type valid values are GA2_MUTATE_RESET (the default),
+	 * GA2_MUTATE_GAUSSIAN or GA2_MUTATE_POLYNOMIAL
+	 *
+	 * Each gene mutates with the mutation rate's probability. Reset
+	 * mutation gives it a new value anywhere in its range; Gaussian
+	 * mutation adds normal noise, scaled to the range (see
+	 * ga2Population::setMutationSigma()); polynomial mutation moves it by
+	 * a step drawn from a polynomial distribution that stays within the
+	 * range and favours small moves (see ga2Population::setPolynomialEta()).
+	 * The last two suit fine tuning real-valued genes, and are clamped into
+	 * range and rounded for integer genes.
+	 *
+	 * For permutations (see ga2Population::setPermutation()) use
+	 * GA2_MUTATE_SWAP, GA2_MUTATE_INSERT or GA2_MUTATE_INVERSION. Each
+	 * position mutates with the mutation rate's probability: it swaps with
+	 * another, moves to another place, or has the stretch between it and
+	 * another reversed.
+	 */
+	void setMutationType(int type) {_mutationType = type;};
+	///Set the distribution index of simulated binary crossover. Defaults to 15; larger keeps children nearer their parents.
+	void setSBXEta(double eta) {_sbxEta = eta;};
+	///Set how far BLX-alpha crossover reaches beyond the parents, as a fraction of their distance. Defaults to 0.5.
+	void setBLXAlpha(double alpha) {_blxAlpha = alpha;};
+	///Set the standard deviation of Gaussian mutation, as a fraction of each gene's range. Defaults to 0.1.
+	void setMutationSigma(double sigma) {_mutationSigma = sigma;};
+	///Set the distribution index of polynomial mutation. Defaults to 20; larger makes smaller moves.
+	void setPolynomialEta(double eta) {_polynomialEta = eta;};
 	///Set the replacement function to use.
 	/**
 	 * \param type valid values are GA2_REPLACE_GENERATIONAL,
-	 * GA2_REPLACE_STEADYSTATE, or
-	 * GA2_REPLACE_STEADYSTATENODUPLICATES
+	 * GA2_REPLACE_STEADYSTATE,
+	 * GA2_REPLACE_STEADYSTATENODUPLICATES or GA2_REPLACE_CROWDING
 	 *
 	 * Sets replacement to generational (total replacement) or
 	 * steady-state (only the worst offenders are booted). If
 	 * I recall, steady-state requires a sorted population to
 	 * properly remove the least fit.
+	 *
+	 * GA2_REPLACE_CROWDING is deterministic crowding, a niching method:
+	 * each pair of children is matched with its pair of parents so that
+	 * the total distance between them is least, and each child replaces
+	 * its parent if it is at least as fit. Children only ever displace
+	 * something like themselves, so several optima can hold on to their
+	 * share of the population. All the selection pressure comes from
+	 * this, so parents are chosen uniformly, whatever the selection type.
+	 * Children must meet the parents they were bred from, so crowding
+	 * steps are never pipelined.
+	 *
+	 * Any pipelined batch still in flight is flushed under the old
+	 * replacement first.
 	 */
-	void setReplaceType(int type) {_replacementType = type;};
+	void setReplaceType(int type) {flush(); _replacementType = type;};
 	///Set the evaluation function to use.
 	/**
 	 * \param func the function to call. Must be of form
@@ -117,8 +304,60 @@ public:
 	 * members.
 	 */
 	void setEvalFunc(double (* func)(std::vector<ga2Gene>)) {_evalFunc = func;};
+	///Set the scheduler used to evaluate chromosomes in parallel.
+	/**
+	 * \param sched the scheduler to use, or NULL to evaluate serially on the
+	 * calling thread (the default).
+	 *
+	 * The population does not take ownership of the scheduler, and the
+	 * evaluation function must be safe to call from several threads at once.
+	 * Any pipelined batch still in flight is flushed through the old
+	 * scheduler first. A pipelined population's scheduler must outlive it,
+	 * as the destructor flushes too.
+	 */
+	void setScheduler(ga2Scheduler *sched) {flush(); _scheduler = sched;};
+	///Return the scheduler used to evaluate chromosomes, if any.
+	ga2Scheduler *getScheduler(void) {return _scheduler;};
+	///Set a genealogy to record every generation in.
+	/**
+	 * \param genealogy a ga2Genealogy on which ga2Genealogy::create() has
+	 * been called, or NULL to stop recording (the default).
+	 *
+	 * Once set, ga2Population::init() and each ga2Population::step() append
+	 * a generation to it. The population does not take ownership.
+	 */
+	void setGenealogy(ga2Genealogy *genealogy) {_genealogy = genealogy;};
+	///Set a cache to look fitness values up in before evaluating.
+	void setFitnessCache(ga2FitnessCache *cache);
+	///Set a profiler to record time spent in each phase.
+	void setProfiler(ga2Profiler *profiler);
+	///Return the profiler, if any.
+	ga2Profiler *getProfiler(void) {return _profiler;};
+	///Set a tracer to record each generation and phase in.
+	/**
+	 * \param tracer an open ga2Tracer, or NULL to stop tracing (the
+	 * default).
+	 *
+	 * Every ga2Population::step() is recorded as a "generation" span, and
+	 * each phase within it as a span of its own. To see the evaluations on
+	 * the workers, give the tracer to the scheduler as well (see
+	 * ga2Scheduler::setTracer()). The population does not take ownership.
+	 */
+	void setTracer(ga2Tracer *tracer) {_tracer = tracer;};
 	///Initialise the population.
 	bool init(void);
+	///Start the next init() from a known chromosome.
+	bool addSeed(const std::vector<ga2Gene> &genes);
+	///Start the next init() from a number of known chromosomes.
+	int addSeeds(const std::vector< std::vector<ga2Gene> > &genomes);
+	///Start the next init() from the best chromosomes in a checkpoint file.
+	int addSeeds(const char *path, int count = -1, bool keepFitness = false);
+	///Start the next init() from the best chromosomes of another population.
+	int addSeeds(ga2Population &prior, int count = -1, bool keepFitness = false);
+	///Forget every seed not yet used by init().
+	void clearSeeds(void) {_seeds.clear(); _seedFitness.clear(); _seedEvaluated.clear();};
+	///Return the number of seeds waiting for init().
+	int getSeedCount(void) {return _seeds.size();};
 	///Select from the current generation for the next.
 	bool select(void);
 	///Evaluate the next generation.
@@ -127,8 +366,46 @@ public:
 	bool crossover(void);
 	///Mutate the current generation.
 	bool mutate(void);
+	///Improve some of the next generation by local search.
+	bool localSearch(void);
 	///Replace the current generation with the next generation.
 	bool replace(void);
+	///Run one generation: select, crossover, mutate, replace and evaluate.
+	bool step(void);
+	///Run generations until a stopping criterion is met.
+	int run(const ga2StopCriteria &stop);
+	///Set a function for ga2Population::run() to report progress to.
+	/**
+	 * \param func Called as func(population, data) after every interval
+	 * generations. Return false to stop the run. NULL for none.
+	 * \param data Passed through to func untouched.
+	 * \param interval How many generations between calls.
+	 */
+	void setProgressFunc(bool (* func)(ga2Population &, void *), void *data = NULL, long interval = 1)
+		{_progressFunc = func; _progressData = data; _progressInterval = interval > 0 ? interval : 1;};
+	///Set a function for ga2Population::run() to call when the best fitness improves.
+	/**
+	 * \param func Called as func(population, data) after each generation
+	 * that improves on the best fitness by more than the stagnation
+	 * tolerance. NULL for none.
+	 * \param data Passed through to func untouched.
+	 */
+	void setImprovementFunc(void (* func)(ga2Population &, void *), void *data = NULL)
+		{_improvementFunc = func; _improvementData = data;};
+	///Return the number of generations stepped.
+	long getGeneration(void) {return _generation;};
+	///Return the number of chromosomes evaluated so far.
+	/**
+	 * Counts every chromosome that needed evaluating, including those found
+	 * in the fitness cache.
+	 */
+	long getEvaluations(void) {return _evaluations;};
+	///Finish any generation still being evaluated by a pipelined step().
+	bool flush(void);
+	///Overlap evaluation of each generation with breeding of the next.
+	void setPipelined(bool val);
+	///Is the population running pipelined generations?
+	bool getPipelined(void) {return _pipelined;};
 	///Set the minimum values for each gene.
 	void setMinRanges(std::vector<float> ranges);
 	///Set the maximum values for each gene.
@@ -143,6 +420,44 @@ public:
 	void setMutationRate(float mRate) {_mutationRate = mRate;};
 	///Set the probability of a chromosome crossing-over.
 	void setCrossoverRate(float cRate) {_crossoverRate = cRate;};
+	///Adapt the mutation rate, or for Gaussian mutation its sigma, as the run goes.
+	/**
+	 * Follows Rechenberg's 1/5th success rule. After each generation,
+	 * mutation is made stronger if more than a fifth of the offspring
+	 * beat the fitter of their parents, and weaker if fewer did. The
+	 * values set by ga2Population::setMutationRate() and
+	 * ga2Population::setMutationSigma() are just where it starts. It
+	 * pays off most on smooth landscapes; on very rugged ones it can
+	 * shrink mutation before the search has found the right basin.
+	 */
+	void setAdaptiveMutation(bool val) {_adaptiveMutation = val;};
+	///Return the mutation rate, which changes if adaptive mutation is on.
+	double getMutationRate(void) {return _mutationRate;};
+	///Return the sigma of Gaussian mutation, which changes if adaptive mutation is on.
+	double getMutationSigma(void) {return _mutationSigma;};
+	///Return the fraction of the last offspring that were fitter than their parents.
+	/**
+	 * Only kept while adaptive mutation or adaptive crossover is on.
+	 */
+	double getSuccessRate(void) {return _successRate;};
+	///Return the chance of adaptive crossover using a crossover type.
+	double getCrossoverProbability(int type);
+	///Refine offspring by local search after mutation, making a memetic algorithm.
+	/**
+	 * \param mode GA2_LOCALSEARCH_NONE (the default), GA2_LOCALSEARCH_LAMARCKIAN
+	 * or GA2_LOCALSEARCH_BALDWINIAN
+	 * \param fraction The chance of each offspring being refined.
+	 * \param budget The most evaluations spent refining each one.
+	 *
+	 * See ga2Population::localSearch(). Lamarckian search writes the genes
+	 * it finds back into the offspring; Baldwinian search keeps the
+	 * offspring's genes, and only gives it the fitness they lead to, which
+	 * keeps more diversity at the cost of slower convergence.
+	 */
+	void setLocalSearch(int mode, double fraction, int budget)
+		{_localSearchMode = mode; _localSearchFraction = fraction; _localSearchBudget = budget;};
+	///Set the first step local search takes, in standard deviations of the population in each gene. Defaults to 1.
+	void setLocalSearchStep(double step) {_localSearchStep = step;};
 	///Set the number of chromosomes chosen from the next generation to replace the current generation.
 	void setReplacementSize(int rSize) {_replacementSize = rSize;};
 	///Print the population as a pretty string.
@@ -152,6 +467,28 @@ public:
 		{_chromosomes[index].printAsSpaceDelimitedString(out);};
 	///Are we using integer genes or floating point genes?
 	void setInteger(bool val) {_integer = val;};
+	///Set fitness sharing or clearing, to keep several optima alive.
+	/**
+	 * \param type GA2_NICHE_NONE (the default), GA2_NICHE_SHARING or
+	 * GA2_NICHE_CLEARING
+	 * \param radius The niche radius, as a distance in gene space with
+	 * each gene's range scaled to 1 (see ga2SpatialIndex).
+	 * \param capacity For clearing, the members a niche keeps.
+	 *
+	 * Both change the fitness selection sees, not the fitness itself.
+	 * Sharing divides each member's fitness (less the population's lowest)
+	 * by its niche count, the sum over its neighbours within the radius of
+	 * 1 - distance / radius, so crowded optima are worth less. Clearing
+	 * keeps the full fitness of only the fittest capacity members of each
+	 * niche, and brings the rest down to the lowest. Both are recomputed
+	 * at every selection, with the neighbours found through a
+	 * ga2SpatialIndex rather than by measuring every pair. For niching in
+	 * replacement instead, see GA2_REPLACE_CROWDING.
+	 */
+	void setNiching(int type, double radius, int capacity = 1)
+		{_nicheType = type; _nicheRadius = radius; _nicheCapacity = capacity;};
+	///Are the chromosomes permutations?
+	void setPermutation(bool val);
 	//note: sorting really messes up canonical generational replacement.
 	//instead of replacing the entire generation, only the best fit
 	//of the current and next are kept, weeding out all the weaker ones.
@@ -181,6 +518,18 @@ public:
 	 * in the population.
 	 */
 	double getSumFitness(void) {return _sumFitness;};
+	///Return the variance of the fitness values in the population.
+	double getFitnessVariance(void) {return _varFitness;};
+	///Return the index of the most fit chromosome.
+	int getBestIndex(void) {return _bestIndex;};
+	///Return the variance of one gene over the population.
+	double getGeneVariance(int index);
+	///Return how spread out the population is, from 0 (converged) up.
+	double getDiversity(void);
+	///Return the mean squared distance between two chromosomes.
+	double getMeanSquaredDistance(void);
+	///Estimate the mean distance between two chromosomes from a sample.
+	double getSampledDistance(int pairs);
 	///Return the fitness of a single chromosome.
 	double getFitness(int index) {return _chromosomes[index].getFitness();};
 	///Return the most fit chromosome.
@@ -193,6 +542,10 @@ public:
 	int getMutationCount(void) {return _mutationCount;};
 	///Return the number of crossovers performed.
 	int getCrossCount(void) {return _crossCount;};
+	///Save the population to a binary checkpoint file.
+	bool writeCheckpoint(const char *path, unsigned long generation = 0);
+	///Restore the population from a binary checkpoint file.
+	bool readCheckpoint(const char *path);
 	///Output the entire population.
 	friend std::ostream& operator<< ( std::ostream &o, ga2Population &pop );
 	///Read in a stored generation.
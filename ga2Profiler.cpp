@@ -0,0 +1,171 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Profiler.cpp: implementation of the ga2Profiler class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include "ga2.h"
+
+static const char *ga2PhaseNames[GA2_PHASE_COUNT] =
+{
+	"init", "select", "crossover", "mutate", "evaluate", "replace", "localsearch"
+};
+
+static const char *ga2CounterNames[GA2_COUNTER_COUNT] =
+{
+	"evaluations", "cachehits", "allocations", "crossovers", "mutations"
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * Starts counting chromosome allocations (see
+ * ga2Chromosome::countAllocations()).
+ */
+ga2Profiler::ga2Profiler()
+{
+	ga2Chromosome::countAllocations(true);
+	reset();
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2Profiler::~ga2Profiler()
+{
+	ga2Chromosome::countAllocations(false);
+}
+
+void ga2Profiler::reset(void)
+{
+	int i;
+	for(i = 0; i < GA2_PHASE_COUNT; ++i)
+	{
+		_calls[i] = 0;
+		_seconds[i] = 0.0;
+		_minSeconds[i] = -1.0;
+		_maxSeconds[i] = 0.0;
+		_generationSeconds[i] = 0.0;
+		_generationCalls[i] = 0;
+	}
+	for(i = 0; i < GA2_COUNTER_COUNT; ++i)
+		_counts[i] = _generationCounts[i] = 0;
+	memset(_phaseHistogram, 0, sizeof(_phaseHistogram));
+	memset(_counterHistogram, 0, sizeof(_counterHistogram));
+	_generations = 0;
+	_allocations = ga2Chromosome::getAllocationCount();
+}
+
+int ga2Profiler::_bucket(double value)
+{
+	int b = 0;
+	while( (value >= 2.0) && (b < GA2_PROFILE_BUCKETS - 1) )
+	{
+		value /= 2.0;
+		++b;
+	}
+	return b;
+}
+
+/**
+ * \param phase One of the GA2_PHASE_ constants.
+ * \param seconds Wall time taken.
+ *
+ * Called by ga2ProfileScope; a phase that runs more than once in a
+ * generation has its times added together for the histogram.
+ */
+void ga2Profiler::addTime(int phase, double seconds)
+{
+	++_calls[phase];
+	_seconds[phase] += seconds;
+	++_generationCalls[phase];
+	_generationSeconds[phase] += seconds;
+}
+
+/**
+ * Called by ga2Population::init() and ga2Population::step(). Phases that
+ * did not run in the generation are left out of its histograms.
+ */
+void ga2Profiler::endGeneration(void)
+{
+	long allocations = ga2Chromosome::getAllocationCount();
+	count(GA2_COUNTER_ALLOCATIONS, allocations - _allocations);
+	_allocations = allocations;
+
+	int i;
+	for(i = 0; i < GA2_PHASE_COUNT; ++i)
+	{
+		if(!_generationCalls[i])
+			continue;
+		double s = _generationSeconds[i];
+		if( (_minSeconds[i] < 0.0) || (s < _minSeconds[i]) )
+			_minSeconds[i] = s;
+		if(s > _maxSeconds[i])
+			_maxSeconds[i] = s;
+		++_phaseHistogram[i][_bucket(s * 1e6)];
+		_generationSeconds[i] = 0.0;
+		_generationCalls[i] = 0;
+	}
+	for(i = 0; i < GA2_COUNTER_COUNT; ++i)
+	{
+		++_counterHistogram[i][_bucket(_generationCounts[i])];
+		_generationCounts[i] = 0;
+	}
+	++_generations;
+}
+
+const char *ga2Profiler::getPhaseName(int phase)
+{
+	return ((phase >= 0) && (phase < GA2_PHASE_COUNT)) ? ga2PhaseNames[phase] : "";
+}
+
+const char *ga2Profiler::getCounterName(int counter)
+{
+	return ((counter >= 0) && (counter < GA2_COUNTER_COUNT)) ? ga2CounterNames[counter] : "";
+}
+
+/**
+ * Writes one line per phase,
+ * <tt>P,name,calls,seconds,min,max,histogram...</tt>, one per counter,
+ * <tt>C,name,total,histogram...</tt>, and finally
+ * <tt>G,generations</tt>. Times are in seconds; the histograms have
+ * GA2_PROFILE_BUCKETS entries each.
+ */
+std::ostream& operator<< ( std::ostream &o, ga2Profiler &prof )
+{
+	int i, b;
+	for(i = 0; i < GA2_PHASE_COUNT; ++i)
+	{
+		o << "P," << ga2Profiler::getPhaseName(i) << "," << prof.getCalls(i) << ","
+		  << prof.getSeconds(i) << "," << prof.getMinSeconds(i) << "," << prof.getMaxSeconds(i);
+		for(b = 0; b < GA2_PROFILE_BUCKETS; ++b)
+			o << "," << prof._phaseHistogram[i][b];
+		o << "\n";
+	}
+	for(i = 0; i < GA2_COUNTER_COUNT; ++i)
+	{
+		o << "C," << ga2Profiler::getCounterName(i) << "," << prof.getCount(i);
+		for(b = 0; b < GA2_PROFILE_BUCKETS; ++b)
+			o << "," << prof._counterHistogram[i][b];
+		o << "\n";
+	}
+	o << "G," << prof.getGenerations() << "\n";
+	return o;
+}
@@ -0,0 +1,170 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Profiler.h: interface for the ga2Profiler class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2PROFILER_H__
+#define __GA2PROFILER_H__
+
+#include <iostream>
+#include <chrono>
+#include "ga2Tracer.h"
+
+#define GA2_PHASE_INIT 0
+#define GA2_PHASE_SELECT 1
+#define GA2_PHASE_CROSSOVER 2
+#define GA2_PHASE_MUTATE 3
+#define GA2_PHASE_EVALUATE 4
+#define GA2_PHASE_REPLACE 5
+#define GA2_PHASE_LOCALSEARCH 6
+#define GA2_PHASE_COUNT 7
+
+#define GA2_COUNTER_EVALUATIONS 0
+#define GA2_COUNTER_CACHEHITS 1
+#define GA2_COUNTER_ALLOCATIONS 2
+#define GA2_COUNTER_CROSSOVERS 3
+#define GA2_COUNTER_MUTATIONS 4
+#define GA2_COUNTER_COUNT 5
+
+//histogram buckets are powers of two: bucket 0 holds everything under two
+//units, bucket i everything from 2^i up to 2^(i+1), the last everything else
+#define GA2_PROFILE_BUCKETS 32
+
+///Records where a population spends its time.
+/**
+ * The ga2Profiler class collects wall time and call counts for each phase
+ * of a generation (GA2_PHASE_INIT, GA2_PHASE_SELECT, GA2_PHASE_CROSSOVER,
+ * GA2_PHASE_MUTATE, GA2_PHASE_LOCALSEARCH, GA2_PHASE_EVALUATE and
+ * GA2_PHASE_REPLACE), along with
+ * running totals of evaluations, fitness cache hits, chromosome
+ * allocations, crossovers and mutations (GA2_COUNTER_EVALUATIONS and
+ * friends). Hand one to ga2Population::setProfiler().
+ *
+ * Besides the totals, every generation's time in each phase and its count
+ * of each counter are added to a histogram with power of two buckets, in
+ * microseconds for phases, so that the occasional slow generation shows up
+ * rather than disappearing into an average. A generation ends with each
+ * ga2Population::step() (and with ga2Population::init()).
+ *
+ * Phases can nest: ga2Population::init() and ga2Population::replace()
+ * evaluate chromosomes, and that time counts towards both. When a
+ * population has no profiler, all it costs is a test of a NULL pointer per
+ * phase.
+ *
+ * A profiler must only be used from one thread at a time, though it
+ * counts work done by a population's scheduler (see ga2Scheduler).
+ * Allocations are counted across the whole process.
+ */
+class ga2Profiler
+{
+	long _calls[GA2_PHASE_COUNT];
+	double _seconds[GA2_PHASE_COUNT];
+	double _minSeconds[GA2_PHASE_COUNT]; //per generation
+	double _maxSeconds[GA2_PHASE_COUNT];
+	double _generationSeconds[GA2_PHASE_COUNT];
+	long _generationCalls[GA2_PHASE_COUNT];
+	long _phaseHistogram[GA2_PHASE_COUNT][GA2_PROFILE_BUCKETS];
+	long _counts[GA2_COUNTER_COUNT];
+	long _generationCounts[GA2_COUNTER_COUNT];
+	long _counterHistogram[GA2_COUNTER_COUNT][GA2_PROFILE_BUCKETS];
+	long _generations;
+	long _allocations; //process wide count at the start of the generation
+
+	static int _bucket(double value);
+
+public:
+	///The constructor.
+	ga2Profiler();
+	///The destructor.
+	virtual ~ga2Profiler();
+	///Clear every total and histogram.
+	void reset(void);
+	///Add the time taken by one call of a phase.
+	void addTime(int phase, double seconds);
+	///Add to a counter.
+	void count(int counter, long n) {_counts[counter] += n; _generationCounts[counter] += n;};
+	///Close the current generation, adding it to the histograms.
+	void endGeneration(void);
+	///Return the number of generations closed.
+	long getGenerations(void) {return _generations;};
+	///Return the number of times a phase has run.
+	long getCalls(int phase) {return _calls[phase];};
+	///Return the total time spent in a phase, in seconds.
+	double getSeconds(int phase) {return _seconds[phase];};
+	///Return the least time a phase has taken in one generation, in seconds.
+	double getMinSeconds(int phase) {return _minSeconds[phase] < 0.0 ? 0.0 : _minSeconds[phase];};
+	///Return the most time a phase has taken in one generation, in seconds.
+	double getMaxSeconds(int phase) {return _maxSeconds[phase];};
+	///Return the total of a counter.
+	long getCount(int counter) {return _counts[counter];};
+	///Return the number of generations in which a phase took a given time.
+	/**
+	 * \param phase One of the GA2_PHASE_ constants.
+	 * \param bucket 0 for generations in which the phase took under 2us, i
+	 * for those in which it took from 2^i us up to 2^(i+1) us.
+	 */
+	long getPhaseHistogram(int phase, int bucket) {return _phaseHistogram[phase][bucket];};
+	///Return the number of generations in which a counter grew by a given amount.
+	/**
+	 * \param counter One of the GA2_COUNTER_ constants.
+	 * \param bucket As for ga2Profiler::getPhaseHistogram(), in counts.
+	 */
+	long getCounterHistogram(int counter, int bucket) {return _counterHistogram[counter][bucket];};
+	///Return the name of a phase.
+	static const char *getPhaseName(int phase);
+	///Return the name of a counter.
+	static const char *getCounterName(int counter);
+	///Write a report of everything recorded, as CSV.
+	friend std::ostream& operator<< (std::ostream &o, ga2Profiler &prof);
+};
+
+///Times a phase for as long as it is in scope.
+/**
+ * Adds the time to a profiler and records it as a span, named after the
+ * phase, in a tracer (see ga2Tracer). Does nothing at all if both are NULL.
+ */
+class ga2ProfileScope
+{
+	ga2Profiler *_profiler;
+	ga2Tracer *_tracer;
+	int _phase;
+	std::chrono::steady_clock::time_point _start;
+	int64_t _traceStart;
+public:
+	ga2ProfileScope(ga2Profiler *profiler, int phase, ga2Tracer *tracer = NULL)
+		: _profiler(profiler), _tracer(tracer), _phase(phase), _traceStart(0)
+	{
+		if(_profiler)
+			_start = std::chrono::steady_clock::now();
+		if(_tracer)
+			_traceStart = _tracer->now();
+	};
+	~ga2ProfileScope() {end();};
+	///Stop timing before going out of scope.
+	void end(void)
+	{
+		if(_profiler)
+			_profiler->addTime(_phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count());
+		if(_tracer)
+			_tracer->span(ga2Profiler::getPhaseName(_phase), "phase", _traceStart, _tracer->now());
+		_profiler = NULL;
+		_tracer = NULL;
+	};
+};
+
+#endif
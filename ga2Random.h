@@ -0,0 +1,77 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Random.h: a small random number generator that, unlike rand(), can
+//              be given to each thread or each run separately.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2RANDOM_H__
+#define __GA2RANDOM_H__
+
+#include <math.h>
+#include <stdint.h>
+
+///A self-contained random number generator.
+/**
+ * An xorshift64* generator: eight bytes of state, no locking, and plenty
+ * good enough for a GA. Code that runs on several threads keeps one of
+ * these per thread (or per grid stripe, or per run) instead of sharing the
+ * global rand() state, which also makes the results independent of how
+ * the work happens to be scheduled.
+ */
+class ga2Random
+{
+	uint64_t _state;
+public:
+	///The constructor.
+	ga2Random(uint64_t seed = 1) {setSeed(seed);};
+	///Restart the sequence from a seed. Any seed, including 0, is fine.
+	void setSeed(uint64_t seed)
+	{
+		//splitmix64 scramble, so nearby seeds give unrelated streams
+		uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		_state = z ^ (z >> 31);
+		if(!_state)
+			_state = 0x9E3779B97F4A7C15ULL;
+	};
+	///Return 64 random bits.
+	uint64_t next(void)
+	{
+		_state ^= _state >> 12;
+		_state ^= _state << 25;
+		_state ^= _state >> 27;
+		return _state * 0x2545F4914F6CDD1DULL;
+	};
+	///Return a double uniformly distributed over [0, 1).
+	double uniform(void) {return (next() >> 11) * (1.0/9007199254740992.0);};
+	///Return an integer uniformly distributed over [0, n).
+	int below(int n) {return (int)(uniform() * n);};
+	///Return a normally distributed double, with mean 0 and variance 1.
+	/**
+	 * Box-Muller; the second value of each pair is thrown away rather
+	 * than kept as extra state.
+	 */
+	double gaussian(void)
+	{
+		double u = 1.0 - uniform(); //(0, 1], so the log is finite
+		return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * uniform());
+	};
+};
+
+#endif
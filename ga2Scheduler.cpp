@@ -0,0 +1,328 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Scheduler.cpp: implementation of the ga2Scheduler class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <stdio.h>
+#include "ga2Scheduler.h"
+#include "ga2Tracer.h"
+
+struct ga2Job
+{
+	ga2Task *task;
+	std::atomic<int> remaining;
+};
+
+static double ga2Now(void)
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * \param numWorkers Number of worker threads to start. If zero or less,
+ * one worker is started per hardware thread.
+ *
+ * Starts the worker threads. They sleep until work is submitted.
+ */
+ga2Scheduler::ga2Scheduler( int numWorkers ) : _numWorkers(numWorkers)
+{
+	if(_numWorkers <= 0)
+		_numWorkers = std::thread::hardware_concurrency();
+	if(_numWorkers <= 0)
+		_numWorkers = 1;
+	_targetChunkTime = 0.0005;
+	_shutdown = false;
+	_unclaimed = 0;
+	_tracer = NULL;
+
+	int i;
+	for(i = 0; i < _numWorkers; ++i)
+	{
+		_Worker *w = new _Worker;
+		w->busyTime = w->idleTime = 0.0;
+		w->secondsPerItem = 0.0;
+		w->items = w->chunks = w->steals = 0;
+		_workers.push_back(w);
+	}
+	for(i = 0; i < _numWorkers; ++i)
+		_workers[i]->thread = std::thread(&ga2Scheduler::_workerLoop, this, i);
+}
+
+/**
+ * Lets the workers drain whatever is still queued, then joins them.
+ */
+ga2Scheduler::~ga2Scheduler()
+{
+	{
+		std::lock_guard<std::mutex> l(_sleepLock);
+		_shutdown = true;
+	}
+	_wake.notify_all();
+	int i;
+	//join everyone before freeing anything; idle workers still peek at
+	//each other's deques on their way out
+	for(i = 0; i < _numWorkers; ++i)
+		_workers[i]->thread.join();
+	for(i = 0; i < _numWorkers; ++i)
+		delete _workers[i];
+	_workers.clear();
+}
+
+/**
+ * \param task The work to perform.
+ * \param count Number of items; task.run() will be called on sub-ranges of
+ * [0, count).
+ *
+ * Splits the batch evenly over the worker deques and wakes the workers. The
+ * calling thread is free to do something else until it calls
+ * ga2Scheduler::wait() with the returned handle. Every handle must be
+ * passed to wait() exactly once, and the task must outlive it.
+ */
+ga2Job *ga2Scheduler::submit(ga2Task &task, int count)
+{
+	ga2Job *job = new ga2Job;
+	job->task = &task;
+	job->remaining = count > 0 ? count : 0;
+	if(count <= 0)
+		return job;
+
+	int i;
+	for(i = 0; i < _numWorkers; ++i)
+	{
+		_Range r;
+		r.job = job;
+		r.begin = (int)((long)count * i / _numWorkers);
+		r.end = (int)((long)count * (i+1) / _numWorkers);
+		if(r.end == r.begin)
+			continue;
+		std::lock_guard<std::mutex> l(_workers[i]->lock);
+		_workers[i]->ranges.push_back(r);
+	}
+	{
+		std::lock_guard<std::mutex> l(_sleepLock);
+		_unclaimed += count;
+	}
+	_wake.notify_all();
+	return job;
+}
+
+/**
+ * \param job A handle returned by ga2Scheduler::submit().
+ *
+ * Blocks until every item of the batch has been run, then frees the handle.
+ */
+void ga2Scheduler::wait(ga2Job *job)
+{
+	ga2TraceScope traced(_tracer, "wait", "scheduler");
+	{
+		std::unique_lock<std::mutex> l(_doneLock);
+		while(job->remaining > 0)
+			_done.wait(l);
+	}
+	delete job;
+}
+
+void ga2Scheduler::_finish(ga2Job *job, int count)
+{
+	if(job->remaining.fetch_sub(count) == count)
+	{
+		std::lock_guard<std::mutex> l(_doneLock);
+		_done.notify_all();
+	}
+}
+
+//takes a chunk off the front of the newest range in our own deque. the
+//chunk is an eighth of what is left, but never less than the grain, which
+//is however many items fit in _targetChunkTime at the measured cost.
+bool ga2Scheduler::_claim(int self, _Range &chunk)
+{
+	_Worker *w = _workers[self];
+	std::lock_guard<std::mutex> l(w->lock);
+	if(w->ranges.empty())
+		return false;
+
+	_Range &r = w->ranges.back();
+	int n = r.end - r.begin;
+	int grain = 1;
+	if(w->secondsPerItem > 0.0)
+	{
+		double g = _targetChunkTime / w->secondsPerItem;
+		grain = g > n ? n : (g < 1.0 ? 1 : (int)g);
+	}
+	int k = n / 8;
+	if(k < grain)
+		k = grain;
+	if(k > n)
+		k = n;
+
+	chunk.job = r.job;
+	chunk.begin = r.begin;
+	chunk.end = r.begin + k;
+	r.begin += k;
+	if(r.begin == r.end)
+		w->ranges.pop_back();
+	_unclaimed -= k;
+	return true;
+}
+
+//moves the upper half of some other worker's oldest range into our deque.
+bool ga2Scheduler::_steal(int self)
+{
+	int i;
+	for(i = 1; i < _numWorkers; ++i)
+	{
+		_Worker *victim = _workers[(self + i) % _numWorkers];
+		_Range stolen;
+		{
+			std::lock_guard<std::mutex> l(victim->lock);
+			if(victim->ranges.empty())
+				continue;
+			_Range &r = victim->ranges.front();
+			int half = (r.end - r.begin + 1) / 2;
+			stolen.job = r.job;
+			stolen.begin = r.end - half;
+			stolen.end = r.end;
+			r.end -= half;
+			if(r.begin == r.end)
+				victim->ranges.pop_front();
+		}
+		_Worker *w = _workers[self];
+		std::lock_guard<std::mutex> l(w->lock);
+		w->ranges.push_back(stolen);
+		++w->steals;
+		ga2Tracer *tracer = _tracer;
+		if(tracer)
+			tracer->instant("steal", "scheduler", "items", stolen.end - stolen.begin);
+		return true;
+	}
+	return false;
+}
+
+void ga2Scheduler::_workerLoop(int self)
+{
+	_Worker *w = _workers[self];
+	double mark = ga2Now();
+	ga2Tracer *named = NULL;
+	char name[32];
+	snprintf(name, sizeof(name), "worker %d", self);
+	while(true)
+	{
+		_Range chunk;
+		if(_claim(self, chunk) || (_steal(self) && _claim(self, chunk)))
+		{
+			int n = chunk.end - chunk.begin;
+			ga2Tracer *tracer = _tracer;
+			if(tracer && (tracer != named))
+			{
+				tracer->setThreadName(name);
+				named = tracer;
+			}
+			ga2TraceScope traced(tracer, "evaluate", "scheduler", "items", n);
+			double start = ga2Now();
+			chunk.job->task->run(chunk.begin, chunk.end);
+			double stop = ga2Now();
+			traced.end();
+			{
+				std::lock_guard<std::mutex> l(w->lock);
+				w->idleTime += start - mark;
+				w->busyTime += stop - start;
+				w->items += n;
+				++w->chunks;
+				//exponentially weighted, so the grain follows the workload
+				double perItem = (stop - start) / n;
+				if(w->secondsPerItem == 0.0)
+					w->secondsPerItem = perItem;
+				else
+					w->secondsPerItem = 0.75*w->secondsPerItem + 0.25*perItem;
+			}
+			_finish(chunk.job, n);
+			mark = stop;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> l(_sleepLock);
+		if(_unclaimed > 0)
+			continue; //someone beat us to it, but there is more
+		if(_shutdown)
+			break;
+		_wake.wait(l);
+	}
+}
+
+/**
+ * \param worker Index of the worker, from 0 to getNumWorkers()-1.
+ *
+ * Time spent inside ga2Task::run() since the last resetStats().
+ */
+double ga2Scheduler::getBusyTime(int worker)
+{
+	std::lock_guard<std::mutex> l(_workers[worker]->lock);
+	return _workers[worker]->busyTime;
+}
+
+/**
+ * \param worker Index of the worker, from 0 to getNumWorkers()-1.
+ *
+ * Time spent between tasks since the last resetStats(): looking for work,
+ * stealing, or asleep. Comparing this across workers shows how well a
+ * generation was balanced.
+ */
+double ga2Scheduler::getIdleTime(int worker)
+{
+	std::lock_guard<std::mutex> l(_workers[worker]->lock);
+	return _workers[worker]->idleTime;
+}
+
+long ga2Scheduler::getItemCount(int worker)
+{
+	std::lock_guard<std::mutex> l(_workers[worker]->lock);
+	return _workers[worker]->items;
+}
+
+long ga2Scheduler::getChunkCount(int worker)
+{
+	std::lock_guard<std::mutex> l(_workers[worker]->lock);
+	return _workers[worker]->chunks;
+}
+
+long ga2Scheduler::getStealCount(int worker)
+{
+	std::lock_guard<std::mutex> l(_workers[worker]->lock);
+	return _workers[worker]->steals;
+}
+
+/**
+ * Zeroes the busy and idle times and the counters of every worker. The
+ * learned cost per item is kept.
+ */
+void ga2Scheduler::resetStats(void)
+{
+	int i;
+	for(i = 0; i < _numWorkers; ++i)
+	{
+		std::lock_guard<std::mutex> l(_workers[i]->lock);
+		_workers[i]->busyTime = _workers[i]->idleTime = 0.0;
+		_workers[i]->items = _workers[i]->chunks = _workers[i]->steals = 0;
+	}
+}
@@ -0,0 +1,145 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Scheduler.h: interface for the ga2Scheduler class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2SCHEDULER_H__
+#define __GA2SCHEDULER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///A unit of parallel work.
+/**
+ * Derive from ga2Task and implement run() to hand work to a
+ * ga2Scheduler. run() is called with half-open index ranges [begin, end)
+ * that together cover [0, count) exactly once; it may be called from any
+ * worker thread, so it must not touch shared state without protection.
+ */
+class ga2Task
+{
+public:
+	///The destructor
+	virtual ~ga2Task() {};
+	///Process the items in [begin, end).
+	virtual void run(int begin, int end) = 0;
+};
+
+///Opaque handle to a batch submitted with ga2Scheduler::submit().
+struct ga2Job;
+
+class ga2Tracer;
+
+///A work-stealing thread pool for evaluating chromosomes.
+/**
+ * Each worker owns a deque of index ranges. A batch is split evenly across
+ * the deques when it is submitted; a worker then carves chunks off its own
+ * ranges, and when it runs dry it steals half of another worker's oldest
+ * range. Chunk sizes shrink as a range empties and are floored at a grain
+ * size learned from how long recent items took, so cheap fitness functions
+ * are not drowned in scheduling overhead and expensive ones still balance
+ * at the end of a generation.
+ */
+class ga2Scheduler
+{
+	struct _Range
+	{
+		ga2Job *job;
+		int begin;
+		int end;
+	};
+	struct _Worker
+	{
+		std::mutex lock;
+		std::deque<_Range> ranges;
+		std::thread thread;
+		double busyTime;
+		double idleTime;
+		double secondsPerItem;
+		long items;
+		long chunks;
+		long steals;
+	};
+
+	int _numWorkers;
+	std::vector<_Worker *> _workers;
+	double _targetChunkTime;
+	bool _shutdown;
+	std::atomic<long> _unclaimed;
+	std::mutex _sleepLock;
+	std::condition_variable _wake;
+	std::mutex _doneLock;
+	std::condition_variable _done;
+	std::atomic<ga2Tracer *> _tracer;
+
+	void _workerLoop(int self);
+	bool _claim(int self, _Range &chunk);
+	bool _steal(int self);
+	void _finish(ga2Job *job, int count);
+
+public:
+	///The constructor. Zero or fewer workers means one per hardware thread.
+	ga2Scheduler( int numWorkers );
+	///The destructor. Waits for queued work, then joins the workers.
+	virtual ~ga2Scheduler();
+	///Queue a batch of count items and return immediately.
+	ga2Job *submit(ga2Task &task, int count);
+	///Block until a submitted batch has completed, then release it.
+	void wait(ga2Job *job);
+	///Run a batch of count items and block until it completes.
+	void parallelFor(ga2Task &task, int count) {wait(submit(task, count));};
+	///Return the number of worker threads.
+	int getNumWorkers(void) {return _numWorkers;};
+	///Set the wall time, in seconds, a chunk should take at minimum.
+	/**
+	 * \param seconds Desired minimum duration of a chunk.
+	 *
+	 * Used to derive the grain size from the measured cost per item.
+	 * Default is half a millisecond.
+	 */
+	void setTargetChunkTime(double seconds) {_targetChunkTime = seconds;};
+	///Return the seconds a worker has spent running tasks.
+	double getBusyTime(int worker);
+	///Return the seconds a worker has spent waiting for work.
+	double getIdleTime(int worker);
+	///Return the number of items a worker has processed.
+	long getItemCount(int worker);
+	///Return the number of chunks a worker has run.
+	long getChunkCount(int worker);
+	///Return the number of successful steals made by a worker.
+	long getStealCount(int worker);
+	///Zero all per-worker timing and counters.
+	void resetStats(void);
+	///Set a tracer to record every chunk and steal in.
+	/**
+	 * \param tracer an open ga2Tracer, or NULL to stop tracing (the
+	 * default).
+	 *
+	 * Each worker gets a track of its own, named "worker n", on which
+	 * every chunk it runs is an "evaluate" span and every steal an instant;
+	 * ga2Scheduler::wait() is recorded as a "wait" span on the calling
+	 * thread. The scheduler does not take ownership.
+	 */
+	void setTracer(ga2Tracer *tracer) {_tracer = tracer;};
+};
+
+#endif
@@ -0,0 +1,280 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2SpatialIndex.cpp: implementation of the ga2SpatialIndex class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <math.h>
+#include "ga2.h"
+
+//pairs a cell key with a point, for sorting the points into cells
+struct ga2SpatialEntry
+{
+	uint64_t key;
+	int point;
+	bool operator<(const ga2SpatialEntry &b) const {return key < b.key;};
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+ga2SpatialIndex::ga2SpatialIndex()
+{
+	_length = 0;
+	_dims = 0;
+	_radius = 0.0;
+	_cell = 1.0;
+	_cellsPerDim = 1;
+	_lo = NULL;
+	_comparisons = 0;
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2SpatialIndex::~ga2SpatialIndex()
+{
+}
+
+//the grid cell a point falls in, along each indexed gene
+void ga2SpatialIndex::_cellOf(const ga2Gene *p, int64_t *cell)
+{
+	int d;
+	for(d = 0; d < _dims; ++d)
+	{
+		int g = _dim[d];
+		int64_t c = (int64_t)floor((p[g] - _lo[g]) * _scale[g] / _cell);
+		c = c < 0 ? 0 : c;
+		cell[d] = c < (int64_t)_cellsPerDim ? c : (int64_t)_cellsPerDim - 1;
+	}
+}
+
+uint64_t ga2SpatialIndex::_key(const int64_t *cell)
+{
+	uint64_t key = 0;
+	int d;
+	for(d = 0; d < _dims; ++d)
+		key = key * _cellsPerDim + (uint64_t)cell[d];
+	return key;
+}
+
+/**
+ * \param points The genes of each point; see the class notes.
+ * \param length The number of genes in each.
+ * \param lo The lower bound of each gene.
+ * \param hi The upper bound of each gene; must stay valid along with lo.
+ * \param radius The neighbourhood radius for queries, in scaled units.
+ *
+ * Chooses the genes to grid by their spread over these points, and sorts
+ * the points into cells. Takes O(N log N + N length) time. Returns false
+ * if the radius is not positive.
+ */
+bool ga2SpatialIndex::build(const std::vector<const ga2Gene *> &points, int length,
+							const float *lo, const float *hi, double radius)
+{
+	_points = points;
+	_keys.clear();
+	_order.clear();
+	_comparisons = 0;
+	if(radius <= 0.0)
+		return false;
+	_length = length;
+	_lo = lo;
+	_radius = radius;
+	int n = _points.size(), i, g;
+	_scale.resize(length);
+	for(g = 0; g < length; ++g)
+		_scale[g] = hi[g] > lo[g] ? 1.0 / (hi[g] - lo[g]) : 0.0;
+
+	//grid the most spread out genes, as they split the points up best
+	std::vector<double> spread(length, 0.0);
+	if(n)
+		for(g = 0; g < length; ++g)
+		{
+			double sum = 0.0, sumSq = 0.0;
+			for(i = 0; i < n; ++i)
+			{
+				double x = (_points[i][g] - lo[g]) * _scale[g];
+				sum += x;
+				sumSq += x * x;
+			}
+			spread[g] = sumSq / n - (sum / n) * (sum / n);
+		}
+	std::vector<int> genes(length);
+	for(g = 0; g < length; ++g)
+		genes[g] = g;
+	int most = length < GA2_SPATIAL_DIMS ? length : GA2_SPATIAL_DIMS;
+	for(i = 0; i < most; ++i) //a partial selection sort; most is tiny
+	{
+		int best = i;
+		for(g = i + 1; g < length; ++g)
+			if(spread[genes[g]] > spread[genes[best]])
+				best = g;
+		std::swap(genes[i], genes[best]);
+		_dim[i] = genes[i];
+	}
+
+	//cells at least a radius wide, and few enough per gene for the keys
+	//to fit in 64 bits
+	_cell = radius;
+	double least = 1.0 / (1 << 20);
+	_cell = _cell > least ? _cell : least;
+	_cellsPerDim = (uint64_t)(1.0 / _cell) + 1;
+
+	//grid as many of those genes as makes queries cheapest. Each one more
+	//triples the cells a query looks in, and cuts the points it measures
+	//to those within three cells along that gene: roughly three cells over
+	//the width of the points' spread, were they spread evenly.
+	double cells = 1.0, share = 1.0, cheapest = n;
+	_dims = 0;
+	for(i = 0; i < most; ++i)
+	{
+		cells *= _cellsPerDim;
+		if(cells > 9e18)
+			break;
+		double width = sqrt(12.0 * spread[_dim[i]]);
+		share *= width > 3.0 * _cell ? 3.0 * _cell / width : 1.0;
+		double cost = pow(3.0, i + 1) * log(n + 2.0) / log(2.0) + n * share;
+		if(cost < cheapest)
+		{
+			cheapest = cost;
+			_dims = i + 1;
+		}
+	}
+
+	std::vector<ga2SpatialEntry> entries(n);
+	int64_t cell[GA2_SPATIAL_DIMS];
+	for(i = 0; i < n; ++i)
+	{
+		_cellOf(_points[i], cell);
+		entries[i].key = _key(cell);
+		entries[i].point = i;
+	}
+	std::sort(entries.begin(), entries.end());
+	_keys.resize(n);
+	_order.resize(n);
+	for(i = 0; i < n; ++i)
+	{
+		_keys[i] = entries[i].key;
+		_order[i] = entries[i].point;
+	}
+	return true;
+}
+
+/**
+ * \param i The point to search around.
+ * \param neighbours Filled with every other point within the radius.
+ * \param distances If not NULL, filled with their distances.
+ *
+ * Looks in the cells next to the point's own along the gridded genes,
+ * three for each, and measures the full distance only to the points in
+ * those. Returns the number of neighbours found.
+ */
+int ga2SpatialIndex::query(int i, std::vector<int> &neighbours, std::vector<double> *distances)
+{
+	neighbours.clear();
+	if(distances)
+		distances->clear();
+	if( (i < 0) || (i >= _points.size()) || _keys.empty() )
+		return 0;
+	int64_t centre[GA2_SPATIAL_DIMS], cell[GA2_SPATIAL_DIMS];
+	_cellOf(_points[i], centre);
+	int offsets = 1, d, o;
+	//with no genes gridded, the one cell holds everything
+	for(d = 0; d < _dims; ++d)
+		offsets *= 3;
+	double r2 = _radius * _radius;
+	const ga2Gene *p = _points[i];
+	for(o = 0; o < offsets; ++o)
+	{
+		int rest = o;
+		bool inside = true;
+		for(d = 0; d < _dims; ++d)
+		{
+			cell[d] = centre[d] + (rest % 3) - 1;
+			rest /= 3;
+			inside = inside && (cell[d] >= 0) && (cell[d] < (int64_t)_cellsPerDim);
+		}
+		if(!inside)
+			continue;
+		uint64_t key = _key(cell);
+		std::vector<uint64_t>::iterator first = std::lower_bound(_keys.begin(), _keys.end(), key);
+		int k;
+		for(k = first - _keys.begin(); (k < _keys.size()) && (_keys[k] == key); ++k)
+		{
+			int j = _order[k];
+			if(j == i)
+				continue;
+			const ga2Gene *q = _points[j];
+			double sum = 0.0;
+			int g;
+			for(g = 0; g < _length; ++g)
+			{
+				double x = (p[g] - q[g]) * _scale[g];
+				sum += x * x;
+			}
+			++_comparisons;
+			if(sum > r2)
+				continue;
+			neighbours.push_back(j);
+			if(distances)
+				distances->push_back(sqrt(sum));
+		}
+	}
+	return neighbours.size();
+}
+
+/**
+ * \param i One point.
+ * \param j The other.
+ */
+double ga2SpatialIndex::distance(int i, int j)
+{
+	double sum = 0.0;
+	int g;
+	for(g = 0; g < _length; ++g)
+	{
+		double x = (_points[i][g] - _points[j][g]) * _scale[g];
+		sum += x * x;
+	}
+	return sqrt(sum);
+}
+
+/**
+ * \param a One genome.
+ * \param b The other.
+ * \param length The number of genes in each.
+ * \param lo The lower bound of each gene.
+ * \param hi The upper bound of each gene.
+ *
+ * The distance the index measures, for genomes that have not been indexed.
+ */
+double ga2SpatialIndex::distance(const ga2Gene *a, const ga2Gene *b, int length,
+								 const float *lo, const float *hi)
+{
+	double sum = 0.0;
+	int g;
+	for(g = 0; g < length; ++g)
+	{
+		double range = hi[g] - lo[g];
+		double x = range > 0.0 ? (a[g] - b[g]) / range : 0.0;
+		sum += x * x;
+	}
+	return sqrt(sum);
+}
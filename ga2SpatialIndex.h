@@ -0,0 +1,98 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2SpatialIndex.h: interface for the ga2SpatialIndex class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2SPATIALINDEX_H__
+#define __GA2SPATIALINDEX_H__
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "ga2Gene.h"
+
+//most genes ga2SpatialIndex grids over; a query looks at up to 3 to this
+//power cells
+#define GA2_SPATIAL_DIMS 6
+
+///Finds the chromosomes near a chromosome without measuring every pair.
+/**
+ * The ga2SpatialIndex class answers "which of these points lie within
+ * radius r of point i?" for a set of genomes, as needed by fitness sharing
+ * and clearing (see ga2Population::setNiching()). Comparing every pair
+ * costs N^2 distances; the index costs a sort to build, and a query looks
+ * at only the points in nearby grid cells.
+ *
+ * Distances are Euclidean, with each gene scaled so its range spans 0 to
+ * 1, so one radius does for genes of any range. The grid is over the genes
+ * along which the points are most spread out, with cells one radius wide;
+ * any point within the radius is in the same or a neighbouring cell along
+ * those genes, so the answers are exact. Each gene gridded triples the
+ * cells a query visits but thins out the points in them, so the index
+ * grids as many, up to GA2_SPATIAL_DIMS, as it estimates makes queries
+ * cheapest for the points' spread and number. The cells are stored sorted
+ * by key, and found by binary search, so only occupied cells take any
+ * space however small the radius.
+ *
+ * A query costs in proportion to the points within a cell or so of the
+ * one asked about, rather than to all of them; when the radius is small
+ * next to the spread of the population, that is a small fraction.
+ *
+ * The index holds pointers to the genes, so they must not move or change
+ * between ga2SpatialIndex::build() and the last query.
+ */
+class ga2SpatialIndex
+{
+	int _length;
+	int _dims;
+	int _dim[GA2_SPATIAL_DIMS]; //genes the grid is over
+	double _radius;
+	double _cell;
+	uint64_t _cellsPerDim;
+	const float *_lo;
+	std::vector<double> _scale; //1 / range, per gene
+	std::vector<const ga2Gene *> _points;
+	std::vector<uint64_t> _keys; //of the occupied cells, sorted
+	std::vector<int> _order; //the point with each key
+	long _comparisons;
+
+	void _cellOf(const ga2Gene *p, int64_t *cell);
+	uint64_t _key(const int64_t *cell);
+
+public:
+	///The constructor.
+	ga2SpatialIndex();
+	///The destructor.
+	virtual ~ga2SpatialIndex();
+	///Index a set of points.
+	bool build(const std::vector<const ga2Gene *> &points, int length,
+			   const float *lo, const float *hi, double radius);
+	///Find the points within the radius of a point.
+	int query(int i, std::vector<int> &neighbours, std::vector<double> *distances = NULL);
+	///Return the scaled distance between two indexed points.
+	double distance(int i, int j);
+	///Return the scaled distance between two genomes.
+	static double distance(const ga2Gene *a, const ga2Gene *b, int length,
+						   const float *lo, const float *hi);
+	///Return the number of points indexed.
+	int getSize(void) {return _points.size();};
+	///Return the number of distances measured by queries since the index was built.
+	long getComparisons(void) {return _comparisons;};
+};
+
+#endif
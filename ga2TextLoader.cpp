@@ -0,0 +1,287 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2TextLoader.cpp: implementation of the ga2TextLoader class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+#include "ga2.h"
+
+static inline bool ga2IsSpace(char c)
+{
+	return (c == ' ') || (c == '\n') || (c == '\t') || (c == '\r') || (c == '\v') || (c == '\f');
+}
+
+static inline void ga2Convert(const char *buf, float &value, char **end) {value = strtof(buf, end);}
+static inline void ga2Convert(const char *buf, double &value, char **end) {value = strtod(buf, end);}
+
+//parses the next whitespace separated number, and fails on anything that
+//is not entirely a number. The mapping is not NUL terminated, so the slow
+//path copies the token out first.
+template <class T>
+static bool ga2ParseNumber(const char *&p, const char *end, T &value)
+{
+	while( (p < end) && ga2IsSpace(*p) )
+		++p;
+	const char *tok = p;
+	while( (p < end) && !ga2IsSpace(*p) )
+		++p;
+	if(tok == p)
+		return false;
+#if defined(__cpp_lib_to_chars)
+	std::from_chars_result r = std::from_chars(tok, p, value);
+	if( (r.ec == std::errc()) && (r.ptr == p) )
+		return true;
+	//out of range values (denormals, mostly) fall through to strtod,
+	//which rounds them the way operator>> would
+#endif
+	char buf[64];
+	char *stop;
+	if(p - tok >= (long)sizeof(buf))
+		return false;
+	memcpy(buf, tok, p - tok);
+	buf[p - tok] = '\0';
+	ga2Convert(buf, value, &stop);
+	return stop == buf + (p - tok);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+ga2TextLoader::ga2TextLoader()
+{
+	_fd = -1;
+	_data = NULL;
+	_bytes = 0;
+	_body = NULL;
+	_declaredSize = 0;
+	_size = 0;
+	_chromoSize = 0;
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2TextLoader::~ga2TextLoader()
+{
+	close();
+}
+
+void ga2TextLoader::close(void)
+{
+	if(_data)
+		munmap((void *)_data, _bytes);
+	if(_fd >= 0)
+		::close(_fd);
+	_fd = -1;
+	_data = NULL;
+	_bytes = 0;
+	_body = NULL;
+}
+
+/**
+ * \param path A file written with operator<<(std::ostream&, ga2Population&)
+ *
+ * Maps the file and reads the sizes and ranges at its top. Returns false
+ * if the file cannot be mapped or its header cannot be read.
+ */
+bool ga2TextLoader::open(const char *path)
+{
+	close();
+	_fd = ::open(path, O_RDONLY);
+	if(_fd < 0)
+		return false;
+	struct stat st;
+	if( (fstat(_fd, &st) != 0) || (st.st_size == 0) )
+	{
+		close();
+		return false;
+	}
+	_bytes = st.st_size;
+	void *m = mmap(NULL, _bytes, PROT_READ, MAP_PRIVATE, _fd, 0);
+	if(m == MAP_FAILED)
+	{
+		_bytes = 0;
+		close();
+		return false;
+	}
+	_data = (const char *)m;
+	madvise(m, _bytes, MADV_SEQUENTIAL);
+
+	const char *p = _data, *end = _data + _bytes;
+	double size, chromoSize;
+	if( !ga2ParseNumber(p, end, size) || !ga2ParseNumber(p, end, chromoSize)
+	  ||(size < 0) || (chromoSize < 1) || (chromoSize > (double)_bytes) )
+	{
+		close();
+		return false;
+	}
+	_declaredSize = (int)size;
+	_chromoSize = (int)chromoSize;
+	_chromoMaxRanges.resize(_chromoSize);
+	_chromoMinRanges.resize(_chromoSize);
+	int i;
+	for(i = 0; i < _chromoSize; ++i)
+		if(!ga2ParseNumber(p, end, _chromoMaxRanges[i]))
+		{
+			close();
+			return false;
+		}
+	for(i = 0; i < _chromoSize; ++i)
+		if(!ga2ParseNumber(p, end, _chromoMinRanges[i]))
+		{
+			close();
+			return false;
+		}
+	_body = p;
+
+	//every number takes at least two bytes, so a damaged header cannot
+	//make us allocate more than the file could possibly hold
+	size_t most = (end - p) / (2 * ((size_t)_chromoSize + 1)) + 1;
+	if((size_t)_declaredSize > most)
+		_declaredSize = most;
+	return true;
+}
+
+//parses up to _declaredSize chromosomes; returns how many were complete.
+int ga2TextLoader::_parse(double *fitness, unsigned char *evaluated, ga2Gene *genes)
+{
+	const char *p = _body, *end = _data + _bytes;
+	int i, j;
+	for(i = 0; i < _declaredSize; ++i)
+	{
+		ga2Gene *g = genes + (size_t)i * _chromoSize;
+		if(!ga2ParseNumber(p, end, fitness[i]))
+			break;
+		evaluated[i] = fitness[i] != 0.0;
+		for(j = 0; j < _chromoSize; ++j)
+			if(!ga2ParseNumber(p, end, g[j]))
+				return i;
+	}
+	return i;
+}
+
+/**
+ * \param pop The population to fill
+ *
+ * Replaces the size, ranges and chromosomes of the population with those
+ * in the file, like operator>> but without its trouble with the number of
+ * chromosomes. The evaluation function is kept.
+ */
+bool ga2TextLoader::load(ga2Population &pop)
+{
+	if(!_data)
+		return false;
+	std::vector<double> fitness(_declaredSize);
+	std::vector<unsigned char> evaluated(_declaredSize);
+	std::vector<ga2Gene> genes((size_t)_declaredSize * _chromoSize);
+	_size = _parse(fitness.empty() ? NULL : &fitness[0], evaluated.empty() ? NULL : &evaluated[0],
+				   genes.empty() ? NULL : &genes[0]);
+
+	pop.flush();
+	pop._size = _size;
+	pop._chromoSize = _chromoSize;
+	pop._chromoMaxRanges = _chromoMaxRanges;
+	pop._chromoMinRanges = _chromoMinRanges;
+	pop._chromosomes.clear();
+	pop._nextGen.clear();
+	pop._chromosomes.reserve(2*_size);
+
+	//everything but the genes and fitness is the same for every
+	//chromosome, so it is set up once and copied
+	ga2Chromosome proto(_chromoSize);
+	proto.setMaxRanges(_chromoMaxRanges);
+	proto.setMinRanges(_chromoMinRanges);
+	proto.setEvalFunc(pop._evalFunc);
+	pop._chromosomes.resize(_size, proto);
+	int i;
+	for(i = 0; i < _size; ++i)
+	{
+		const ga2Gene *g = &genes[(size_t)i * _chromoSize];
+		ga2Chromosome &c = pop._chromosomes[i];
+		c.setGenes(std::vector<ga2Gene>(g, g + _chromoSize));
+		if(evaluated[i])
+			c.setFitness(fitness[i]);
+	}
+	pop._statsValid = false;
+	return true;
+}
+
+/**
+ * \param path The checkpoint file to write
+ * \param generation A generation number to store in it
+ *
+ * Parses the text straight into a mapped checkpoint file, without building
+ * a population in memory on the way, so it suits archives too large to
+ * load; the result can be opened with ga2MappedPopulation::open(). As with
+ * ga2Population::writeCheckpoint(), the file is written under a temporary
+ * name and renamed into place.
+ */
+bool ga2TextLoader::convert(const char *path, unsigned long generation)
+{
+	if(!_data)
+		return false;
+	std::string tmp = std::string(path) + ".tmp";
+	ga2Checkpoint ckpt;
+	if(!ckpt.create(tmp.c_str(), _declaredSize, _chromoSize))
+		return false;
+	_size = _parse(ckpt.getFitness(), ckpt.getEvaluated(), ckpt.getGeneMatrix());
+
+	//if the file was short, lay out a checkpoint of the right size and
+	//move everything over
+	std::string shortTmp = tmp + ".short";
+	ga2Checkpoint fixed;
+	ga2Checkpoint *out = &ckpt;
+	if(_size < _declaredSize)
+	{
+		if(!fixed.create(shortTmp.c_str(), _size, _chromoSize))
+			return false;
+		memcpy(fixed.getFitness(), ckpt.getFitness(), _size * sizeof(double));
+		memcpy(fixed.getEvaluated(), ckpt.getEvaluated(), _size);
+		memcpy(fixed.getGeneMatrix(), ckpt.getGeneMatrix(), (size_t)_size * _chromoSize * sizeof(ga2Gene));
+		ckpt.close();
+		unlink(tmp.c_str());
+		out = &fixed;
+	}
+
+	int i;
+	for(i = 0; i < _chromoSize; ++i)
+	{
+		out->getMinRanges()[i] = _chromoMinRanges[i];
+		out->getMaxRanges()[i] = _chromoMaxRanges[i];
+	}
+	double *fit = out->getFitness();
+	for(i = 0; i < _size; ++i)
+		if(!out->getEvaluated()[i])
+			fit[i] = 0.0;
+	out->setGeneration(generation);
+	if(!out->sync())
+		return false;
+	out->close();
+	return rename(out == &fixed ? shortTmp.c_str() : tmp.c_str(), path) == 0;
+}
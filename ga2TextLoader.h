@@ -0,0 +1,81 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2TextLoader.h: interface for the ga2TextLoader class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2TEXTLOADER_H__
+#define __GA2TEXTLOADER_H__
+
+#include <stddef.h>
+#include <vector>
+#include "ga2Gene.h"
+
+class ga2Population;
+
+///Loads populations saved in the text format of operator<<, quickly.
+/**
+ * The ga2TextLoader class reads the text written by
+ * operator<<(std::ostream&, ga2Population&) without going through an
+ * istream. The file is mapped with mmap() and numbers are parsed straight
+ * out of the mapping with std::from_chars (or, when built for an older
+ * standard, a small copy and strtod()), into either a ga2Population or a
+ * binary checkpoint file (see ga2Checkpoint).
+ *
+ * The population size at the top of a file is taken as an upper bound
+ * only: a file that was cut short is loaded up to its last complete
+ * chromosome, and anything after the stated number of chromosomes is
+ * ignored. ga2TextLoader::getSize() says how many were actually loaded.
+ * As with operator>>, a fitness of exactly zero is taken to mean the
+ * chromosome was never evaluated.
+ */
+class ga2TextLoader
+{
+	int _fd;
+	const char *_data;
+	size_t _bytes;
+	const char *_body; //first chromosome
+	int _declaredSize;
+	int _size;
+	int _chromoSize;
+	std::vector<float> _chromoMaxRanges;
+	std::vector<float> _chromoMinRanges;
+
+	int _parse(double *fitness, unsigned char *evaluated, ga2Gene *genes);
+
+public:
+	///The constructor.
+	ga2TextLoader();
+	///The destructor. Unmaps the file.
+	virtual ~ga2TextLoader();
+	///Map a text population file and read its header.
+	bool open(const char *path);
+	///Unmap the file.
+	void close(void);
+	///Replace a population with the one in the file.
+	bool load(ga2Population &pop);
+	///Write the population in the file out as a binary checkpoint.
+	bool convert(const char *path, unsigned long generation = 0);
+	///Return the number of chromosomes the file says it holds.
+	int getDeclaredSize(void) {return _declaredSize;};
+	///Return the number of chromosomes loaded by the last load() or convert().
+	int getSize(void) {return _size;};
+	///Return the number of genes per chromosome.
+	int getChromoSize(void) {return _chromoSize;};
+};
+
+#endif
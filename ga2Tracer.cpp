@@ -0,0 +1,299 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Tracer.cpp: implementation of the ga2Tracer class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include "ga2.h"
+
+//how often the writer collects the buffers
+#define GA2_TRACE_INTERVAL_MS 20
+
+static std::atomic<uint64_t> ga2NextTraceSerial(1);
+
+//the buffer the calling thread last recorded into, and which open() of
+//which tracer it belongs to
+struct ga2TraceCache
+{
+	uint64_t serial;
+	void *buffer;
+};
+static thread_local ga2TraceCache ga2TraceLocal = {0, NULL};
+
+static int64_t ga2TraceClock(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//appends s as a JSON string, quotes and all
+static void ga2TraceString(std::string &out, const char *s)
+{
+	out += '"';
+	for(; *s; ++s)
+	{
+		if( (*s == '"') || (*s == '\\') )
+			out += '\\';
+		if((unsigned char)*s >= ' ')
+			out += *s;
+	}
+	out += '"';
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+ga2Tracer::ga2Tracer() : _stop(false), _events(0)
+{
+	_fd = -1;
+	_origin = 0;
+	_serial = 0;
+}
+
+/**
+ * Destructor. Duh.
+ */
+ga2Tracer::~ga2Tracer()
+{
+	close();
+}
+
+/**
+ * \param path The file to write the trace to.
+ *
+ * Starts the background writer. The trace's clock starts at zero here.
+ */
+bool ga2Tracer::open(const char *path)
+{
+	close();
+	_fd = ::open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if(_fd < 0)
+		return false;
+	_origin = ga2TraceClock();
+	_serial = ga2NextTraceSerial++;
+	_events = 0;
+	_first = true;
+	_out.clear();
+	if(::write(_fd, "[", 1) != 1)
+	{
+		::close(_fd);
+		_fd = -1;
+		return false;
+	}
+	_stop = false;
+	_thread = std::thread(&ga2Tracer::_writerLoop, this);
+	return true;
+}
+
+/**
+ * Nothing may be recording when the trace is closed, so detach the tracer
+ * from any population or scheduler first (with a NULL setTracer()), and
+ * let running batches finish.
+ */
+bool ga2Tracer::close(void)
+{
+	if(_fd < 0)
+		return true;
+	{
+		std::lock_guard<std::mutex> l(_sleepLock);
+		_stop = true;
+	}
+	_wake.notify_all();
+	_thread.join();
+	bool ok = _drain();
+	ok = (::write(_fd, "\n]\n", 3) == 3) && ok;
+	ok = (::close(_fd) == 0) && ok;
+	_fd = -1;
+	size_t i;
+	for(i = 0; i < _buffers.size(); ++i)
+		delete _buffers[i];
+	_buffers.clear();
+	return ok;
+}
+
+int64_t ga2Tracer::now(void)
+{
+	return ga2TraceClock() - _origin;
+}
+
+//finds (or makes) the calling thread's buffer. Only the first event a
+//thread records after open() takes the registry lock.
+ga2Tracer::_Buffer *ga2Tracer::_buffer(void)
+{
+	if(ga2TraceLocal.serial == _serial)
+		return (_Buffer *)ga2TraceLocal.buffer;
+	std::lock_guard<std::mutex> l(_buffersLock);
+	std::thread::id self = std::this_thread::get_id();
+	_Buffer *b = NULL;
+	size_t i;
+	for(i = 0; i < _buffers.size(); ++i)
+		if(_buffers[i]->thread == self)
+			b = _buffers[i];
+	if(!b)
+	{
+		b = new _Buffer;
+		b->thread = self;
+		b->tid = _buffers.size() + 1;
+		char name[32];
+		snprintf(name, sizeof(name), "thread %d", b->tid);
+		b->name = name;
+		b->named = false;
+		_buffers.push_back(b);
+	}
+	ga2TraceLocal.serial = _serial;
+	ga2TraceLocal.buffer = b;
+	return b;
+}
+
+void ga2Tracer::_add(const _Event &e)
+{
+	if(_fd < 0)
+		return;
+	_Buffer *b = _buffer();
+	std::lock_guard<std::mutex> l(b->lock);
+	b->events.push_back(e);
+}
+
+/**
+ * \param name What the span was, e.g. "evaluate".
+ * \param category A group of spans that can be filtered on, e.g. "phase".
+ * \param start When it started, from ga2Tracer::now().
+ * \param end When it ended, from ga2Tracer::now().
+ * \param argName The name of a number to attach to the span, or NULL.
+ * \param arg The number.
+ */
+void ga2Tracer::span(const char *name, const char *category, int64_t start, int64_t end,
+					 const char *argName, long arg)
+{
+	_Event e = {name, category, start, end - start, argName, arg};
+	_add(e);
+}
+
+void ga2Tracer::instant(const char *name, const char *category, const char *argName, long arg)
+{
+	_Event e = {name, category, now(), -1, argName, arg};
+	_add(e);
+}
+
+/**
+ * \param name Shown as the title of the calling thread's track.
+ */
+void ga2Tracer::setThreadName(const char *name)
+{
+	if(_fd < 0)
+		return;
+	_Buffer *b = _buffer();
+	std::lock_guard<std::mutex> l(b->lock);
+	b->name = name;
+	b->named = false;
+}
+
+//swaps every thread's events out and writes them. Only ever called by one
+//thread at a time: the writer, or close() once the writer has stopped.
+bool ga2Tracer::_drain(void)
+{
+	std::vector<_Buffer *> buffers;
+	{
+		std::lock_guard<std::mutex> l(_buffersLock);
+		buffers = _buffers;
+	}
+	int pid = getpid();
+	char num[128];
+	std::vector<_Event> events;
+	size_t i, j;
+	for(i = 0; i < buffers.size(); ++i)
+	{
+		_Buffer *b = buffers[i];
+		std::string name;
+		bool rename;
+		events.clear();
+		{
+			std::lock_guard<std::mutex> l(b->lock);
+			events.swap(b->events);
+			rename = !b->named;
+			name = b->name;
+			b->named = true;
+		}
+		if(rename)
+		{
+			if(!_first)
+				_out += ',';
+			_first = false;
+			snprintf(num, sizeof(num), "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+					 pid, b->tid);
+			_out += num;
+			ga2TraceString(_out, name.c_str());
+			_out += "}}";
+		}
+		for(j = 0; j < events.size(); ++j)
+		{
+			const _Event &e = events[j];
+			if(!_first)
+				_out += ',';
+			_first = false;
+			_out += "\n{\"name\":";
+			ga2TraceString(_out, e.name);
+			_out += ",\"cat\":";
+			ga2TraceString(_out, e.category);
+			if(e.duration >= 0)
+				snprintf(num, sizeof(num), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d",
+						 e.start / 1000.0, e.duration / 1000.0, pid, b->tid);
+			else
+				snprintf(num, sizeof(num), ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+						 e.start / 1000.0, pid, b->tid);
+			_out += num;
+			if(e.argName)
+			{
+				_out += ",\"args\":{";
+				ga2TraceString(_out, e.argName);
+				snprintf(num, sizeof(num), ":%ld}", e.arg);
+				_out += num;
+			}
+			_out += '}';
+		}
+		_events += events.size();
+	}
+
+	size_t done = 0;
+	while(done < _out.size())
+	{
+		ssize_t n = ::write(_fd, _out.data() + done, _out.size() - done);
+		if(n <= 0)
+			break;
+		done += n;
+	}
+	bool ok = done == _out.size();
+	_out.clear();
+	return ok;
+}
+
+void ga2Tracer::_writerLoop(void)
+{
+	while(!_stop)
+	{
+		_drain();
+		std::unique_lock<std::mutex> l(_sleepLock);
+		if(!_stop)
+			_wake.wait_for(l, std::chrono::milliseconds(GA2_TRACE_INTERVAL_MS));
+	}
+}
@@ -0,0 +1,146 @@
+// ga2 - C++ genetic algorithm library
+// Copyright (C) 2001 Donald E. Goodman
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// ga2Tracer.h: interface for the ga2Tracer class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __GA2TRACER_H__
+#define __GA2TRACER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+///Writes a timeline of a run as a Chrome trace.
+/**
+ * The ga2Tracer class records spans of time (a generation, each phase of
+ * it, each chunk of evaluations a ga2Scheduler worker runs, the wait for a
+ * batch to finish) and writes them as Chrome Trace Event JSON, which can
+ * be loaded into chrome://tracing or https://ui.perfetto.dev. Each thread
+ * gets its own track, so idle workers and the tail of each generation
+ * show up as gaps.
+ *
+ * Every thread records into a buffer of its own, so recording never
+ * waits on another thread. A background thread swaps the buffers out
+ * every few milliseconds, formats them and writes them to the file.
+ * The file is written in the JSON array form, which the viewers accept
+ * even without its closing bracket, so a trace cut short by a crash can
+ * still be read.
+ *
+ * Hand a tracer to ga2Population::setTracer() and
+ * ga2Scheduler::setTracer(), or record spans of your own with
+ * ga2Tracer::span(). Names and categories must be string literals or
+ * otherwise outlive the tracer, because they are written out later.
+ */
+class ga2Tracer
+{
+	struct _Event
+	{
+		const char *name;
+		const char *category;
+		int64_t start; //nanoseconds since open()
+		int64_t duration; //-1 for an instant
+		const char *argName;
+		long arg;
+	};
+	struct _Buffer
+	{
+		std::mutex lock;
+		std::vector<_Event> events;
+		std::thread::id thread;
+		int tid;
+		std::string name;
+		bool named; //written out to the file
+	};
+
+	int _fd;
+	int64_t _origin;
+	uint64_t _serial; //tells one open() from another in thread local caches
+	std::mutex _buffersLock;
+	std::vector<_Buffer *> _buffers;
+	std::atomic<bool> _stop;
+	std::mutex _sleepLock;
+	std::condition_variable _wake;
+	std::thread _thread;
+	std::atomic<long> _events;
+	bool _first; //no event written yet, so none needs a comma
+	std::string _out;
+
+	_Buffer *_buffer(void);
+	void _writerLoop(void);
+	bool _drain(void);
+	void _add(const _Event &e);
+
+public:
+	///The constructor.
+	ga2Tracer();
+	///The destructor. Writes out everything recorded and closes the file.
+	virtual ~ga2Tracer();
+	///Start tracing to a file, truncating it.
+	bool open(const char *path);
+	///Write out everything recorded, stop the writer and close the file.
+	bool close(void);
+	///Is a trace open?
+	bool isOpen(void) {return _fd >= 0;};
+	///Return the current time on the trace's clock, in nanoseconds.
+	int64_t now(void);
+	///Record a span of time on the calling thread's track.
+	void span(const char *name, const char *category, int64_t start, int64_t end,
+			  const char *argName = NULL, long arg = 0);
+	///Record an instant on the calling thread's track.
+	void instant(const char *name, const char *category, const char *argName = NULL, long arg = 0);
+	///Name the calling thread's track.
+	void setThreadName(const char *name);
+	///Return the number of events written so far.
+	long getEventCount(void) {return _events.load();};
+};
+
+///Records a span for as long as it is in scope.
+/**
+ * Does nothing at all if given a NULL tracer.
+ */
+class ga2TraceScope
+{
+	ga2Tracer *_tracer;
+	const char *_name;
+	const char *_category;
+	const char *_argName;
+	long _arg;
+	int64_t _start;
+public:
+	ga2TraceScope(ga2Tracer *tracer, const char *name, const char *category,
+				  const char *argName = NULL, long arg = 0)
+		: _tracer(tracer), _name(name), _category(category), _argName(argName), _arg(arg), _start(0)
+	{
+		if(_tracer)
+			_start = _tracer->now();
+	};
+	~ga2TraceScope() {end();};
+	///Stop recording before going out of scope.
+	void end(void)
+	{
+		if(_tracer)
+			_tracer->span(_name, _category, _start, _tracer->now(), _argName, _arg);
+		_tracer = NULL;
+	};
+};
+
+#endif